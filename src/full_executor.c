@@ -20,6 +20,7 @@
 
 #include "full_executor.h"
 #include "runtime_loader.h"
+#include "run_many.h"
 #include "zym/zym.h"
 #include "zym/module_loader.h"
 #include "zym/debug.h"
@@ -52,6 +53,10 @@ static void print_banner(void) {
     printf("  |    zym <file.zym> -o <out.exe>   Compile to standalone exe        |\n");
     printf("  |    zym <file.zbc> -o <out.exe>   Pack bytecode into exe           |\n");
     printf("  |                                                                   |\n");
+    printf("  |  Multiple Programs:                                               |\n");
+    printf("  |    zym run-many <a.zbc> <b.zbc>  Run in one process, round-robin  |\n");
+    printf("  |        [--slice N] [-j N]        Slices per turn, worker threads  |\n");
+    printf("  |                                                                   |\n");
     printf("  |  Cross-Platform Packing:                                          |\n");
     printf("  |    zym <file> -o <out> -r <runtime>  Use explicit runtime binary  |\n");
     printf("  |                                                                   |\n");
@@ -567,6 +572,10 @@ int full_main(int argc, char** argv, ZymAllocator* allocator) {
         return 0;
     }
 
+    if (argc >= 2 && strcmp(argv[1], "run-many") == 0) {
+        return run_many_main(argc - 2, argv + 2, allocator);
+    }
+
     // Find the "--" delimiter that separates zym flags from script args
     int delimiter_index = -1;
     for (int i = 2; i < argc; i++) {
@@ -3,36 +3,432 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
 #include "./natives.h"
+#include "./buffer.h"
 #include "./marshal.h"
+#include "./thread.h"
 #include "zym/module_loader.h"
 
 void setupNatives(ZymVM* vm);
 
+#define ZYMVM_MAX_ARGS 16
+
+// One callAsync() request. Shared by the worker thread and the handle
+// object, and freed by whichever lets go of it last.
+typedef struct {
+    Mutex lock;
+    CondVar done_cond;
+    int refs;
+
+    char* name;
+    int argc;
+    MarshalBlob args;       // argc packed values, back to back
+    int batch;              // > 0: `batch` one-argument calls, results packed in order
+
+    bool done;
+    bool ok;
+    MarshalBlob result;
+} AsyncCall;
+
+// ---- Memory quotas ---------------------------------------------------------------
+// Every nested VM allocates through a counting allocator, so its heap usage
+// is always known and can be capped. A limit of 0 means unlimited. Quotas
+// form a tree that mirrors VM nesting: whatever a nested VM allocates is
+// also charged to the quota of the VM that created it, and so on up, so a
+// limited VM's children share its budget instead of each getting a copy.
+// Exceeding any limit on the way up fails that allocation inside the nested
+// VM and sets a flag that the parent reports as a runtime error after the
+// call.
+//
+// Buffer storage is malloc'd by the Buffer natives rather than the VM, so it
+// is charged separately. Each thread remembers the quota of the nested VM it
+// last entered; a Buffer native charges the first quota on that chain that
+// belongs to its own VM, and VMs outside any limited tree charge nothing.
+
 typedef struct {
+    size_t max;
+    atomic_size_t used;
+    atomic_size_t peak;
+    atomic_bool exceeded;
+    atomic_size_t exceeded_limit;   // the limit that was hit, possibly an ancestor's
+} QuotaCounter;
+
+typedef struct MemoryQuota {
+    _Atomic(ZymVM*) vm;             // NULL once settled; read by threads running below it
+    ZymAllocator allocator;
+    QuotaCounter heap;
+    QuotaCounter buffer;
+    struct MemoryQuota* parent;     // quota of the VM that created this one, if any
+
+    // A child holds a reference on its parent, since a child torn down by
+    // its async worker can outlive the parent's VM, and a thread holds one
+    // on the quota it has entered, so the chain quota_for() walks stays
+    // allocated until that thread leaves. Once settled a quota no longer
+    // passes charges up: its ancestors have already forgotten it.
+    atomic_int refs;
+    atomic_bool settled;
+} MemoryQuota;
+
+typedef enum {
+    QUOTA_HEAP,
+    QUOTA_BUFFER
+} QuotaKind;
+
+static THREAD_LOCAL MemoryQuota* quota_active;
+
+static QuotaCounter* quota_counter(MemoryQuota* quota, QuotaKind kind) {
+    return kind == QUOTA_HEAP ? &quota->heap : &quota->buffer;
+}
+
+static bool counter_reserve(QuotaCounter* counter, size_t bytes) {
+    size_t now = atomic_fetch_add(&counter->used, bytes) + bytes;
+    if (counter->max > 0 && now > counter->max) {
+        atomic_fetch_sub(&counter->used, bytes);
+        return false;
+    }
+    size_t seen = atomic_load(&counter->peak);
+    while (now > seen && !atomic_compare_exchange_weak(&counter->peak, &seen, now)) {
+    }
+    return true;
+}
+
+// Clamped at zero: storage that reached a Buffer by a path that was never
+// charged may still be released
+static void counter_unreserve(QuotaCounter* counter, size_t bytes) {
+    size_t seen = atomic_load(&counter->used);
+    size_t next;
+    do {
+        next = seen > bytes ? seen - bytes : 0;
+    } while (!atomic_compare_exchange_weak(&counter->used, &seen, next));
+}
+
+// The next quota up the chain that still tracks `level`
+static MemoryQuota* quota_up(MemoryQuota* level) {
+    return atomic_load(&level->settled) ? NULL : level->parent;
+}
+
+// Charges `quota` and every ancestor. On failure nothing stays charged.
+static bool quota_reserve(MemoryQuota* quota, QuotaKind kind, size_t bytes) {
+    for (MemoryQuota* level = quota; level; level = quota_up(level)) {
+        if (!counter_reserve(quota_counter(level, kind), bytes)) {
+            for (MemoryQuota* undo = quota; undo != level; undo = quota_up(undo)) {
+                counter_unreserve(quota_counter(undo, kind), bytes);
+            }
+            QuotaCounter* counter = quota_counter(quota, kind);
+            atomic_store(&counter->exceeded_limit, quota_counter(level, kind)->max);
+            atomic_store(&counter->exceeded, true);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void quota_unreserve(MemoryQuota* quota, QuotaKind kind, size_t bytes) {
+    for (MemoryQuota* level = quota; level; level = quota_up(level)) {
+        counter_unreserve(quota_counter(level, kind), bytes);
+    }
+}
+
+static void* quota_alloc(void* ctx, size_t size) {
+    MemoryQuota* quota = (MemoryQuota*)ctx;
+    if (!quota_reserve(quota, QUOTA_HEAP, size)) {
+        return NULL;
+    }
+    void* ptr = malloc(size);
+    if (!ptr) {
+        quota_unreserve(quota, QUOTA_HEAP, size);
+    }
+    return ptr;
+}
+
+static void* quota_calloc(void* ctx, size_t count, size_t size) {
+    MemoryQuota* quota = (MemoryQuota*)ctx;
+    if (size > 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    if (!quota_reserve(quota, QUOTA_HEAP, count * size)) {
+        return NULL;
+    }
+    void* ptr = calloc(count, size);
+    if (!ptr) {
+        quota_unreserve(quota, QUOTA_HEAP, count * size);
+    }
+    return ptr;
+}
+
+static void* quota_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    MemoryQuota* quota = (MemoryQuota*)ctx;
+    if (new_size > old_size && !quota_reserve(quota, QUOTA_HEAP, new_size - old_size)) {
+        return NULL;
+    }
+    void* result = realloc(ptr, new_size);
+    if (!result && new_size > 0) {
+        if (new_size > old_size) {
+            quota_unreserve(quota, QUOTA_HEAP, new_size - old_size);
+        }
+        return NULL;
+    }
+    if (new_size < old_size) {
+        quota_unreserve(quota, QUOTA_HEAP, old_size - new_size);
+    }
+    return result;
+}
+
+static void quota_free(void* ctx, void* ptr, size_t size) {
+    MemoryQuota* quota = (MemoryQuota*)ctx;
+    free(ptr);
+    quota_unreserve(quota, QUOTA_HEAP, size);
+}
+
+static MemoryQuota* quota_new(size_t max_heap, size_t max_buffer, MemoryQuota* parent) {
+    MemoryQuota* quota = calloc(1, sizeof(MemoryQuota));
+    if (!quota) return NULL;
+    quota->heap.max = max_heap;
+    quota->buffer.max = max_buffer;
+    quota->parent = parent;
+    atomic_init(&quota->refs, 1);
+    if (parent) {
+        atomic_fetch_add(&parent->refs, 1);
+    }
+    quota->allocator = (ZymAllocator){
+        .alloc   = quota_alloc,
+        .calloc  = quota_calloc,
+        .realloc = quota_realloc,
+        .free    = quota_free,
+        .ctx     = quota
+    };
+    return quota;
+}
+
+// Called once the quota's VM has been freed. Anything still counted (a
+// Buffer released on a path that never found this quota, say) is taken
+// back off the ancestors so it doesn't eat into their budget forever.
+static void quota_settle(MemoryQuota* quota) {
+    atomic_store(&quota->settled, true);
+    size_t heap = atomic_exchange(&quota->heap.used, 0);
+    size_t buffer = atomic_exchange(&quota->buffer.used, 0);
+    if (quota->parent) {
+        quota_unreserve(quota->parent, QUOTA_HEAP, heap);
+        quota_unreserve(quota->parent, QUOTA_BUFFER, buffer);
+    }
+    atomic_store(&quota->vm, NULL);
+}
+
+static void quota_release(MemoryQuota* quota) {
+    while (quota && atomic_fetch_sub(&quota->refs, 1) == 1) {
+        MemoryQuota* parent = quota->parent;
+        free(quota);
+        quota = parent;
+    }
+}
+
+// Marks quota as the one this thread is now running on behalf of and
+// returns the one it replaces. Every enter is paired with a quota_leave()
+// on the same thread before the code that entered returns, so a thread
+// never keeps pointing at a quota that another thread may free. The
+// reference taken here keeps quota and its ancestors alive until then,
+// even if the VM that owns it is torn down on another thread meanwhile.
+static MemoryQuota* quota_enter(MemoryQuota* quota) {
+    if (quota) {
+        atomic_fetch_add(&quota->refs, 1);
+    }
+    MemoryQuota* outer = quota_active;
+    quota_active = quota;
+    return outer;
+}
+
+static void quota_leave(MemoryQuota* outer) {
+    MemoryQuota* quota = quota_active;
+    quota_active = outer;
+    quota_release(quota);
+}
+
+// The quota of `vm` when it is the nested VM this thread is running on
+// behalf of or one of the VMs above it; NULL for VMs outside any quota tree
+static MemoryQuota* quota_for(ZymVM* vm) {
+    for (MemoryQuota* quota = quota_active; quota; quota = quota->parent) {
+        if (atomic_load(&quota->vm) == vm) {
+            return quota;
+        }
+    }
+    return NULL;
+}
+
+struct MemoryQuota* zymvm_quota_current(void) {
+    return quota_active;
+}
+
+struct MemoryQuota* zymvm_quota_adopt(struct MemoryQuota* quota) {
+    return quota_enter(quota);
+}
+
+void zymvm_quota_restore(struct MemoryQuota* outer) {
+    quota_leave(outer);
+}
+
+bool zymvm_quota_try_charge_buffer(ZymVM* vm, size_t bytes) {
+    MemoryQuota* quota = quota_for(vm);
+    return !quota || bytes == 0 || quota_reserve(quota, QUOTA_BUFFER, bytes);
+}
+
+bool zymvm_quota_charge_buffer(ZymVM* vm, size_t bytes) {
+    if (!zymvm_quota_try_charge_buffer(vm, bytes)) {
+        MemoryQuota* quota = quota_for(vm);
+        zym_runtimeError(vm, "Buffer quota exceeded: %zu more bytes would pass the %zu byte limit",
+                         bytes, atomic_load(&quota->buffer.exceeded_limit));
+        return false;
+    }
+    return true;
+}
+
+void zymvm_quota_release_buffer(ZymVM* vm, size_t bytes) {
+    MemoryQuota* quota = quota_for(vm);
+    if (quota && bytes > 0) {
+        quota_unreserve(quota, QUOTA_BUFFER, bytes);
+    }
+}
+
+typedef struct VMData VMData;
+
+// getFunction() handle. Checked once when it is created, then called without
+// re-validating the name. Linked into its VMData so the VM's cleanup can
+// detach it if the handle outlives the ZymVM object.
+typedef struct FunctionHandle {
+    VMData* vmdata;
+    char* name;
+    int arity;
+    struct FunctionHandle* next;
+} FunctionHandle;
+
+struct VMData {
     ZymVM* vm;
     bool loaded;
     ZymValue last_result;
     bool has_result;
-} VMData;
 
-void zymvm_cleanup(ZymVM* vm, void* ptr) {
-    VMData* vmdata = (VMData*)ptr;
+    // Worker thread that runs callAsync() jobs. It owns the nested VM from
+    // the moment a job is handed over until the job completes; every other
+    // method refuses to touch the VM while `busy` is set.
+    ThreadHandle worker;
+    bool worker_started;
+    Mutex lock;
+    CondVar wake;
+    AsyncCall* job;
+    bool busy;
+    bool stopping;
+
+    FunctionHandle* handles;
+
+    MemoryQuota* quota;
+
+    // run() stopped at a yield with its budget spent; only resume() and
+    // end() may touch the VM until it finishes
+    bool suspended;
+    char* suspended_name;
+};
+
+static void async_call_release(AsyncCall* call) {
+    mutex_lock(&call->lock);
+    bool last = --call->refs == 0;
+    mutex_unlock(&call->lock);
+    if (!last) {
+        return;
+    }
+    mutex_destroy(&call->lock);
+    condvar_destroy(&call->done_cond);
+    free(call->name);
+    marshal_blob_free(&call->args);
+    marshal_blob_free(&call->result);
+    free(call);
+}
+
+// Frees the nested VM and everything behind a ZymVM object. Runs on the
+// finaliser's thread, or on the async worker once it has been told to stop.
+static void zymvm_destroy(VMData* vmdata) {
+    mutex_destroy(&vmdata->lock);
+    condvar_destroy(&vmdata->wake);
     if (vmdata->vm) {
+        // Buffers freed with the VM release their charges to its quota
+        MemoryQuota* outer = quota_enter(vmdata->quota);
         zym_freeVM(vmdata->vm);
+        quota_leave(outer);
         vmdata->vm = NULL;
     }
+    quota_settle(vmdata->quota);
+    quota_release(vmdata->quota);
+    free(vmdata->suspended_name);
     free(vmdata);
 }
 
-typedef struct {
-    uint8_t* data;
-    size_t capacity;
-    size_t length;
-    size_t position;
-    bool auto_grow;
-    int endianness;
-} BufferData;
+void zymvm_cleanup(ZymVM* vm, void* ptr) {
+    VMData* vmdata = (VMData*)ptr;
+    for (FunctionHandle* handle = vmdata->handles; handle; handle = handle->next) {
+        handle->vmdata = NULL;
+    }
+    if (vmdata->worker_started) {
+        // A finaliser must not block on a running job: the worker finishes
+        // it and then destroys the VM itself
+        ThreadHandle worker = vmdata->worker;
+        mutex_lock(&vmdata->lock);
+        vmdata->stopping = true;
+        condvar_signal(&vmdata->wake);
+        mutex_unlock(&vmdata->lock);
+        thread_detach(worker);
+        return;
+    }
+    zymvm_destroy(vmdata);
+}
+
+// Synchronous methods run on the caller's thread, so they must not race a
+// callAsync() job that is still using the nested VM. Every such method
+// starts here, so this is also where quota hits left over from earlier
+// operations are forgotten. Methods enter the VM's quota themselves, only
+// around the work they do in the nested VM.
+static bool zymvm_ensure_idle(ZymVM* parent_vm, VMData* vmdata) {
+    mutex_lock(&vmdata->lock);
+    bool busy = vmdata->busy;
+    mutex_unlock(&vmdata->lock);
+    if (busy) {
+        zym_runtimeError(parent_vm, "ZymVM is busy with an async call; wait for it first");
+        return false;
+    }
+    if (vmdata->suspended) {
+        zym_runtimeError(parent_vm, "ZymVM has a suspended run(); resume() it first");
+        return false;
+    }
+    atomic_store(&vmdata->quota->heap.exceeded, false);
+    atomic_store(&vmdata->quota->buffer.exceeded, false);
+    return true;
+}
+
+// Runs a started call or chunk to the end. The VM yields when its
+// instruction slice runs out; methods without a budget just keep going.
+static ZymStatus zymvm_complete(ZymVM* vm, ZymStatus status) {
+    while (status == ZYM_STATUS_YIELD) {
+        status = zym_resume(vm);
+    }
+    return status;
+}
+
+// Raises the error for a quota the nested VM ran into during the last
+// operation, if any. Returns true when one was raised.
+static bool zymvm_report_quota(ZymVM* parent_vm, VMData* vmdata) {
+    MemoryQuota* quota = vmdata->quota;
+    if (atomic_exchange(&quota->heap.exceeded, false)) {
+        atomic_store(&quota->buffer.exceeded, false);
+        zym_runtimeError(parent_vm, "Out of memory: ZymVM exceeded its heap quota of %zu bytes",
+                         atomic_load(&quota->heap.exceeded_limit));
+        return true;
+    }
+    if (atomic_exchange(&quota->buffer.exceeded, false)) {
+        zym_runtimeError(parent_vm, "Out of memory: ZymVM exceeded its buffer quota of %zu bytes",
+                         atomic_load(&quota->buffer.exceeded_limit));
+        return true;
+    }
+    return false;
+}
 
 static char* zymvm_read_file(const char* path, size_t* out_size) {
     FILE* file = fopen(path, "rb");
@@ -72,18 +468,205 @@ static ModuleReadResult zymvm_module_read_callback(const char* path, void* user_
     return result;
 }
 
+// ---- Compilation -----------------------------------------------------------------
+// Compiled bytecode is cached process-wide, keyed by the source's hash and
+// the path it was compiled as. Sources that import other modules are never
+// cached, since those files can change underneath an unchanged entry source.
+// Compilation itself runs on a pooled VM that already has its natives set
+// up, so a cache miss does not pay for a fresh VM either.
+
+#define COMPILE_CACHE_BUCKETS 256
+#define COMPILE_CACHE_MAX_BYTES (32 * 1024 * 1024)
+#define COMPILER_POOL_MAX 4
+
+typedef struct CompileCacheEntry {
+    uint64_t hash;
+    size_t source_length;
+    char* source;
+    char* path;
+    char* bytecode;
+    size_t bytecode_size;
+    struct CompileCacheEntry* next;
+} CompileCacheEntry;
+
+static Mutex compile_lock = MUTEX_INITIALIZER;
+static CompileCacheEntry* compile_cache[COMPILE_CACHE_BUCKETS];
+static size_t compile_cache_bytes = 0;
+static ZymVM* compiler_pool[COMPILER_POOL_MAX];
+static int compiler_pool_count = 0;
+static bool compiler_pool_registered = false;
+// Set by the exit hook. Compiles still running on other threads then free
+// their own VM and skip the cache instead of handing either back.
+static bool compiler_pool_closed = false;
+
+static uint64_t compile_hash(const char* source, size_t length, const char* path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)source[i]) * 1099511628211ULL;
+    }
+    for (const char* p = path; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void compile_cache_free_entry(CompileCacheEntry* entry) {
+    free(entry->source);
+    free(entry->path);
+    free(entry->bytecode);
+    free(entry);
+}
+
+// Caller holds compile_lock
+static void compile_cache_clear_locked(void) {
+    for (int i = 0; i < COMPILE_CACHE_BUCKETS; i++) {
+        CompileCacheEntry* entry = compile_cache[i];
+        while (entry) {
+            CompileCacheEntry* next = entry->next;
+            compile_cache_free_entry(entry);
+            entry = next;
+        }
+        compile_cache[i] = NULL;
+    }
+    compile_cache_bytes = 0;
+}
+
+// Returns a malloc'd copy of the cached bytecode, or NULL on a miss
+static char* compile_cache_lookup(uint64_t hash, const char* source, size_t length, const char* path, size_t* out_size) {
+    char* bytecode = NULL;
+    mutex_lock(&compile_lock);
+    for (CompileCacheEntry* entry = compile_cache[hash % COMPILE_CACHE_BUCKETS]; entry; entry = entry->next) {
+        if (entry->hash == hash && entry->source_length == length &&
+            strcmp(entry->path, path) == 0 && memcmp(entry->source, source, length) == 0) {
+            bytecode = malloc(entry->bytecode_size);
+            if (bytecode) {
+                memcpy(bytecode, entry->bytecode, entry->bytecode_size);
+                *out_size = entry->bytecode_size;
+            }
+            break;
+        }
+    }
+    mutex_unlock(&compile_lock);
+    return bytecode;
+}
+
+// Best effort: a failed allocation just leaves the source uncached. When the
+// cache would outgrow its budget it is emptied and starts over.
+static void compile_cache_store(uint64_t hash, const char* source, size_t length, const char* path, const char* bytecode, size_t bytecode_size) {
+    size_t cost = length + bytecode_size;
+    if (cost > COMPILE_CACHE_MAX_BYTES) {
+        return;
+    }
+
+    CompileCacheEntry* entry = calloc(1, sizeof(CompileCacheEntry));
+    if (!entry) return;
+    entry->hash = hash;
+    entry->source_length = length;
+    entry->source = malloc(length > 0 ? length : 1);
+    entry->path = strdup(path);
+    entry->bytecode = malloc(bytecode_size > 0 ? bytecode_size : 1);
+    entry->bytecode_size = bytecode_size;
+    if (!entry->source || !entry->path || !entry->bytecode) {
+        compile_cache_free_entry(entry);
+        return;
+    }
+    memcpy(entry->source, source, length);
+    memcpy(entry->bytecode, bytecode, bytecode_size);
+
+    mutex_lock(&compile_lock);
+    if (compiler_pool_closed) {
+        mutex_unlock(&compile_lock);
+        compile_cache_free_entry(entry);
+        return;
+    }
+    if (compile_cache_bytes + cost > COMPILE_CACHE_MAX_BYTES) {
+        compile_cache_clear_locked();
+    }
+    CompileCacheEntry** bucket = &compile_cache[hash % COMPILE_CACHE_BUCKETS];
+    entry->next = *bucket;
+    *bucket = entry;
+    compile_cache_bytes += cost;
+    mutex_unlock(&compile_lock);
+}
+
+// Frees the pooled compiler VMs and the cache at exit. A pooled VM is idle
+// by definition; VMs in use by a compile belong to that compile until it
+// releases them.
+static void compiler_pool_teardown(void) {
+    ZymVM* pooled[COMPILER_POOL_MAX];
+    mutex_lock(&compile_lock);
+    compiler_pool_closed = true;
+    int count = compiler_pool_count;
+    memcpy(pooled, compiler_pool, sizeof(ZymVM*) * (size_t)count);
+    compiler_pool_count = 0;
+    compile_cache_clear_locked();
+    mutex_unlock(&compile_lock);
+
+    for (int i = 0; i < count; i++) {
+        zym_freeVM(pooled[i]);
+    }
+}
+
+static ZymVM* compiler_acquire(void) {
+    ZymVM* vm = NULL;
+    mutex_lock(&compile_lock);
+    if (compiler_pool_count > 0) {
+        vm = compiler_pool[--compiler_pool_count];
+    }
+    mutex_unlock(&compile_lock);
+
+    if (!vm) {
+        vm = zym_newVM(NULL);
+        if (vm) {
+            setupNatives(vm);
+        }
+    }
+    return vm;
+}
+
+// A VM whose compile failed is not reused: it may hold half-loaded modules
+// or error state from the failed run.
+static void compiler_release(ZymVM* vm, bool reusable) {
+    mutex_lock(&compile_lock);
+    if (!compiler_pool_registered && !compiler_pool_closed) {
+        compiler_pool_registered = atexit(compiler_pool_teardown) == 0;
+    }
+    // Without the exit hook nothing would free a pooled VM
+    if (reusable && compiler_pool_registered && !compiler_pool_closed &&
+        compiler_pool_count < COMPILER_POOL_MAX) {
+        compiler_pool[compiler_pool_count++] = vm;
+        vm = NULL;
+    }
+    mutex_unlock(&compile_lock);
+
+    if (vm) {
+        zym_freeVM(vm);
+    }
+}
+
+// zym_freeLineMap() releases the map's contents; the map itself is ours
+static void compiler_free_line_map(ZymVM* vm, ZymLineMap* line_map) {
+    zym_freeLineMap(vm, line_map);
+    free((void*)line_map);
+}
+
 static char* zymvm_compile_source_internal(ZymVM* parent_vm, const char* source, const char* file_path, size_t* out_size) {
-    ZymVM* compile_vm = zym_newVM(NULL);
-    if (!compile_vm) return NULL;
+    size_t source_length = strlen(source);
+    uint64_t hash = compile_hash(source, source_length, file_path);
+    char* cached = compile_cache_lookup(hash, source, source_length, file_path, out_size);
+    if (cached) {
+        return cached;
+    }
 
-    setupNatives(compile_vm);
+    ZymVM* compile_vm = compiler_acquire();
+    if (!compile_vm) return NULL;
 
     ZymLineMap* line_map = zym_newLineMap(compile_vm);
     const char* processed_source = NULL;
 
     if (zym_preprocess(compile_vm, source, line_map, &processed_source) != ZYM_STATUS_OK) {
-        zym_freeLineMap(compile_vm, line_map);
-        zym_freeVM(compile_vm);
+        compiler_free_line_map(compile_vm, line_map);
+        compiler_release(compile_vm, false);
         return NULL;
     }
 
@@ -93,52 +676,64 @@ static char* zymvm_compile_source_internal(ZymVM* parent_vm, const char* source,
 
     if (module_result->has_error) {
         freeModuleLoadResult(compile_vm, module_result);
-        zym_freeLineMap(compile_vm, line_map);
-        zym_freeVM(compile_vm);
+        zym_freeProcessedSource(compile_vm, processed_source);
+        compiler_free_line_map(compile_vm, line_map);
+        compiler_release(compile_vm, false);
         return NULL;
     }
 
     ZymChunk* chunk = zym_newChunk(compile_vm);
     ZymCompilerConfig config = { .include_line_info = 1 };
     const char* entry_file = module_result->module_count > 0 ? module_result->module_paths[0] : file_path;
+    bool cacheable = module_result->module_count <= 1;
 
     if (zym_compile(compile_vm, module_result->combined_source, chunk, module_result->line_map, entry_file, config) != ZYM_STATUS_OK) {
         freeModuleLoadResult(compile_vm, module_result);
+        zym_freeProcessedSource(compile_vm, processed_source);
         zym_freeChunk(compile_vm, chunk);
-        zym_freeLineMap(compile_vm, line_map);
-        zym_freeVM(compile_vm);
+        compiler_free_line_map(compile_vm, line_map);
+        compiler_release(compile_vm, false);
         return NULL;
     }
 
     freeModuleLoadResult(compile_vm, module_result);
+    zym_freeProcessedSource(compile_vm, processed_source);
 
     char* bytecode = NULL;
     size_t bytecode_size = 0;
     if (zym_serializeChunk(compile_vm, config, chunk, &bytecode, &bytecode_size) != ZYM_STATUS_OK) {
         zym_freeChunk(compile_vm, chunk);
-        zym_freeLineMap(compile_vm, line_map);
-        zym_freeVM(compile_vm);
+        compiler_free_line_map(compile_vm, line_map);
+        compiler_release(compile_vm, false);
         return NULL;
     }
 
     zym_freeChunk(compile_vm, chunk);
-    zym_freeLineMap(compile_vm, line_map);
-    zym_freeVM(compile_vm);
+    compiler_free_line_map(compile_vm, line_map);
+    compiler_release(compile_vm, true);
+
+    if (cacheable) {
+        compile_cache_store(hash, source, source_length, file_path, bytecode, bytecode_size);
+    }
 
     *out_size = bytecode_size;
     return bytecode;
 }
 
+ZymValue nativeZymVM_clearCompileCache(ZymVM* vm) {
+    mutex_lock(&compile_lock);
+    compile_cache_clear_locked();
+    mutex_unlock(&compile_lock);
+    return zym_newNull();
+}
+
 static ZymValue zymvm_bytecode_to_buffer(ZymVM* vm, const char* bytecode, size_t bytecode_size) {
     ZymValue sizeVal = zym_newNumber((double)bytecode_size);
     ZymValue autoGrow = zym_newBool(false);
     ZymValue bufObj = nativeBuffer_create(vm, sizeVal, autoGrow);
     if (bufObj == ZYM_ERROR) return ZYM_ERROR;
 
-    ZymValue getLength = zym_mapGet(vm, bufObj, "getLength");
-    if (zym_isNull(getLength)) return ZYM_ERROR;
-    ZymValue bufContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufContext);
+    BufferData* buf = buffer_from_value(vm, bufObj);
     if (!buf) return ZYM_ERROR;
 
     memcpy(buf->data, bytecode, bytecode_size);
@@ -148,52 +743,62 @@ static ZymValue zymvm_bytecode_to_buffer(ZymVM* vm, const char* bytecode, size_t
     return bufObj;
 }
 
+// Deserializes a chunk into the nested VM and runs its top level. False
+// when the bytecode is rejected or fails to run.
+static ZymValue zymvm_run_bytecode(ZymVM* parent_vm, VMData* vmdata, const char* bytecode, size_t bytecode_size) {
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    ZymValue result = zym_newBool(false);
+
+    ZymChunk* chunk = zym_newChunk(vmdata->vm);
+    if (!chunk) {
+        zym_runtimeError(parent_vm, "Failed to create chunk");
+        result = ZYM_ERROR;
+    } else if (zym_deserializeChunk(vmdata->vm, chunk, bytecode, bytecode_size) != ZYM_STATUS_OK) {
+        zym_freeChunk(vmdata->vm, chunk);
+    } else if (zymvm_complete(vmdata->vm, zym_runChunk(vmdata->vm, chunk)) != ZYM_STATUS_OK) {
+        if (zymvm_report_quota(parent_vm, vmdata)) {
+            result = ZYM_ERROR;
+        }
+    } else {
+        vmdata->loaded = true;
+        result = zym_newBool(true);
+    }
+
+    quota_leave(outer);
+    return result;
+}
+
 ZymValue zymvm_load(ZymVM* parent_vm, ZymValue context, ZymValue bufferVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
-    if (!zym_isMap(bufferVal)) {
-        zym_runtimeError(parent_vm, "load() requires a Buffer argument");
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(parent_vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
-        zym_runtimeError(parent_vm, "Invalid Buffer object");
+    if (!zym_isMap(bufferVal)) {
+        zym_runtimeError(parent_vm, "load() requires a Buffer argument");
         return ZYM_ERROR;
     }
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
+    BufferData* buf = buffer_from_value(parent_vm, bufferVal);
     if (!buf) {
-        zym_runtimeError(parent_vm, "Failed to get buffer data");
+        zym_runtimeError(parent_vm, "Invalid Buffer object");
         return ZYM_ERROR;
     }
-
-    ZymChunk* chunk = zym_newChunk(vmdata->vm);
-    if (!chunk) {
-        zym_runtimeError(parent_vm, "Failed to create chunk");
+    if (!buffer_check_readable(parent_vm, buf)) {
         return ZYM_ERROR;
     }
 
-    ZymStatus status = zym_deserializeChunk(vmdata->vm, chunk, (const char*)buf->data, buf->length);
-    if (status != ZYM_STATUS_OK) {
-        zym_freeChunk(vmdata->vm, chunk);
-        return zym_newBool(false);
-    }
-
-    status = zym_runChunk(vmdata->vm, chunk);
-
-    if (status != ZYM_STATUS_OK) {
-        return zym_newBool(false);
-    }
-
-    vmdata->loaded = true;
-    return zym_newBool(true);
+    return zymvm_run_bytecode(parent_vm, vmdata, (const char*)buf->data, buf->length);
 }
 
 ZymValue zymvm_hasFunction(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arityVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+
     if (!vmdata->loaded) {
         return zym_newBool(false);
     }
@@ -209,9 +814,70 @@ ZymValue zymvm_hasFunction(ZymVM* parent_vm, ZymValue context, ZymValue nameVal,
     return zym_newBool(zym_hasFunction(vmdata->vm, name, arity));
 }
 
-ZymValue zymvm_call_0(ZymVM* parent_vm, ZymValue context, ZymValue nameVal) {
+// ---- call ------------------------------------------------------------------------
+
+// Copies arguments into the nested VM and roots them there. Returns the
+// number rooted, or -1 after raising a runtime error (nothing is left
+// rooted then).
+static int zymvm_push_values(ZymVM* parent_vm, VMData* vmdata, int argc, const ZymValue* values, ZymValue* args) {
+    for (int i = 0; i < argc; i++) {
+        args[i] = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, values[i]);
+        bool unsupported = args[i] != ZYM_ERROR && zym_isNull(args[i]) && !zym_isNull(values[i]);
+        if (args[i] == ZYM_ERROR || unsupported) {
+            if (unsupported) {
+                zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+            }
+            for (int j = 0; j < i; j++) {
+                zym_popRoot(vmdata->vm);
+            }
+            return -1;
+        }
+        zym_pushRoot(vmdata->vm, args[i]);
+    }
+    return argc;
+}
+
+// As zymvm_push_values(), for arguments given as a list
+static int zymvm_push_args(ZymVM* parent_vm, VMData* vmdata, ZymValue argsVal, int argc, ZymValue* args) {
+    ZymValue values[ZYMVM_MAX_ARGS];
+    for (int i = 0; i < argc; i++) {
+        values[i] = zym_listGet(parent_vm, argsVal, i);
+    }
+    return zymvm_push_values(parent_vm, vmdata, argc, values, args);
+}
+
+static void zymvm_pop_args(VMData* vmdata, int rooted) {
+    for (int i = 0; i < rooted; i++) {
+        zym_popRoot(vmdata->vm);
+    }
+}
+
+// Starts a call; it may come back as ZYM_STATUS_YIELD part way through.
+// zym_call() reads only the first argc of its trailing arguments, so one
+// call with the array padded out to ZYMVM_MAX_ARGS serves every arity.
+static ZymStatus zymvm_start(ZymVM* vm, const char* name, int argc, ZymValue* args) {
+    if (argc < 0 || argc > ZYMVM_MAX_ARGS) {
+        return ZYM_STATUS_RUNTIME_ERROR;
+    }
+    ZymValue a[ZYMVM_MAX_ARGS];
+    for (int i = 0; i < ZYMVM_MAX_ARGS; i++) {
+        a[i] = i < argc ? args[i] : zym_newNull();
+    }
+    return zym_call(vm, name, argc, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12], a[13], a[14], a[15]);
+}
+
+static ZymStatus zymvm_invoke(ZymVM* vm, const char* name, int argc, ZymValue* args) {
+    return zymvm_complete(vm, zymvm_start(vm, name, argc, args));
+}
+
+// Every call() overload lands here with its arguments in an array
+static ZymValue zymvm_call_values(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, int argc, ZymValue* values) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+
     if (!vmdata->loaded) {
         zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
         return ZYM_ERROR;
@@ -222,365 +888,820 @@ ZymValue zymvm_call_0(ZymVM* parent_vm, ZymValue context, ZymValue nameVal) {
         return ZYM_ERROR;
     }
 
-    const char* name = zym_asCString(nameVal);
-
-    ZymStatus status = zym_call(vmdata->vm, name, 0);
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    ZymValue args[ZYMVM_MAX_ARGS];
+    int rooted = zymvm_push_values(parent_vm, vmdata, argc, values, args);
+    if (rooted < 0) {
+        quota_leave(outer);
+        return ZYM_ERROR;
+    }
+    ZymStatus status = zymvm_invoke(vmdata->vm, zym_asCString(nameVal), argc, args);
+    zymvm_pop_args(vmdata, rooted);
 
+    ZymValue result;
     if (status == ZYM_STATUS_OK) {
         ZymValue nested_result = zym_getCallResult(vmdata->vm);
         vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
         vmdata->has_result = true;
-        return zym_newBool(true);
+        result = zym_newBool(true);
+    } else {
+        vmdata->has_result = false;
+        result = zymvm_report_quota(parent_vm, vmdata) ? ZYM_ERROR : zym_newBool(false);
     }
+    quota_leave(outer);
+    return result;
+}
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+ZymValue zymvm_call_0(ZymVM* parent_vm, ZymValue context, ZymValue nameVal) {
+    return zymvm_call_values(parent_vm, context, nameVal, 0, NULL);
 }
 
 ZymValue zymvm_call_1(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1) {
-    VMData* vmdata = (VMData*)zym_getNativeData(context);
+    ZymValue args[] = {arg1};
+    return zymvm_call_values(parent_vm, context, nameVal, 1, args);
+}
 
-    if (!vmdata->loaded) {
-        zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
-        return ZYM_ERROR;
+ZymValue zymvm_call_2(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2) {
+    ZymValue args[] = {arg1, arg2};
+    return zymvm_call_values(parent_vm, context, nameVal, 2, args);
+}
+
+ZymValue zymvm_call_3(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3) {
+    ZymValue args[] = {arg1, arg2, arg3};
+    return zymvm_call_values(parent_vm, context, nameVal, 3, args);
+}
+
+ZymValue zymvm_call_4(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4};
+    return zymvm_call_values(parent_vm, context, nameVal, 4, args);
+}
+
+ZymValue zymvm_call_5(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5};
+    return zymvm_call_values(parent_vm, context, nameVal, 5, args);
+}
+
+ZymValue zymvm_call_6(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6};
+    return zymvm_call_values(parent_vm, context, nameVal, 6, args);
+}
+
+ZymValue zymvm_call_7(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7};
+    return zymvm_call_values(parent_vm, context, nameVal, 7, args);
+}
+
+ZymValue zymvm_call_8(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7, ZymValue arg8) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8};
+    return zymvm_call_values(parent_vm, context, nameVal, 8, args);
+}
+
+// ---- callAsync -------------------------------------------------------------------
+// Arguments are packed on the caller's thread, unpacked and run inside the
+// nested VM on its worker thread, and the result is packed again there, so
+// the two heaps are never touched from the same thread at once.
+
+// Results that cannot leave the VM come back as null, as with call()
+static bool zymvm_pack_result(ZymVM* vm, MarshalBlob* blob) {
+    return marshal_pack(vm, zym_getCallResult(vm), blob) || marshal_pack(vm, zym_newNull(), blob);
+}
+
+// Packs the {error: message} map that stands in for a failed call's result
+static bool zymvm_pack_error(ZymVM* vm, const char* name, MarshalBlob* blob) {
+    char message[256];
+    snprintf(message, sizeof(message), "Call to '%s' failed in the nested VM", name);
+
+    ZymValue error = zym_newMap(vm);
+    zym_pushRoot(vm, error);
+    ZymValue messageVal = zym_newString(vm, message);
+    zym_pushRoot(vm, messageVal);
+    zym_mapSet(vm, error, "error", messageVal);
+    bool ok = marshal_pack(vm, error, blob);
+    zym_popRoot(vm);
+    zym_popRoot(vm);
+    return ok;
+}
+
+// Runs each item like callMany(): a failed call fills its slot with an error
+// map and the batch carries on. Returns false only when the batch itself
+// cannot be read or the results cannot be packed.
+static bool zymvm_run_batch(ZymVM* vm, AsyncCall* call) {
+    size_t offset = 0;
+    for (int i = 0; i < call->batch; i++) {
+        ZymValue arg = marshal_unpack(vm, &call->args, &offset);
+        if (arg == ZYM_ERROR) {
+            return false;
+        }
+        zym_pushRoot(vm, arg);
+        bool ok = zymvm_complete(vm, zym_call(vm, call->name, 1, arg)) == ZYM_STATUS_OK
+            ? zymvm_pack_result(vm, &call->result)
+            : zymvm_pack_error(vm, call->name, &call->result);
+        zym_popRoot(vm);
+        if (!ok) {
+            return false;
+        }
     }
+    return true;
+}
 
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
-        return ZYM_ERROR;
+// Runs a job inside vm and leaves its result in call; the caller
+// publishes it with async_call_finish() once it is done with the VM
+static bool zymvm_run_async(ZymVM* vm, AsyncCall* call) {
+    if (call->batch > 0) {
+        return zymvm_run_batch(vm, call);
     }
 
-    const char* name = zym_asCString(nameVal);
+    ZymValue args[ZYMVM_MAX_ARGS];
+    size_t offset = 0;
+    int rooted = 0;
+    bool ok = true;
 
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
+    for (int i = 0; i < call->argc; i++) {
+        args[i] = marshal_unpack(vm, &call->args, &offset);
+        if (args[i] == ZYM_ERROR) {
+            ok = false;
+            break;
+        }
+        zym_pushRoot(vm, args[i]);
+        rooted++;
+    }
 
-    if (nested_arg1 == ZYM_ERROR) {
-        return ZYM_ERROR;
+    if (ok) {
+        ok = zymvm_invoke(vm, call->name, call->argc, args) == ZYM_STATUS_OK && zymvm_pack_result(vm, &call->result);
+    }
+
+    for (int i = 0; i < rooted; i++) {
+        zym_popRoot(vm);
+    }
+    return ok;
+}
+
+static void async_call_finish(AsyncCall* call, bool ok) {
+    mutex_lock(&call->lock);
+    call->ok = ok;
+    call->done = true;
+    condvar_broadcast(&call->done_cond);
+    mutex_unlock(&call->lock);
+}
+
+static void zymvm_worker(void* arg) {
+    VMData* vmdata = (VMData*)arg;
+
+    mutex_lock(&vmdata->lock);
+    for (;;) {
+        while (!vmdata->job && !vmdata->stopping) {
+            condvar_wait(&vmdata->wake, &vmdata->lock);
+        }
+        if (!vmdata->job) {
+            break;
+        }
+        AsyncCall* call = vmdata->job;
+        mutex_unlock(&vmdata->lock);
+
+        MemoryQuota* outer = quota_enter(vmdata->quota);
+        bool ok = zymvm_run_async(vmdata->vm, call);
+        quota_leave(outer);
+
+        // The VM is idle again before anyone can see the job as done, so
+        // a caller that waited on it may use the VM straight away
+        mutex_lock(&vmdata->lock);
+        vmdata->job = NULL;
+        vmdata->busy = false;
+        mutex_unlock(&vmdata->lock);
+        async_call_finish(call, ok);
+        async_call_release(call);
+        mutex_lock(&vmdata->lock);
+    }
+    mutex_unlock(&vmdata->lock);
+
+    // Only zymvm_cleanup() sets stopping, and it hands the VM over to us
+    zymvm_destroy(vmdata);
+}
+
+static AsyncCall* async_call_from_context(ZymValue context) {
+    return (AsyncCall*)zym_getNativeData(context);
+}
+
+static void async_call_cleanup(ZymVM* vm, void* ptr) {
+    async_call_release((AsyncCall*)ptr);
+}
+
+ZymValue zymvm_async_isDone(ZymVM* parent_vm, ZymValue context) {
+    AsyncCall* call = async_call_from_context(context);
+    mutex_lock(&call->lock);
+    bool done = call->done;
+    mutex_unlock(&call->lock);
+    return zym_newBool(done);
+}
+
+ZymValue zymvm_async_wait(ZymVM* parent_vm, ZymValue context, ZymValue timeoutVal) {
+    AsyncCall* call = async_call_from_context(context);
+
+    long timeout_ms = -1;
+    if (zym_isNumber(timeoutVal)) {
+        timeout_ms = (long)zym_asNumber(timeoutVal);
+        if (timeout_ms < 0) timeout_ms = 0;
+    }
+
+    mutex_lock(&call->lock);
+    while (!call->done) {
+        if (!condvar_wait_ms(&call->done_cond, &call->lock, timeout_ms)) {
+            break;
+        }
+    }
+    bool done = call->done;
+    mutex_unlock(&call->lock);
+    return zym_newBool(done);
+}
+
+ZymValue zymvm_async_wait_0(ZymVM* parent_vm, ZymValue context) {
+    return zymvm_async_wait(parent_vm, context, zym_newNull());
+}
+
+// Blocks until the call completes. Each call unpacks a fresh copy.
+ZymValue zymvm_async_result(ZymVM* parent_vm, ZymValue context) {
+    AsyncCall* call = async_call_from_context(context);
+
+    mutex_lock(&call->lock);
+    while (!call->done) {
+        condvar_wait(&call->done_cond, &call->lock);
     }
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) {
-        zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+    bool ok = call->ok;
+    mutex_unlock(&call->lock);
+
+    if (!ok) {
+        zym_runtimeError(parent_vm, "callAsync() of '%s' failed in the nested VM", call->name);
         return ZYM_ERROR;
     }
 
-    ZymStatus status = zym_call(vmdata->vm, name, 1, nested_arg1);
+    size_t offset = 0;
+    ZymValue result = marshal_unpack(parent_vm, &call->result, &offset);
+    if (result == ZYM_ERROR) {
+        zym_runtimeError(parent_vm, "Failed to unmarshal async call result");
+    }
+    return result;
+}
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+// Packs the arguments for a call to `name`. Returns NULL after raising a
+// runtime error on the caller.
+static AsyncCall* async_call_new(ZymVM* parent_vm, const char* name, int argc, ZymValue* args) {
+    AsyncCall* call = calloc(1, sizeof(AsyncCall));
+    if (!call) {
+        zym_runtimeError(parent_vm, "Out of memory");
+        return NULL;
     }
+    mutex_init(&call->lock);
+    condvar_init(&call->done_cond);
+    call->refs = 1;
+    call->argc = argc;
+    call->name = strdup(name);
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+    for (int i = 0; i < argc; i++) {
+        if (!marshal_pack(parent_vm, args[i], &call->args)) {
+            async_call_release(call);
+            zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+            return NULL;
+        }
+    }
+    return call;
 }
 
-ZymValue zymvm_call_2(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2) {
+// Wraps a call in a handle object. The handle takes over the caller's
+// reference.
+static ZymValue async_call_handle(ZymVM* parent_vm, AsyncCall* call) {
+    ZymValue handleContext = zym_createNativeContext(parent_vm, call, async_call_cleanup);
+    zym_pushRoot(parent_vm, handleContext);
+
+    ZymValue isDone = zym_createNativeClosure(parent_vm, "isDone()", zymvm_async_isDone, handleContext);
+    zym_pushRoot(parent_vm, isDone);
+    ZymValue wait_0 = zym_createNativeClosure(parent_vm, "wait()", zymvm_async_wait_0, handleContext);
+    zym_pushRoot(parent_vm, wait_0);
+    ZymValue wait_1 = zym_createNativeClosure(parent_vm, "wait(timeoutMs)", zymvm_async_wait, handleContext);
+    zym_pushRoot(parent_vm, wait_1);
+    ZymValue result = zym_createNativeClosure(parent_vm, "result()", zymvm_async_result, handleContext);
+    zym_pushRoot(parent_vm, result);
+
+    ZymValue wait_dispatcher = zym_createDispatcher(parent_vm);
+    zym_pushRoot(parent_vm, wait_dispatcher);
+    zym_addOverload(parent_vm, wait_dispatcher, wait_0);
+    zym_addOverload(parent_vm, wait_dispatcher, wait_1);
+
+    ZymValue obj = zym_newMap(parent_vm);
+    zym_pushRoot(parent_vm, obj);
+
+    zym_mapSet(parent_vm, obj, "isDone", isDone);
+    zym_mapSet(parent_vm, obj, "wait", wait_dispatcher);
+    zym_mapSet(parent_vm, obj, "result", result);
+
+    // (context + 4 methods + dispatcher + obj = 7)
+    for (int i = 0; i < 7; i++) {
+        zym_popRoot(parent_vm);
+    }
+
+    return obj;
+}
+
+static void async_call_retain(AsyncCall* call) {
+    mutex_lock(&call->lock);
+    call->refs++;
+    mutex_unlock(&call->lock);
+}
+
+static ZymValue zymvm_call_async(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, int argc, ZymValue* args) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!vmdata->vm) {
+        zym_runtimeError(parent_vm, "ZymVM has been ended");
+        return ZYM_ERROR;
+    }
     if (!vmdata->loaded) {
         zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
         return ZYM_ERROR;
     }
-
     if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+        zym_runtimeError(parent_vm, "callAsync() requires string function name");
+        return ZYM_ERROR;
+    }
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
         return ZYM_ERROR;
     }
 
-    const char* name = zym_asCString(nameVal);
+    AsyncCall* call = async_call_new(parent_vm, zym_asCString(nameVal), argc, args);
+    if (!call) {
+        return ZYM_ERROR;
+    }
+
+    if (!vmdata->worker_started) {
+        if (!thread_start(&vmdata->worker, zymvm_worker, vmdata)) {
+            async_call_release(call);
+            zym_runtimeError(parent_vm, "Failed to start ZymVM worker thread");
+            return ZYM_ERROR;
+        }
+        vmdata->worker_started = true;
+    }
 
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) {
-        zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+    ZymValue obj = async_call_handle(parent_vm, call);
+
+    // Hand the job to the worker; it holds its own reference
+    async_call_retain(call);
+    mutex_lock(&vmdata->lock);
+    vmdata->job = call;
+    vmdata->busy = true;
+    vmdata->has_result = false;
+    condvar_signal(&vmdata->wake);
+    mutex_unlock(&vmdata->lock);
+
+    return obj;
+}
+
+ZymValue zymvm_callAsync_0(ZymVM* parent_vm, ZymValue context, ZymValue nameVal) {
+    return zymvm_call_async(parent_vm, context, nameVal, 0, NULL);
+}
+
+ZymValue zymvm_callAsync_1(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1) {
+    ZymValue args[] = {arg1};
+    return zymvm_call_async(parent_vm, context, nameVal, 1, args);
+}
+
+ZymValue zymvm_callAsync_2(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2) {
+    ZymValue args[] = {arg1, arg2};
+    return zymvm_call_async(parent_vm, context, nameVal, 2, args);
+}
+
+ZymValue zymvm_callAsync_3(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3) {
+    ZymValue args[] = {arg1, arg2, arg3};
+    return zymvm_call_async(parent_vm, context, nameVal, 3, args);
+}
+
+ZymValue zymvm_callAsync_4(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4};
+    return zymvm_call_async(parent_vm, context, nameVal, 4, args);
+}
+
+ZymValue zymvm_callAsync_5(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5};
+    return zymvm_call_async(parent_vm, context, nameVal, 5, args);
+}
+
+ZymValue zymvm_callAsync_6(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6};
+    return zymvm_call_async(parent_vm, context, nameVal, 6, args);
+}
+
+ZymValue zymvm_callAsync_7(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7};
+    return zymvm_call_async(parent_vm, context, nameVal, 7, args);
+}
+
+ZymValue zymvm_callAsync_8(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7, ZymValue arg8) {
+    ZymValue args[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8};
+    return zymvm_call_async(parent_vm, context, nameVal, 8, args);
+}
+
+// ---- getFunction -----------------------------------------------------------------
+// A handle for one function of the nested VM. The embedding API only calls
+// functions by name, so the handle keeps the name and arity it was resolved
+// with and skips the per-call type and existence checks; arguments arrive as
+// one list instead of through a fixed overload per arity.
+
+static void function_handle_cleanup(ZymVM* vm, void* ptr) {
+    FunctionHandle* handle = (FunctionHandle*)ptr;
+    if (handle->vmdata) {
+        FunctionHandle** link = &handle->vmdata->handles;
+        while (*link != handle) {
+            link = &(*link)->next;
+        }
+        *link = handle->next;
+    }
+    free(handle->name);
+    free(handle);
+}
+
+// Returns the call's result, or raises a runtime error if it failed
+ZymValue zymvm_function_call(ZymVM* parent_vm, ZymValue context, ZymValue argsVal) {
+    FunctionHandle* handle = (FunctionHandle*)zym_getNativeData(context);
+    VMData* vmdata = handle->vmdata;
+
+    if (!vmdata || !vmdata->vm) {
+        zym_runtimeError(parent_vm, "Function '%s' belongs to a ZymVM that has been ended", handle->name);
         return ZYM_ERROR;
     }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) {
-        zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+
+    int argc = zym_isList(argsVal) ? zym_listLength(argsVal) : (zym_isNull(argsVal) ? 0 : -1);
+    if (argc != handle->arity) {
+        zym_runtimeError(parent_vm, "Function '%s' expects a list of %d arguments", handle->name, handle->arity);
         return ZYM_ERROR;
     }
 
-    ZymStatus status = zym_call(vmdata->vm, name, 2, nested_arg1, nested_arg2);
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    ZymValue args[ZYMVM_MAX_ARGS];
+    int rooted = zymvm_push_args(parent_vm, vmdata, argsVal, argc, args);
+    if (rooted < 0) {
+        quota_leave(outer);
+        return ZYM_ERROR;
+    }
+    ZymStatus status = zymvm_invoke(vmdata->vm, handle->name, argc, args);
+    zymvm_pop_args(vmdata, rooted);
 
+    ZymValue result = ZYM_ERROR;
     if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+        result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, zym_getCallResult(vmdata->vm));
+    } else if (!zymvm_report_quota(parent_vm, vmdata)) {
+        zym_runtimeError(parent_vm, "Call to '%s' failed in the nested VM", handle->name);
     }
+    quota_leave(outer);
+    return result;
+}
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+ZymValue zymvm_function_call_0(ZymVM* parent_vm, ZymValue context) {
+    return zymvm_function_call(parent_vm, context, zym_newNull());
 }
 
-ZymValue zymvm_call_3(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3) {
+ZymValue zymvm_function_getName(ZymVM* parent_vm, ZymValue context) {
+    FunctionHandle* handle = (FunctionHandle*)zym_getNativeData(context);
+    return zym_newString(parent_vm, handle->name);
+}
+
+ZymValue zymvm_function_getArity(ZymVM* parent_vm, ZymValue context) {
+    FunctionHandle* handle = (FunctionHandle*)zym_getNativeData(context);
+    return zym_newNumber((double)handle->arity);
+}
+
+ZymValue zymvm_getFunction(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arityVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
     if (!vmdata->loaded) {
-        zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
+        zym_runtimeError(parent_vm, "Cannot get function before loading bytecode");
         return ZYM_ERROR;
     }
-
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+    if (!zym_isString(nameVal) || !zym_isNumber(arityVal)) {
+        zym_runtimeError(parent_vm, "getFunction() requires string name and number arity");
         return ZYM_ERROR;
     }
 
     const char* name = zym_asCString(nameVal);
+    int arity = (int)zym_asNumber(arityVal);
+    if (arity < 0 || arity > ZYMVM_MAX_ARGS) {
+        zym_runtimeError(parent_vm, "getFunction() arity must be between 0 and %d", ZYMVM_MAX_ARGS);
+        return ZYM_ERROR;
+    }
+    if (!zym_hasFunction(vmdata->vm, name, arity)) {
+        return zym_newNull();
+    }
 
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
+    FunctionHandle* handle = calloc(1, sizeof(FunctionHandle));
+    char* name_copy = strdup(name);
+    if (!handle || !name_copy) {
+        free(handle);
+        free(name_copy);
+        zym_runtimeError(parent_vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    handle->vmdata = vmdata;
+    handle->name = name_copy;
+    handle->arity = arity;
+    handle->next = vmdata->handles;
+    vmdata->handles = handle;
 
-    ZymStatus status = zym_call(vmdata->vm, name, 3, nested_arg1, nested_arg2, nested_arg3);
+    ZymValue handleContext = zym_createNativeContext(parent_vm, handle, function_handle_cleanup);
+    zym_pushRoot(parent_vm, handleContext);
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+    ZymValue call_0 = zym_createNativeClosure(parent_vm, "call()", zymvm_function_call_0, handleContext);
+    zym_pushRoot(parent_vm, call_0);
+    ZymValue call_1 = zym_createNativeClosure(parent_vm, "call(args)", zymvm_function_call, handleContext);
+    zym_pushRoot(parent_vm, call_1);
+    ZymValue getName = zym_createNativeClosure(parent_vm, "getName()", zymvm_function_getName, handleContext);
+    zym_pushRoot(parent_vm, getName);
+    ZymValue getArity = zym_createNativeClosure(parent_vm, "getArity()", zymvm_function_getArity, handleContext);
+    zym_pushRoot(parent_vm, getArity);
+
+    ZymValue call_dispatcher = zym_createDispatcher(parent_vm);
+    zym_pushRoot(parent_vm, call_dispatcher);
+    zym_addOverload(parent_vm, call_dispatcher, call_0);
+    zym_addOverload(parent_vm, call_dispatcher, call_1);
+
+    ZymValue obj = zym_newMap(parent_vm);
+    zym_pushRoot(parent_vm, obj);
+
+    zym_mapSet(parent_vm, obj, "call", call_dispatcher);
+    zym_mapSet(parent_vm, obj, "getName", getName);
+    zym_mapSet(parent_vm, obj, "getArity", getArity);
+
+    // (context + 4 methods + dispatcher + obj = 7)
+    for (int i = 0; i < 7; i++) {
+        zym_popRoot(parent_vm);
     }
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+    return obj;
 }
 
-ZymValue zymvm_call_4(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4) {
-    VMData* vmdata = (VMData*)zym_getNativeData(context);
+// ---- run / resume ----------------------------------------------------------------
+// Budgeted execution. The VM preempts itself every instruction slice and
+// reports ZYM_STATUS_YIELD; run() and resume() let at most `budget` slices
+// pass before handing control back, so a host can round-robin many VMs and
+// none of them can hang it. Each returns {status: "done", value} or
+// {status: "yielded"}; a failed call raises a runtime error.
 
-    if (!vmdata->loaded) {
-        zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
-        return ZYM_ERROR;
+static int zymvm_budget_option(ZymVM* parent_vm, ZymValue optionsVal, const char* method) {
+    if (zym_isNull(optionsVal)) {
+        return 1;
     }
-
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
-        return ZYM_ERROR;
+    ZymValue budgetVal = zym_isMap(optionsVal) ? zym_mapGet(parent_vm, optionsVal, "budget") : optionsVal;
+    if (zym_isNull(budgetVal)) {
+        return 1;
     }
+    if (!zym_isNumber(budgetVal) || zym_asNumber(budgetVal) < 1) {
+        zym_runtimeError(parent_vm, "%s() budget must be a number of slices, at least 1", method);
+        return -1;
+    }
+    double budget = zym_asNumber(budgetVal);
+    return budget > 1e9 ? 1000000000 : (int)budget;
+}
 
-    const char* name = zym_asCString(nameVal);
+static ZymValue zymvm_run_state(ZymVM* parent_vm, const char* status, ZymValue value) {
+    zym_pushRoot(parent_vm, value);
+    ZymValue state = zym_newMap(parent_vm);
+    zym_pushRoot(parent_vm, state);
+    zym_mapSet(parent_vm, state, "status", zym_newString(parent_vm, status));
+    zym_mapSet(parent_vm, state, "value", value);
+    zym_popRoot(parent_vm);
+    zym_popRoot(parent_vm);
+    return state;
+}
 
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg4 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg4);
-    if (nested_arg4 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg4) && !zym_isNull(arg4)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-
-    ZymStatus status = zym_call(vmdata->vm, name, 4, nested_arg1, nested_arg2, nested_arg3, nested_arg4);
+// Spends the rest of the budget on a call that has already run one slice
+static ZymValue zymvm_drive(ZymVM* parent_vm, VMData* vmdata, ZymStatus status, int budget) {
+    while (status == ZYM_STATUS_YIELD && --budget > 0) {
+        status = zym_resume(vmdata->vm);
+    }
+    if (status == ZYM_STATUS_YIELD) {
+        vmdata->suspended = true;
+        return zymvm_run_state(parent_vm, "yielded", zym_newNull());
+    }
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+    vmdata->suspended = false;
+    if (status != ZYM_STATUS_OK) {
+        if (!zymvm_report_quota(parent_vm, vmdata)) {
+            zym_runtimeError(parent_vm, "Call to '%s' failed in the nested VM", vmdata->suspended_name);
+        }
+        free(vmdata->suspended_name);
+        vmdata->suspended_name = NULL;
+        vmdata->has_result = false;
+        return ZYM_ERROR;
     }
+    free(vmdata->suspended_name);
+    vmdata->suspended_name = NULL;
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+    ZymValue result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, zym_getCallResult(vmdata->vm));
+    if (result == ZYM_ERROR) {
+        return ZYM_ERROR;
+    }
+    vmdata->last_result = result;
+    vmdata->has_result = true;
+    return zymvm_run_state(parent_vm, "done", result);
 }
 
-ZymValue zymvm_call_5(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5) {
+ZymValue zymvm_run(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue argsVal, ZymValue optionsVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
     if (!vmdata->loaded) {
         zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
         return ZYM_ERROR;
     }
-
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+    if (!zym_isString(nameVal) || (!zym_isNull(argsVal) && !zym_isList(argsVal))) {
+        zym_runtimeError(parent_vm, "run() requires string function name and a list of arguments");
+        return ZYM_ERROR;
+    }
+    int budget = zymvm_budget_option(parent_vm, optionsVal, "run");
+    if (budget < 0) {
         return ZYM_ERROR;
     }
 
-    const char* name = zym_asCString(nameVal);
-
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg4 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg4);
-    if (nested_arg4 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg4) && !zym_isNull(arg4)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg5 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg5);
-    if (nested_arg5 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg5) && !zym_isNull(arg5)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-
-    ZymStatus status = zym_call(vmdata->vm, name, 5, nested_arg1, nested_arg2, nested_arg3, nested_arg4, nested_arg5);
-
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+    int argc = zym_isList(argsVal) ? zym_listLength(argsVal) : 0;
+    if (argc > ZYMVM_MAX_ARGS) {
+        zym_runtimeError(parent_vm, "run() supports at most %d arguments", ZYMVM_MAX_ARGS);
+        return ZYM_ERROR;
+    }
+    char* name = strdup(zym_asCString(nameVal));
+    if (!name) {
+        zym_runtimeError(parent_vm, "Out of memory");
+        return ZYM_ERROR;
     }
 
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    ZymValue args[ZYMVM_MAX_ARGS];
+    int rooted = zymvm_push_args(parent_vm, vmdata, argsVal, argc, args);
+    if (rooted < 0) {
+        quota_leave(outer);
+        free(name);
+        return ZYM_ERROR;
+    }
+    vmdata->suspended_name = name;
     vmdata->has_result = false;
-    return zym_newBool(false);
+    ZymStatus status = zymvm_start(vmdata->vm, name, argc, args);
+    zymvm_pop_args(vmdata, rooted);
+
+    ZymValue result = zymvm_drive(parent_vm, vmdata, status, budget);
+    quota_leave(outer);
+    return result;
 }
 
-ZymValue zymvm_call_6(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6) {
+ZymValue zymvm_run_2(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue argsVal) {
+    return zymvm_run(parent_vm, context, nameVal, argsVal, zym_newNull());
+}
+
+ZymValue zymvm_resume(ZymVM* parent_vm, ZymValue context, ZymValue budgetVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
-    if (!vmdata->loaded) {
-        zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
+    if (!vmdata->suspended) {
+        zym_runtimeError(parent_vm, "resume() requires a run() that yielded");
         return ZYM_ERROR;
     }
-
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+    int budget = zymvm_budget_option(parent_vm, budgetVal, "resume");
+    if (budget < 0) {
         return ZYM_ERROR;
     }
 
-    const char* name = zym_asCString(nameVal);
-
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg4 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg4);
-    if (nested_arg4 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg4) && !zym_isNull(arg4)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg5 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg5);
-    if (nested_arg5 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg5) && !zym_isNull(arg5)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg6 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg6);
-    if (nested_arg6 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg6) && !zym_isNull(arg6)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-
-    ZymStatus status = zym_call(vmdata->vm, name, 6, nested_arg1, nested_arg2, nested_arg3, nested_arg4, nested_arg5, nested_arg6);
+    atomic_store(&vmdata->quota->heap.exceeded, false);
+    atomic_store(&vmdata->quota->buffer.exceeded, false);
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    ZymValue result = zymvm_drive(parent_vm, vmdata, zym_resume(vmdata->vm), budget);
+    quota_leave(outer);
+    return result;
+}
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
-    }
+ZymValue zymvm_resume_0(ZymVM* parent_vm, ZymValue context) {
+    return zymvm_resume(parent_vm, context, zym_newNull());
+}
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
+ZymValue zymvm_isSuspended(ZymVM* parent_vm, ZymValue context) {
+    VMData* vmdata = (VMData*)zym_getNativeData(context);
+    return zym_newBool(vmdata->suspended);
 }
 
-ZymValue zymvm_call_7(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7) {
+// ---- callMany / mapCall ----------------------------------------------------------
+// The whole batch is packed once, unpacked once in the nested VM and run in
+// one loop there; results are packed back into a single blob. A failed item
+// yields {error: message} in its slot instead of aborting the batch.
+
+// With spread, each item is a list of arguments; otherwise each item is the
+// single argument
+static ZymValue zymvm_run_many(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue listVal, bool spread, const char* method) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
+
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
     if (!vmdata->loaded) {
         zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
         return ZYM_ERROR;
     }
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+    if (!zym_isString(nameVal) || !zym_isList(listVal)) {
+        zym_runtimeError(parent_vm, "%s() requires string function name and a list", method);
         return ZYM_ERROR;
     }
-    const char* name = zym_asCString(nameVal);
-
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg4 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg4);
-    if (nested_arg4 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg4) && !zym_isNull(arg4)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg5 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg5);
-    if (nested_arg5 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg5) && !zym_isNull(arg5)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg6 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg6);
-    if (nested_arg6 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg6) && !zym_isNull(arg6)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg7 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg7);
-    if (nested_arg7 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg7) && !zym_isNull(arg7)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-
-    ZymStatus status = zym_call(vmdata->vm, name, 7, nested_arg1, nested_arg2, nested_arg3, nested_arg4, nested_arg5, nested_arg6, nested_arg7);
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+    int count = zym_listLength(listVal);
+    if (spread) {
+        for (int i = 0; i < count; i++) {
+            ZymValue item = zym_listGet(parent_vm, listVal, i);
+            if (!zym_isList(item) || zym_listLength(item) > ZYMVM_MAX_ARGS) {
+                zym_runtimeError(parent_vm, "%s() item %d must be a list of at most %d arguments", method, i, ZYMVM_MAX_ARGS);
+                return ZYM_ERROR;
+            }
+        }
     }
 
-    vmdata->has_result = false;
-    return zym_newBool(false);
-}
+    const char* name = zym_asCString(nameVal);
+    MarshalBlob batch = {0};
+    MarshalBlob results = {0};
+    if (!marshal_pack_pending(parent_vm, listVal, &batch)) {
+        zym_runtimeError(parent_vm, "Cannot pass %s() arguments to nested VM: %s", method, batch.error);
+        marshal_blob_free(&batch);
+        return ZYM_ERROR;
+    }
 
-ZymValue zymvm_call_8(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue arg1, ZymValue arg2, ZymValue arg3, ZymValue arg4, ZymValue arg5, ZymValue arg6, ZymValue arg7, ZymValue arg8) {
-    VMData* vmdata = (VMData*)zym_getNativeData(context);
-    if (!vmdata->loaded) {
-        zym_runtimeError(parent_vm, "Cannot call function before loading bytecode");
+    ZymVM* vm = vmdata->vm;
+    MemoryQuota* outer = quota_enter(vmdata->quota);
+    size_t offset = 0;
+    ZymValue items = marshal_unpack(vm, &batch, &offset);
+    marshal_settle(parent_vm, &batch, items != ZYM_ERROR);
+    marshal_blob_free(&batch);
+    if (items == ZYM_ERROR) {
+        quota_leave(outer);
+        zym_runtimeError(parent_vm, "Failed to unmarshal %s() arguments", method);
         return ZYM_ERROR;
     }
-    if (!zym_isString(nameVal)) {
-        zym_runtimeError(parent_vm, "call() requires string function name");
+    zym_pushRoot(vm, items);
+
+    bool ok = true;
+    for (int i = 0; ok && i < count; i++) {
+        ZymValue item = zym_listGet(vm, items, i);
+        ZymValue args[ZYMVM_MAX_ARGS];
+        int argc = 1;
+        if (spread) {
+            argc = zym_listLength(item);
+            for (int a = 0; a < argc; a++) {
+                args[a] = zym_listGet(vm, item, a);
+            }
+        } else {
+            args[0] = item;
+        }
+
+        if (zymvm_invoke(vm, name, argc, args) == ZYM_STATUS_OK) {
+            ok = zymvm_pack_result(vm, &results);
+        } else {
+            ok = zymvm_pack_error(vm, name, &results);
+        }
+    }
+    zym_popRoot(vm);
+    quota_leave(outer);
+
+    if (zymvm_report_quota(parent_vm, vmdata)) {
+        marshal_blob_free(&results);
+        return ZYM_ERROR;
+    }
+    if (!ok) {
+        zym_runtimeError(parent_vm, "Cannot return %s() results from nested VM: %s", method, results.error);
+        marshal_blob_free(&results);
         return ZYM_ERROR;
     }
-    const char* name = zym_asCString(nameVal);
-
-    ZymValue nested_arg1 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg1);
-    if (nested_arg1 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg1) && !zym_isNull(arg1)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg2 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg2);
-    if (nested_arg2 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg2) && !zym_isNull(arg2)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg3 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg3);
-    if (nested_arg3 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg3) && !zym_isNull(arg3)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg4 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg4);
-    if (nested_arg4 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg4) && !zym_isNull(arg4)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg5 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg5);
-    if (nested_arg5 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg5) && !zym_isNull(arg5)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg6 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg6);
-    if (nested_arg6 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg6) && !zym_isNull(arg6)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg7 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg7);
-    if (nested_arg7 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg7) && !zym_isNull(arg7)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-    ZymValue nested_arg8 = marshal_reconstruct_value(parent_vm, parent_vm, vmdata->vm, arg8);
-    if (nested_arg8 == ZYM_ERROR) return ZYM_ERROR;
-    if (zym_isNull(nested_arg8) && !zym_isNull(arg8)) { zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM"); return ZYM_ERROR; }
-
-    ZymStatus status = zym_call(vmdata->vm, name, 8, nested_arg1, nested_arg2, nested_arg3, nested_arg4, nested_arg5, nested_arg6, nested_arg7, nested_arg8);
 
-    if (status == ZYM_STATUS_OK) {
-        ZymValue nested_result = zym_getCallResult(vmdata->vm);
-        vmdata->last_result = marshal_reconstruct_value(parent_vm, vmdata->vm, parent_vm, nested_result);
-        vmdata->has_result = true;
-        return zym_newBool(true);
+    ZymValue list = zym_newList(parent_vm);
+    zym_pushRoot(parent_vm, list);
+    offset = 0;
+    for (int i = 0; i < count; i++) {
+        ZymValue result = marshal_unpack(parent_vm, &results, &offset);
+        if (result == ZYM_ERROR) {
+            zym_popRoot(parent_vm);
+            marshal_blob_free(&results);
+            zym_runtimeError(parent_vm, "Failed to unmarshal %s() results", method);
+            return ZYM_ERROR;
+        }
+        zym_listAppend(parent_vm, list, result);
     }
+    zym_popRoot(parent_vm);
+    marshal_blob_free(&results);
 
     vmdata->has_result = false;
-    return zym_newBool(false);
+    return list;
+}
+
+ZymValue zymvm_callMany(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue argListsVal) {
+    return zymvm_run_many(parent_vm, context, nameVal, argListsVal, true, "callMany");
+}
+
+ZymValue zymvm_mapCall(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue listVal) {
+    return zymvm_run_many(parent_vm, context, nameVal, listVal, false, "mapCall");
 }
 
 ZymValue zymvm_getCallResult(ZymVM* parent_vm, ZymValue context) {
@@ -644,6 +1765,10 @@ ZymValue zymvm_compileSource(ZymVM* parent_vm, ZymValue context, ZymValue source
 ZymValue zymvm_loadFile(ZymVM* parent_vm, ZymValue context, ZymValue pathVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+
     if (!zym_isString(pathVal)) {
         zym_runtimeError(parent_vm, "loadFile() requires a string path");
         return ZYM_ERROR;
@@ -665,28 +1790,18 @@ ZymValue zymvm_loadFile(ZymVM* parent_vm, ZymValue context, ZymValue pathVal) {
         return ZYM_ERROR;
     }
 
-    // Deserialize and run in the nested VM
-    ZymChunk* chunk = zym_newChunk(vmdata->vm);
-    ZymStatus status = zym_deserializeChunk(vmdata->vm, chunk, bytecode, bytecode_size);
+    ZymValue result = zymvm_run_bytecode(parent_vm, vmdata, bytecode, bytecode_size);
     free(bytecode);
-
-    if (status != ZYM_STATUS_OK) {
-        zym_freeChunk(vmdata->vm, chunk);
-        return zym_newBool(false);
-    }
-
-    status = zym_runChunk(vmdata->vm, chunk);
-    if (status != ZYM_STATUS_OK) {
-        return zym_newBool(false);
-    }
-
-    vmdata->loaded = true;
-    return zym_newBool(true);
+    return result;
 }
 
 ZymValue zymvm_loadSource(ZymVM* parent_vm, ZymValue context, ZymValue sourceVal) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    if (!zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+
     if (!zym_isString(sourceVal)) {
         zym_runtimeError(parent_vm, "loadSource() requires a string source");
         return ZYM_ERROR;
@@ -702,57 +1817,83 @@ ZymValue zymvm_loadSource(ZymVM* parent_vm, ZymValue context, ZymValue sourceVal
         return ZYM_ERROR;
     }
 
-    // Deserialize and run in the nested VM
-    ZymChunk* chunk = zym_newChunk(vmdata->vm);
-    ZymStatus status = zym_deserializeChunk(vmdata->vm, chunk, bytecode, bytecode_size);
+    ZymValue result = zymvm_run_bytecode(parent_vm, vmdata, bytecode, bytecode_size);
     free(bytecode);
-
-    if (status != ZYM_STATUS_OK) {
-        zym_freeChunk(vmdata->vm, chunk);
-        return zym_newBool(false);
-    }
-
-    status = zym_runChunk(vmdata->vm, chunk);
-    if (status != ZYM_STATUS_OK) {
-        return zym_newBool(false);
-    }
-
-    vmdata->loaded = true;
-    return zym_newBool(true);
+    return result;
 }
 
 ZymValue zymvm_end(ZymVM* parent_vm, ZymValue context) {
     VMData* vmdata = (VMData*)zym_getNativeData(context);
 
+    // A suspended run() is simply abandoned
+    if (!vmdata->suspended && !zymvm_ensure_idle(parent_vm, vmdata)) {
+        return ZYM_ERROR;
+    }
+    vmdata->suspended = false;
+    free(vmdata->suspended_name);
+    vmdata->suspended_name = NULL;
+
     if (vmdata->vm) {
+        MemoryQuota* outer = quota_enter(vmdata->quota);
         zym_freeVM(vmdata->vm);
+        quota_leave(outer);
         vmdata->vm = NULL;
         vmdata->loaded = false;
         vmdata->has_result = false;
+        quota_settle(vmdata->quota);
     }
 
     return context;
 }
 
-ZymValue nativeZymVM_create(ZymVM* vm) {
+// {heapBytes, heapPeakBytes, maxHeapBytes, bufferBytes, bufferPeakBytes,
+// maxBufferBytes}. Usage includes VMs nested inside this one. Readable
+// while an async call runs.
+ZymValue zymvm_getMemoryUsage(ZymVM* parent_vm, ZymValue context) {
+    VMData* vmdata = (VMData*)zym_getNativeData(context);
+    MemoryQuota* quota = vmdata->quota;
+
+    ZymValue usage = zym_newMap(parent_vm);
+    zym_pushRoot(parent_vm, usage);
+    zym_mapSet(parent_vm, usage, "heapBytes", zym_newNumber((double)atomic_load(&quota->heap.used)));
+    zym_mapSet(parent_vm, usage, "heapPeakBytes", zym_newNumber((double)atomic_load(&quota->heap.peak)));
+    zym_mapSet(parent_vm, usage, "maxHeapBytes", zym_newNumber((double)quota->heap.max));
+    zym_mapSet(parent_vm, usage, "bufferBytes", zym_newNumber((double)atomic_load(&quota->buffer.used)));
+    zym_mapSet(parent_vm, usage, "bufferPeakBytes", zym_newNumber((double)atomic_load(&quota->buffer.peak)));
+    zym_mapSet(parent_vm, usage, "maxBufferBytes", zym_newNumber((double)quota->buffer.max));
+    zym_popRoot(parent_vm);
+
+    return usage;
+}
+
+static ZymValue zymvm_new_object(ZymVM* vm, size_t max_heap, size_t max_buffer, MemoryQuota* parent) {
     VMData* vmdata = calloc(1, sizeof(VMData));
-    if (!vmdata) {
+    MemoryQuota* quota = quota_new(max_heap, max_buffer, parent);
+    if (!vmdata || !quota) {
+        free(vmdata);
+        quota_release(quota);
         zym_runtimeError(vm, "Out of memory");
         return ZYM_ERROR;
     }
+    vmdata->quota = quota;
 
-    vmdata->vm = zym_newVM(NULL);
+    vmdata->vm = zym_newVM(&quota->allocator);
     if (!vmdata->vm) {
+        quota_settle(quota);
+        quota_release(quota);
         free(vmdata);
         zym_runtimeError(vm, "Failed to create nested VM");
         return ZYM_ERROR;
     }
+    atomic_store(&quota->vm, vmdata->vm);
 
     setupNatives(vmdata->vm);
 
     vmdata->loaded = false;
     vmdata->has_result = false;
     vmdata->last_result = zym_newNull();
+    mutex_init(&vmdata->lock);
+    condvar_init(&vmdata->wake);
 
     ZymValue context = zym_createNativeContext(vm, vmdata, zymvm_cleanup);
     zym_pushRoot(vm, context);
@@ -767,6 +1908,7 @@ ZymValue nativeZymVM_create(ZymVM* vm) {
     CREATE_METHOD(loadFile, zymvm_loadFile, "loadFile(path)");
     CREATE_METHOD(loadSource, zymvm_loadSource, "loadSource(source)");
     CREATE_METHOD(hasFunction, zymvm_hasFunction, "hasFunction(name, arity)");
+    CREATE_METHOD(getFunction, zymvm_getFunction, "getFunction(name, arity)");
     CREATE_METHOD(call_0, zymvm_call_0, "call(name)");
     CREATE_METHOD(call_1, zymvm_call_1, "call(name, arg)");
     CREATE_METHOD(call_2, zymvm_call_2, "call(name, arg, arg)");
@@ -776,7 +1918,24 @@ ZymValue nativeZymVM_create(ZymVM* vm) {
     CREATE_METHOD(call_6, zymvm_call_6, "call(name, arg, arg, arg, arg, arg, arg)");
     CREATE_METHOD(call_7, zymvm_call_7, "call(name, arg, arg, arg, arg, arg, arg, arg)");
     CREATE_METHOD(call_8, zymvm_call_8, "call(name, arg, arg, arg, arg, arg, arg, arg, arg)");
+    CREATE_METHOD(callAsync_0, zymvm_callAsync_0, "callAsync(name)");
+    CREATE_METHOD(callAsync_1, zymvm_callAsync_1, "callAsync(name, arg)");
+    CREATE_METHOD(callAsync_2, zymvm_callAsync_2, "callAsync(name, arg, arg)");
+    CREATE_METHOD(callAsync_3, zymvm_callAsync_3, "callAsync(name, arg, arg, arg)");
+    CREATE_METHOD(callAsync_4, zymvm_callAsync_4, "callAsync(name, arg, arg, arg, arg)");
+    CREATE_METHOD(callAsync_5, zymvm_callAsync_5, "callAsync(name, arg, arg, arg, arg, arg)");
+    CREATE_METHOD(callAsync_6, zymvm_callAsync_6, "callAsync(name, arg, arg, arg, arg, arg, arg)");
+    CREATE_METHOD(callAsync_7, zymvm_callAsync_7, "callAsync(name, arg, arg, arg, arg, arg, arg, arg)");
+    CREATE_METHOD(callAsync_8, zymvm_callAsync_8, "callAsync(name, arg, arg, arg, arg, arg, arg, arg, arg)");
+    CREATE_METHOD(run_2, zymvm_run_2, "run(name, args)");
+    CREATE_METHOD(run_3, zymvm_run, "run(name, args, options)");
+    CREATE_METHOD(resume_0, zymvm_resume_0, "resume()");
+    CREATE_METHOD(resume_1, zymvm_resume, "resume(budget)");
+    CREATE_METHOD(isSuspended, zymvm_isSuspended, "isSuspended()");
+    CREATE_METHOD(callMany, zymvm_callMany, "callMany(name, argLists)");
+    CREATE_METHOD(mapCall, zymvm_mapCall, "mapCall(name, list)");
     CREATE_METHOD(getCallResult, zymvm_getCallResult, "getCallResult()");
+    CREATE_METHOD(getMemoryUsage, zymvm_getMemoryUsage, "getMemoryUsage()");
     CREATE_METHOD(end, zymvm_end, "end()");
 
     #undef CREATE_METHOD
@@ -793,6 +1952,28 @@ ZymValue nativeZymVM_create(ZymVM* vm) {
     zym_addOverload(vm, call_dispatcher, call_7);
     zym_addOverload(vm, call_dispatcher, call_8);
 
+    ZymValue callAsync_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, callAsync_dispatcher);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_0);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_1);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_2);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_3);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_4);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_5);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_6);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_7);
+    zym_addOverload(vm, callAsync_dispatcher, callAsync_8);
+
+    ZymValue run_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, run_dispatcher);
+    zym_addOverload(vm, run_dispatcher, run_2);
+    zym_addOverload(vm, run_dispatcher, run_3);
+
+    ZymValue resume_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, resume_dispatcher);
+    zym_addOverload(vm, resume_dispatcher, resume_0);
+    zym_addOverload(vm, resume_dispatcher, resume_1);
+
     ZymValue obj = zym_newMap(vm);
     zym_pushRoot(vm, obj);
 
@@ -802,13 +1983,627 @@ ZymValue nativeZymVM_create(ZymVM* vm) {
     zym_mapSet(vm, obj, "loadFile", loadFile);
     zym_mapSet(vm, obj, "loadSource", loadSource);
     zym_mapSet(vm, obj, "hasFunction", hasFunction);
+    zym_mapSet(vm, obj, "getFunction", getFunction);
     zym_mapSet(vm, obj, "call", call_dispatcher);
+    zym_mapSet(vm, obj, "callAsync", callAsync_dispatcher);
+    zym_mapSet(vm, obj, "run", run_dispatcher);
+    zym_mapSet(vm, obj, "resume", resume_dispatcher);
+    zym_mapSet(vm, obj, "isSuspended", isSuspended);
+    zym_mapSet(vm, obj, "callMany", callMany);
+    zym_mapSet(vm, obj, "mapCall", mapCall);
     zym_mapSet(vm, obj, "getCallResult", getCallResult);
+    zym_mapSet(vm, obj, "getMemoryUsage", getMemoryUsage);
     zym_mapSet(vm, obj, "end", end);
 
-    for (int i = 0; i < 18; i++) {
+    for (int i = 0; i < 39; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+static bool zymvm_quota_option(ZymVM* vm, ZymValue optionsVal, const char* key, size_t* out) {
+    ZymValue value = zym_mapGet(vm, optionsVal, key);
+    if (zym_isNull(value)) {
+        return true;
+    }
+    if (!zym_isNumber(value) || zym_asNumber(value) < 0) {
+        zym_runtimeError(vm, "ZymVM() option '%s' must be a non-negative number", key);
+        return false;
+    }
+    *out = (size_t)zym_asNumber(value);
+    return true;
+}
+
+// Options: maxHeapBytes caps the nested VM's own heap, maxBufferBytes the
+// storage of Buffers created inside it. Both default to 0, no limit.
+ZymValue nativeZymVM_create(ZymVM* vm, ZymValue optionsVal) {
+    size_t max_heap = 0;
+    size_t max_buffer = 0;
+    if (!zym_isNull(optionsVal)) {
+        if (!zym_isMap(optionsVal)) {
+            zym_runtimeError(vm, "ZymVM() options must be a map");
+            return ZYM_ERROR;
+        }
+        if (!zymvm_quota_option(vm, optionsVal, "maxHeapBytes", &max_heap) ||
+            !zymvm_quota_option(vm, optionsVal, "maxBufferBytes", &max_buffer)) {
+            return ZYM_ERROR;
+        }
+    }
+
+    // A VM created inside a nested VM draws on that VM's quota as well as
+    // its own, so it can't escape the outer limits
+    return zymvm_new_object(vm, max_heap, max_buffer, quota_for(vm));
+}
+
+ZymValue nativeZymVM_create_0(ZymVM* vm) {
+    return nativeZymVM_create(vm, zym_newNull());
+}
+
+// ---- ZymVMPool -------------------------------------------------------------------
+// N worker threads, each owning a VM loaded from the same bytecode. Every
+// worker has its own deque of calls; submissions are dealt round-robin and
+// an idle worker steals from the back of a busy one's deque, so a few slow
+// calls cannot leave the other cores idle. Deques are mutex-protected rather
+// than lock-free because tasks are pushed from the caller's thread, not by
+// the owning worker.
+
+typedef struct {
+    AsyncCall** items;
+    size_t head;
+    size_t count;
+    size_t capacity;
+    Mutex lock;
+} PoolDeque;
+
+typedef struct VMPool VMPool;
+
+typedef struct {
+    VMPool* pool;
+    int index;
+    ThreadHandle thread;
+    PoolDeque deque;
+    bool load_ok;
+} PoolWorker;
+
+struct VMPool {
+    PoolWorker* workers;
+    int worker_count;
+    int next_worker;
+
+    uint8_t* bytecode;
+    size_t bytecode_size;
+
+    Mutex lock;
+    CondVar work_cond;      // Tasks queued, or stopping
+    CondVar ready_cond;     // A worker finished loading
+    size_t queued;
+    int loaded;
+    int running;            // Workers that have not exited yet
+    bool stopping;
+    bool stopped;           // Every worker joined by shutdown()
+    bool detached;          // Finalised; the last worker to exit frees the pool
+};
+
+static void pool_deque_init(PoolDeque* deque) {
+    memset(deque, 0, sizeof(PoolDeque));
+    mutex_init(&deque->lock);
+}
+
+static bool pool_deque_push(PoolDeque* deque, AsyncCall* call) {
+    mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        size_t new_capacity = deque->capacity ? deque->capacity * 2 : 64;
+        AsyncCall** items = malloc(new_capacity * sizeof(AsyncCall*));
+        if (!items) {
+            mutex_unlock(&deque->lock);
+            return false;
+        }
+        for (size_t i = 0; i < deque->count; i++) {
+            items[i] = deque->items[(deque->head + i) % deque->capacity];
+        }
+        free(deque->items);
+        deque->items = items;
+        deque->head = 0;
+        deque->capacity = new_capacity;
+    }
+    deque->items[(deque->head + deque->count) % deque->capacity] = call;
+    deque->count++;
+    mutex_unlock(&deque->lock);
+    return true;
+}
+
+// The owner takes the oldest task; thieves take the newest
+static AsyncCall* pool_deque_take(PoolDeque* deque, bool steal) {
+    mutex_lock(&deque->lock);
+    AsyncCall* call = NULL;
+    if (deque->count > 0) {
+        if (steal) {
+            call = deque->items[(deque->head + deque->count - 1) % deque->capacity];
+        } else {
+            call = deque->items[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        }
+        deque->count--;
+    }
+    mutex_unlock(&deque->lock);
+    return call;
+}
+
+static AsyncCall* pool_find_task(PoolWorker* worker) {
+    VMPool* pool = worker->pool;
+    AsyncCall* call = pool_deque_take(&worker->deque, false);
+    for (int i = 1; !call && i < pool->worker_count; i++) {
+        PoolWorker* victim = &pool->workers[(worker->index + i) % pool->worker_count];
+        call = pool_deque_take(&victim->deque, true);
+    }
+    return call;
+}
+
+static ZymVM* pool_load_vm(VMPool* pool) {
+    ZymVM* vm = zym_newVM(NULL);
+    if (!vm) {
+        return NULL;
+    }
+    setupNatives(vm);
+
+    ZymChunk* chunk = zym_newChunk(vm);
+    if (!chunk) {
+        zym_freeVM(vm);
+        return NULL;
+    }
+    if (zym_deserializeChunk(vm, chunk, (const char*)pool->bytecode, pool->bytecode_size) != ZYM_STATUS_OK) {
+        zym_freeChunk(vm, chunk);
+        zym_freeVM(vm);
+        return NULL;
+    }
+    if (zymvm_complete(vm, zym_runChunk(vm, chunk)) != ZYM_STATUS_OK) {
+        zym_freeVM(vm);
+        return NULL;
+    }
+    return vm;
+}
+
+static void pool_free(VMPool* pool);
+
+static void pool_worker_exit(VMPool* pool) {
+    mutex_lock(&pool->lock);
+    bool last = --pool->running == 0 && pool->detached;
+    mutex_unlock(&pool->lock);
+    if (last) {
+        pool_free(pool);
+    }
+}
+
+static void pool_worker_main(void* arg) {
+    PoolWorker* worker = (PoolWorker*)arg;
+    VMPool* pool = worker->pool;
+
+    // Each VM is created, used and freed on its own thread
+    ZymVM* vm = pool_load_vm(pool);
+
+    mutex_lock(&pool->lock);
+    worker->load_ok = vm != NULL;
+    pool->loaded++;
+    condvar_broadcast(&pool->ready_cond);
+    mutex_unlock(&pool->lock);
+
+    if (!vm) {
+        pool_worker_exit(pool);
+        return;
+    }
+
+    for (;;) {
+        AsyncCall* call = pool_find_task(worker);
+        if (call) {
+            mutex_lock(&pool->lock);
+            pool->queued--;
+            mutex_unlock(&pool->lock);
+
+            async_call_finish(call, zymvm_run_async(vm, call));
+            async_call_release(call);
+            continue;
+        }
+
+        mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->stopping) {
+            condvar_wait(&pool->work_cond, &pool->lock);
+        }
+        bool exit_now = pool->queued == 0 && pool->stopping;
+        mutex_unlock(&pool->lock);
+        if (exit_now) {
+            break;
+        }
+    }
+
+    zym_freeVM(vm);
+    pool_worker_exit(pool);
+}
+
+// Finishes queued work, then joins every worker
+static void pool_stop(VMPool* pool) {
+    if (pool->stopped) {
+        return;
+    }
+    mutex_lock(&pool->lock);
+    pool->stopping = true;
+    condvar_broadcast(&pool->work_cond);
+    mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        thread_join(pool->workers[i].thread);
+    }
+    pool->stopped = true;
+}
+
+static void pool_free(VMPool* pool) {
+    for (int i = 0; i < pool->worker_count; i++) {
+        PoolDeque* deque = &pool->workers[i].deque;
+        // Only reachable when a worker failed to load
+        AsyncCall* call;
+        while ((call = pool_deque_take(deque, false)) != NULL) {
+            async_call_release(call);
+        }
+        free(deque->items);
+        mutex_destroy(&deque->lock);
+    }
+    free(pool->workers);
+    free(pool->bytecode);
+    mutex_destroy(&pool->lock);
+    condvar_destroy(&pool->work_cond);
+    condvar_destroy(&pool->ready_cond);
+    free(pool);
+}
+
+// A finaliser must not block on queued work: the workers finish it, and
+// whichever exits last frees the pool
+void zymvmpool_cleanup(ZymVM* vm, void* ptr) {
+    VMPool* pool = (VMPool*)ptr;
+    if (pool->stopped) {
+        pool_free(pool);
+        return;
+    }
+    // Detached before the flag is set, while no worker may free the pool
+    for (int i = 0; i < pool->worker_count; i++) {
+        thread_detach(pool->workers[i].thread);
+    }
+    mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pool->detached = true;
+    condvar_broadcast(&pool->work_cond);
+    bool none_left = pool->running == 0;
+    mutex_unlock(&pool->lock);
+    if (none_left) {
+        pool_free(pool);
+    }
+}
+
+static bool pool_enqueue(VMPool* pool, AsyncCall* call) {
+    async_call_retain(call);
+    PoolWorker* worker = &pool->workers[pool->next_worker];
+    pool->next_worker = (pool->next_worker + 1) % pool->worker_count;
+
+    // Counted before it can be taken, or a worker that takes it at once
+    // would decrement queued below zero
+    mutex_lock(&pool->lock);
+    pool->queued++;
+    mutex_unlock(&pool->lock);
+
+    if (!pool_deque_push(&worker->deque, call)) {
+        mutex_lock(&pool->lock);
+        pool->queued--;
+        mutex_unlock(&pool->lock);
+        async_call_release(call);
+        return false;
+    }
+
+    mutex_lock(&pool->lock);
+    condvar_signal(&pool->work_cond);
+    mutex_unlock(&pool->lock);
+    return true;
+}
+
+static bool pool_check_open(ZymVM* parent_vm, VMPool* pool) {
+    if (pool->stopped) {
+        zym_runtimeError(parent_vm, "ZymVMPool has been shut down");
+        return false;
+    }
+    return true;
+}
+
+ZymValue zymvmpool_submit(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue argsVal) {
+    VMPool* pool = (VMPool*)zym_getNativeData(context);
+
+    if (!pool_check_open(parent_vm, pool)) {
+        return ZYM_ERROR;
+    }
+    if (!zym_isString(nameVal)) {
+        zym_runtimeError(parent_vm, "submit() requires string function name");
+        return ZYM_ERROR;
+    }
+    if (!zym_isNull(argsVal) && !zym_isList(argsVal)) {
+        zym_runtimeError(parent_vm, "submit() arguments must be a list");
+        return ZYM_ERROR;
+    }
+
+    int argc = zym_isList(argsVal) ? zym_listLength(argsVal) : 0;
+    if (argc > ZYMVM_MAX_ARGS) {
+        zym_runtimeError(parent_vm, "submit() supports at most %d arguments", ZYMVM_MAX_ARGS);
+        return ZYM_ERROR;
+    }
+    ZymValue args[ZYMVM_MAX_ARGS];
+    for (int i = 0; i < argc; i++) {
+        args[i] = zym_listGet(parent_vm, argsVal, i);
+    }
+
+    AsyncCall* call = async_call_new(parent_vm, zym_asCString(nameVal), argc, args);
+    if (!call) {
+        return ZYM_ERROR;
+    }
+    if (!pool_enqueue(pool, call)) {
+        async_call_release(call);
+        zym_runtimeError(parent_vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    return async_call_handle(parent_vm, call);
+}
+
+ZymValue zymvmpool_submit_1(ZymVM* parent_vm, ZymValue context, ZymValue nameVal) {
+    return zymvmpool_submit(parent_vm, context, nameVal, zym_newNull());
+}
+
+// Calls fnName(item) for every item and returns the results in order; a
+// failed call yields {error: message} in its slot, as with callMany(). Items
+// travel in chunks of chunkSize so small calls are not dominated by queueing.
+ZymValue zymvmpool_map(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue listVal, ZymValue chunkVal) {
+    VMPool* pool = (VMPool*)zym_getNativeData(context);
+
+    if (!pool_check_open(parent_vm, pool)) {
+        return ZYM_ERROR;
+    }
+    if (!zym_isString(nameVal) || !zym_isList(listVal)) {
+        zym_runtimeError(parent_vm, "map() requires string function name and a list");
+        return ZYM_ERROR;
+    }
+
+    int length = zym_listLength(listVal);
+    int chunk_size = 0;
+    if (!zym_isNull(chunkVal)) {
+        double requested = zym_isNumber(chunkVal) ? zym_asNumber(chunkVal) : NAN;
+        if (!isfinite(requested) || requested < 1 || requested != floor(requested)) {
+            zym_runtimeError(parent_vm, "map() chunkSize must be a positive integer");
+            return ZYM_ERROR;
+        }
+        // A chunk never needs to be longer than the list
+        chunk_size = requested < (double)length ? (int)requested : (length > 0 ? length : 1);
+    }
+    if (chunk_size == 0) {
+        // About four chunks per worker keeps stealing useful
+        int chunks = pool->worker_count * 4;
+        chunk_size = (length + chunks - 1) / chunks;
+        if (chunk_size < 1) chunk_size = 1;
+    }
+
+    int chunk_count = (length + chunk_size - 1) / chunk_size;
+    AsyncCall** calls = calloc(chunk_count > 0 ? (size_t)chunk_count : 1, sizeof(AsyncCall*));
+    if (!calls) {
+        zym_runtimeError(parent_vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    const char* name = zym_asCString(nameVal);
+    bool failed = false;
+    int queued = 0;
+    for (int c = 0; c < chunk_count && !failed; c++) {
+        int start = c * chunk_size;
+        int end = start + chunk_size < length ? start + chunk_size : length;
+
+        AsyncCall* call = async_call_new(parent_vm, name, 0, NULL);
+        if (!call) {
+            failed = true;
+            break;
+        }
+        call->batch = end - start;
+        for (int i = start; i < end; i++) {
+            if (!marshal_pack(parent_vm, zym_listGet(parent_vm, listVal, i), &call->args)) {
+                zym_runtimeError(parent_vm, "Cannot pass unsupported type to nested VM (functions, structs, enums not supported)");
+                failed = true;
+                break;
+            }
+        }
+        if (!failed && !pool_enqueue(pool, call)) {
+            zym_runtimeError(parent_vm, "Out of memory");
+            failed = true;
+        }
+        if (failed) {
+            async_call_release(call);
+            break;
+        }
+        calls[queued++] = call;
+    }
+
+    ZymValue results = zym_newList(parent_vm);
+    zym_pushRoot(parent_vm, results);
+
+    // Every queued chunk is waited for, even after a failure, so no task
+    // outlives the `calls` array
+    for (int c = 0; c < queued; c++) {
+        AsyncCall* call = calls[c];
+        mutex_lock(&call->lock);
+        while (!call->done) {
+            condvar_wait(&call->done_cond, &call->lock);
+        }
+        mutex_unlock(&call->lock);
+
+        if (!failed && !call->ok) {
+            zym_runtimeError(parent_vm, "map() batch for '%s' failed in a pool VM: %s", name,
+                             call->result.error ? call->result.error : "could not read its arguments");
+            failed = true;
+        }
+        size_t offset = 0;
+        for (int i = 0; !failed && i < call->batch; i++) {
+            ZymValue item = marshal_unpack(parent_vm, &call->result, &offset);
+            if (item == ZYM_ERROR) {
+                zym_runtimeError(parent_vm, "Failed to unmarshal map() result");
+                failed = true;
+                break;
+            }
+            zym_listAppend(parent_vm, results, item);
+        }
+        async_call_release(call);
+    }
+    free(calls);
+
+    zym_popRoot(parent_vm);  // results
+    return failed ? ZYM_ERROR : results;
+}
+
+ZymValue zymvmpool_map_2(ZymVM* parent_vm, ZymValue context, ZymValue nameVal, ZymValue listVal) {
+    return zymvmpool_map(parent_vm, context, nameVal, listVal, zym_newNull());
+}
+
+ZymValue zymvmpool_size(ZymVM* parent_vm, ZymValue context) {
+    VMPool* pool = (VMPool*)zym_getNativeData(context);
+    return zym_newNumber((double)pool->worker_count);
+}
+
+ZymValue zymvmpool_shutdown(ZymVM* parent_vm, ZymValue context) {
+    VMPool* pool = (VMPool*)zym_getNativeData(context);
+    pool_stop(pool);
+    return context;
+}
+
+ZymValue nativeZymVMPool_create(ZymVM* vm, ZymValue bufferVal, ZymValue optionsVal) {
+    if (!zym_isMap(bufferVal)) {
+        zym_runtimeError(vm, "ZymVMPool() requires a bytecode Buffer");
+        return ZYM_ERROR;
+    }
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
+        zym_runtimeError(vm, "Invalid Buffer object");
+        return ZYM_ERROR;
+    }
+    if (!buffer_check_readable(vm, buf)) {
+        return ZYM_ERROR;
+    }
+
+    int workers = 0;
+    if (zym_isMap(optionsVal)) {
+        ZymValue workersVal = zym_mapGet(vm, optionsVal, "workers");
+        if (zym_isNumber(workersVal)) {
+            workers = (int)zym_asNumber(workersVal);
+        }
+    }
+    if (workers <= 0) {
+        workers = thread_cpu_count();
+    }
+    if (workers > 256) {
+        workers = 256;
+    }
+
+    VMPool* pool = calloc(1, sizeof(VMPool));
+    if (!pool) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    pool->workers = calloc((size_t)workers, sizeof(PoolWorker));
+    pool->bytecode = malloc(buf->length > 0 ? buf->length : 1);
+    if (!pool->workers || !pool->bytecode) {
+        free(pool->workers);
+        free(pool->bytecode);
+        free(pool);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    memcpy(pool->bytecode, buf->data, buf->length);
+    pool->bytecode_size = buf->length;
+    mutex_init(&pool->lock);
+    condvar_init(&pool->work_cond);
+    condvar_init(&pool->ready_cond);
+
+    for (int i = 0; i < workers; i++) {
+        PoolWorker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        pool_deque_init(&worker->deque);
+    }
+
+    // Workers load their VMs in parallel; wait until all have reported
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        mutex_lock(&pool->lock);
+        pool->running++;
+        mutex_unlock(&pool->lock);
+        if (!thread_start(&pool->workers[i].thread, pool_worker_main, &pool->workers[i])) {
+            mutex_lock(&pool->lock);
+            pool->running--;
+            mutex_unlock(&pool->lock);
+            break;
+        }
+        started++;
+    }
+    pool->worker_count = started;
+
+    mutex_lock(&pool->lock);
+    while (pool->loaded < started) {
+        condvar_wait(&pool->ready_cond, &pool->lock);
+    }
+    mutex_unlock(&pool->lock);
+
+    bool all_loaded = started == workers;
+    for (int i = 0; i < started; i++) {
+        all_loaded = all_loaded && pool->workers[i].load_ok;
+    }
+    if (!all_loaded) {
+        pool_stop(pool);
+        pool->worker_count = workers;  // Free every deque
+        pool_free(pool);
+        zym_runtimeError(vm, "ZymVMPool() failed to start %d workers from the bytecode", workers);
+        return ZYM_ERROR;
+    }
+
+    ZymValue context = zym_createNativeContext(vm, pool, zymvmpool_cleanup);
+    zym_pushRoot(vm, context);
+
+    #define CREATE_METHOD(name, func, sig) \
+        ZymValue name = zym_createNativeClosure(vm, sig, func, context); \
+        zym_pushRoot(vm, name);
+
+    CREATE_METHOD(submit_1, zymvmpool_submit_1, "submit(name)");
+    CREATE_METHOD(submit_2, zymvmpool_submit, "submit(name, args)");
+    CREATE_METHOD(map_2, zymvmpool_map_2, "map(name, list)");
+    CREATE_METHOD(map_3, zymvmpool_map, "map(name, list, chunkSize)");
+    CREATE_METHOD(size, zymvmpool_size, "size()");
+    CREATE_METHOD(shutdown, zymvmpool_shutdown, "shutdown()");
+
+    #undef CREATE_METHOD
+
+    ZymValue submit_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, submit_dispatcher);
+    zym_addOverload(vm, submit_dispatcher, submit_1);
+    zym_addOverload(vm, submit_dispatcher, submit_2);
+
+    ZymValue map_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, map_dispatcher);
+    zym_addOverload(vm, map_dispatcher, map_2);
+    zym_addOverload(vm, map_dispatcher, map_3);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "submit", submit_dispatcher);
+    zym_mapSet(vm, obj, "map", map_dispatcher);
+    zym_mapSet(vm, obj, "size", size);
+    zym_mapSet(vm, obj, "shutdown", shutdown);
+
+    // (context + 6 methods + 2 dispatchers + obj = 10)
+    for (int i = 0; i < 10; i++) {
         zym_popRoot(vm);
     }
 
     return obj;
 }
+
+ZymValue nativeZymVMPool_create_1(ZymVM* vm, ZymValue bufferVal) {
+    return nativeZymVMPool_create(vm, bufferVal, zym_newNull());
+}
@@ -2,21 +2,37 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <limits.h>
+#include <time.h>
 #include "./natives.h"
+#include "./buffer.h"
+#include "./thread.h"
+
+// A thread blocked in wait() on one slot of a SharedBuffer
+typedef struct BufferWaiter {
+    size_t offset;
+    bool notified;
+    struct BufferWaiter* next;
+} BufferWaiter;
+
+struct BufferShared {
+    atomic_int refs;
+    uint8_t* data;
 
-typedef enum {
-    ENDIAN_LITTLE,
-    ENDIAN_BIG
-} Endianness;
+    // SharedBuffer(): every view may write, and wait()/notify() park on
+    // this block. A frozen share() block is read-only and has none of it.
+    bool writable;
+    Mutex wait_lock;
+    CondVar wait_cond;
+    BufferWaiter* waiters;
 
-typedef struct {
-    uint8_t* data;
-    size_t capacity;
-    size_t length;
-    size_t position;
-    bool auto_grow;
-    Endianness endianness;
-} BufferData;
+    // The block stays charged to the VM that allocated it until that VM's
+    // own view is collected
+    ZymVM* charged_vm;
+    size_t charged;
+};
 
 static inline uint16_t swap_uint16(uint16_t val) {
     return (val << 8) | (val >> 8);
@@ -45,13 +61,69 @@ static bool is_little_endian() {
     return *((uint8_t*)&test) == 1;
 }
 
+void buffer_shared_retain(BufferShared* shared) {
+    atomic_fetch_add_explicit(&shared->refs, 1, memory_order_relaxed);
+}
+
+void buffer_shared_release(BufferShared* shared) {
+    if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) == 1) {
+        if (shared->writable) {
+            mutex_destroy(&shared->wait_lock);
+            condvar_destroy(&shared->wait_cond);
+        }
+        free(shared->data);
+        free(shared);
+    }
+}
+
 void buffer_cleanup(ZymVM* vm, void* ptr) {
     BufferData* buf = (BufferData*)ptr;
-    free(buf->data);
+    if (buf->shared) {
+        if (buf->shared->charged_vm == vm && buf->shared->charged > 0) {
+            zymvm_quota_release_buffer(vm, buf->shared->charged);
+            buf->shared->charged = 0;
+        }
+        buffer_shared_release(buf->shared);
+    } else {
+        free(buf->data);
+        zymvm_quota_release_buffer(vm, buf->capacity);
+    }
     free(buf);
 }
 
-static bool ensure_capacity(ZymVM* vm, BufferData* buf, size_t needed) {
+BufferData* buffer_from_value(ZymVM* vm, ZymValue value) {
+    if (!zym_isMap(value)) {
+        return NULL;
+    }
+    // Channels also have getLength(), so key on a method only Buffers have
+    ZymValue getEndianness = zym_mapGet(vm, value, "getEndianness");
+    if (zym_isNull(getEndianness)) {
+        return NULL;
+    }
+    return (BufferData*)zym_getNativeData(zym_getClosureContext(getEndianness));
+}
+
+bool buffer_check_readable(ZymVM* vm, BufferData* buf) {
+    if (!buf->data) {
+        zym_runtimeError(vm, "Buffer has been transferred to another VM");
+        return false;
+    }
+    return true;
+}
+
+bool buffer_check_writable(ZymVM* vm, BufferData* buf) {
+    if (buf->read_only) {
+        zym_runtimeError(vm, "Buffer is shared and read-only");
+        return false;
+    }
+    return buffer_check_readable(vm, buf);
+}
+
+bool buffer_reserve(ZymVM* vm, BufferData* buf, size_t needed) {
+    if (!buffer_check_writable(vm, buf)) {
+        return false;
+    }
+
     size_t required = buf->position + needed;
 
     if (required <= buf->capacity) {
@@ -69,13 +141,18 @@ static bool ensure_capacity(ZymVM* vm, BufferData* buf, size_t needed) {
         new_capacity = required;
     }
 
-    if (new_capacity > 100 * 1024 * 1024) {
+    if (new_capacity > BUFFER_MAX_SIZE) {
         zym_runtimeError(vm, "Buffer exceeded maximum size (100MB)");
         return false;
     }
 
+    if (!zymvm_quota_charge_buffer(vm, new_capacity - buf->capacity)) {
+        return false;
+    }
+
     uint8_t* new_data = realloc(buf->data, new_capacity);
     if (!new_data) {
+        zymvm_quota_release_buffer(vm, new_capacity - buf->capacity);
         zym_runtimeError(vm, "Out of memory (failed to allocate %zu bytes)", new_capacity);
         return false;
     }
@@ -87,6 +164,46 @@ static bool ensure_capacity(ZymVM* vm, BufferData* buf, size_t needed) {
     return true;
 }
 
+bool buffer_write_bytes(ZymVM* vm, BufferData* buf, const void* bytes, size_t length) {
+    if (!buffer_reserve(vm, buf, length)) {
+        return false;
+    }
+    memcpy(buf->data + buf->position, bytes, length);
+    buf->position += length;
+    if (buf->position > buf->length) {
+        buf->length = buf->position;
+    }
+    return true;
+}
+
+size_t buffer_try_reserve(ZymVM* vm, BufferData* buf, size_t needed) {
+    // Views of a shared block never grow: the block is not theirs to move
+    if (buf->read_only || !buf->data) {
+        return 0;
+    }
+
+    size_t required = buf->position + needed;
+    if (required > buf->capacity && buf->auto_grow && !buf->shared) {
+        size_t new_capacity = buf->capacity + (buf->capacity >> 1);
+        if (new_capacity < required) new_capacity = required;
+        if (new_capacity > BUFFER_MAX_SIZE) new_capacity = BUFFER_MAX_SIZE;
+        if (new_capacity > buf->capacity &&
+            zymvm_quota_try_charge_buffer(vm, new_capacity - buf->capacity)) {
+            uint8_t* new_data = realloc(buf->data, new_capacity);
+            if (new_data) {
+                memset(new_data + buf->capacity, 0, new_capacity - buf->capacity);
+                buf->data = new_data;
+                buf->capacity = new_capacity;
+            } else {
+                zymvm_quota_release_buffer(vm, new_capacity - buf->capacity);
+            }
+        }
+    }
+
+    size_t room = buf->capacity > buf->position ? buf->capacity - buf->position : 0;
+    return room < needed ? room : needed;
+}
+
 static inline void update_length(BufferData* buf) {
     if (buf->position > buf->length) {
         buf->length = buf->position;
@@ -347,7 +464,7 @@ ZymValue buffer_writeUInt8(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 1)) {
+    if (!buffer_reserve(vm, buf, 1)) {
         return ZYM_ERROR;
     }
 
@@ -364,7 +481,7 @@ ZymValue buffer_writeInt8(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 1)) {
+    if (!buffer_reserve(vm, buf, 1)) {
         return ZYM_ERROR;
     }
 
@@ -381,7 +498,7 @@ ZymValue buffer_writeUInt16(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 2)) {
+    if (!buffer_reserve(vm, buf, 2)) {
         return ZYM_ERROR;
     }
 
@@ -408,7 +525,7 @@ ZymValue buffer_writeInt16(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 2)) {
+    if (!buffer_reserve(vm, buf, 2)) {
         return ZYM_ERROR;
     }
 
@@ -435,7 +552,7 @@ ZymValue buffer_writeUInt32(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 4)) {
+    if (!buffer_reserve(vm, buf, 4)) {
         return ZYM_ERROR;
     }
 
@@ -462,7 +579,7 @@ ZymValue buffer_writeInt32(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 4)) {
+    if (!buffer_reserve(vm, buf, 4)) {
         return ZYM_ERROR;
     }
 
@@ -489,7 +606,7 @@ ZymValue buffer_writeFloat(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 4)) {
+    if (!buffer_reserve(vm, buf, 4)) {
         return ZYM_ERROR;
     }
 
@@ -518,7 +635,7 @@ ZymValue buffer_writeDouble(ZymVM* vm, ZymValue context, ZymValue valVal) {
         return ZYM_ERROR;
     }
 
-    if (!ensure_capacity(vm, buf, 8)) {
+    if (!buffer_reserve(vm, buf, 8)) {
         return ZYM_ERROR;
     }
 
@@ -548,7 +665,7 @@ ZymValue buffer_writeBytes(ZymVM* vm, ZymValue context, ZymValue listVal) {
     }
 
     size_t count = zym_listLength(listVal);
-    if (!ensure_capacity(vm, buf, count)) {
+    if (!buffer_reserve(vm, buf, count)) {
         return ZYM_ERROR;
     }
 
@@ -576,7 +693,7 @@ ZymValue buffer_writeString(ZymVM* vm, ZymValue context, ZymValue strVal) {
     const char* str = zym_asCString(strVal);
     size_t len = strlen(str) + 1;  // Include null terminator
 
-    if (!ensure_capacity(vm, buf, len)) {
+    if (!buffer_reserve(vm, buf, len)) {
         return ZYM_ERROR;
     }
 
@@ -597,7 +714,7 @@ ZymValue buffer_writeStringRaw(ZymVM* vm, ZymValue context, ZymValue strVal) {
     const char* str = zym_asCString(strVal);
     size_t len = strlen(str);
 
-    if (!ensure_capacity(vm, buf, len)) {
+    if (!buffer_reserve(vm, buf, len)) {
         return ZYM_ERROR;
     }
 
@@ -669,6 +786,9 @@ ZymValue buffer_rewind(ZymVM* vm, ZymValue context) {
 
 ZymValue buffer_clear(ZymVM* vm, ZymValue context) {
     BufferData* buf = (BufferData*)zym_getNativeData(context);
+    if (!buffer_check_writable(vm, buf)) {
+        return ZYM_ERROR;
+    }
     memset(buf->data, 0, buf->capacity);
     buf->length = 0;
     buf->position = 0;
@@ -683,6 +803,10 @@ ZymValue buffer_fill(ZymVM* vm, ZymValue context, ZymValue byteVal) {
         return ZYM_ERROR;
     }
 
+    if (!buffer_check_writable(vm, buf)) {
+        return ZYM_ERROR;
+    }
+
     uint8_t byte = (uint8_t)zym_asNumber(byteVal);
     memset(buf->data, byte, buf->capacity);
     buf->length = buf->capacity;
@@ -830,6 +954,9 @@ ZymValue buffer_setLength(ZymVM* vm, ZymValue context, ZymValue lenVal) {
         zym_runtimeError(vm, "setLength() requires a number argument");
         return ZYM_ERROR;
     }
+    if (!buffer_check_writable(vm, buf)) {
+        return ZYM_ERROR;
+    }
     size_t new_len = (size_t)zym_asNumber(lenVal);
     if (new_len > buf->capacity) {
         new_len = buf->capacity;
@@ -838,6 +965,317 @@ ZymValue buffer_setLength(ZymVM* vm, ZymValue context, ZymValue lenVal) {
     return context;
 }
 
+// Marks the storage to be moved rather than copied the next time this
+// Buffer is passed to or returned from another VM
+ZymValue buffer_transfer(ZymVM* vm, ZymValue context) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    if (buf->shared) {
+        zym_runtimeError(vm, "Cannot transfer a shared Buffer");
+        return ZYM_ERROR;
+    }
+    if (!buf->data) {
+        zym_runtimeError(vm, "Buffer has been transferred to another VM");
+        return ZYM_ERROR;
+    }
+    buf->transfer_pending = true;
+    return zym_newNull();
+}
+
+// Freezes the Buffer. From then on other VMs receive a read-only view of the
+// same bytes instead of a copy.
+ZymValue buffer_share(ZymVM* vm, ZymValue context) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    if (buf->shared) {
+        return zym_newNull();
+    }
+    if (!buf->data) {
+        zym_runtimeError(vm, "Buffer has been transferred to another VM");
+        return ZYM_ERROR;
+    }
+
+    BufferShared* shared = calloc(1, sizeof(BufferShared));
+    if (!shared) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    atomic_init(&shared->refs, 1);
+    shared->data = buf->data;
+    shared->charged_vm = vm;
+    shared->charged = buf->capacity;
+
+    buf->shared = shared;
+    buf->read_only = true;
+    buf->auto_grow = false;
+    buf->transfer_pending = false;
+    return zym_newNull();
+}
+
+ZymValue buffer_isShared(ZymVM* vm, ZymValue context) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    return zym_newBool(buf->shared != NULL);
+}
+
+// ---- SharedBuffer atomics ------------------------------------------------------
+// Slots are addressed by byte offset and must be naturally aligned. Values
+// are signed; 64-bit slots are exact up to 2^53 since script numbers are
+// doubles.
+
+static double buffer_now_ms(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static void* atomic_slot(ZymVM* vm, ZymValue context, ZymValue offsetVal, size_t width, const char* name) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    if (!zym_isNumber(offsetVal)) {
+        zym_runtimeError(vm, "%s() requires a numeric byte offset", name);
+        return NULL;
+    }
+    double offset = zym_asNumber(offsetVal);
+    if (!isfinite(offset) || offset < 0 || offset + (double)width > (double)buf->capacity ||
+        (size_t)offset % width != 0) {
+        zym_runtimeError(vm, "%s() offset %g must be a multiple of %zu inside the buffer", name, offset, width);
+        return NULL;
+    }
+    return buf->data + (size_t)offset;
+}
+
+// Converts a script number for a slot `width` bytes wide. Fractions are
+// truncated; values the slot cannot hold (or NaN/infinity) raise an error
+// rather than reaching the conversion, which would be undefined.
+static bool atomic_arg(ZymVM* vm, ZymValue val, size_t width, const char* name, int64_t* out) {
+    if (!zym_isNumber(val)) {
+        zym_runtimeError(vm, "%s() requires numeric values", name);
+        return false;
+    }
+    double number = zym_asNumber(val);
+    double limit = width == 4 ? 2147483648.0 : 9223372036854775808.0;
+    if (!isfinite(number) || number < -limit || number >= limit) {
+        zym_runtimeError(vm, "%s() value %g does not fit a %zu-bit slot", name, number, width * 8);
+        return false;
+    }
+    *out = (int64_t)number;
+    return true;
+}
+
+ZymValue buffer_atomicLoad32(ZymVM* vm, ZymValue context, ZymValue offsetVal) {
+    _Atomic int32_t* slot = atomic_slot(vm, context, offsetVal, 4, "atomicLoad32");
+    if (!slot) return ZYM_ERROR;
+    return zym_newNumber((double)atomic_load(slot));
+}
+
+ZymValue buffer_atomicStore32(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue valueVal) {
+    _Atomic int32_t* slot = atomic_slot(vm, context, offsetVal, 4, "atomicStore32");
+    int64_t value;
+    if (!slot || !atomic_arg(vm, valueVal, 4, "atomicStore32", &value)) return ZYM_ERROR;
+    atomic_store(slot, (int32_t)value);
+    return zym_newNull();
+}
+
+// Returns the value before the add
+ZymValue buffer_atomicAdd32(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue valueVal) {
+    _Atomic int32_t* slot = atomic_slot(vm, context, offsetVal, 4, "atomicAdd32");
+    int64_t value;
+    if (!slot || !atomic_arg(vm, valueVal, 4, "atomicAdd32", &value)) return ZYM_ERROR;
+    return zym_newNumber((double)atomic_fetch_add(slot, (int32_t)value));
+}
+
+// Stores replacement if the slot holds expected. Returns the value that was
+// there either way, so success is `result == expected`.
+ZymValue buffer_atomicCompareExchange32(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue expectedVal, ZymValue replacementVal) {
+    _Atomic int32_t* slot = atomic_slot(vm, context, offsetVal, 4, "atomicCompareExchange32");
+    int64_t expected_arg, replacement;
+    if (!slot || !atomic_arg(vm, expectedVal, 4, "atomicCompareExchange32", &expected_arg) ||
+        !atomic_arg(vm, replacementVal, 4, "atomicCompareExchange32", &replacement)) {
+        return ZYM_ERROR;
+    }
+    int32_t expected = (int32_t)expected_arg;
+    atomic_compare_exchange_strong(slot, &expected, (int32_t)replacement);
+    return zym_newNumber((double)expected);
+}
+
+ZymValue buffer_atomicLoad64(ZymVM* vm, ZymValue context, ZymValue offsetVal) {
+    _Atomic int64_t* slot = atomic_slot(vm, context, offsetVal, 8, "atomicLoad64");
+    if (!slot) return ZYM_ERROR;
+    return zym_newNumber((double)atomic_load(slot));
+}
+
+ZymValue buffer_atomicStore64(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue valueVal) {
+    _Atomic int64_t* slot = atomic_slot(vm, context, offsetVal, 8, "atomicStore64");
+    int64_t value;
+    if (!slot || !atomic_arg(vm, valueVal, 8, "atomicStore64", &value)) return ZYM_ERROR;
+    atomic_store(slot, value);
+    return zym_newNull();
+}
+
+ZymValue buffer_atomicAdd64(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue valueVal) {
+    _Atomic int64_t* slot = atomic_slot(vm, context, offsetVal, 8, "atomicAdd64");
+    int64_t value;
+    if (!slot || !atomic_arg(vm, valueVal, 8, "atomicAdd64", &value)) return ZYM_ERROR;
+    return zym_newNumber((double)atomic_fetch_add(slot, value));
+}
+
+ZymValue buffer_atomicCompareExchange64(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue expectedVal, ZymValue replacementVal) {
+    _Atomic int64_t* slot = atomic_slot(vm, context, offsetVal, 8, "atomicCompareExchange64");
+    int64_t expected, replacement;
+    if (!slot || !atomic_arg(vm, expectedVal, 8, "atomicCompareExchange64", &expected) ||
+        !atomic_arg(vm, replacementVal, 8, "atomicCompareExchange64", &replacement)) {
+        return ZYM_ERROR;
+    }
+    atomic_compare_exchange_strong(slot, &expected, replacement);
+    return zym_newNumber((double)expected);
+}
+
+// Sleeps while the 32-bit slot holds expected, until notify() on the same
+// offset or the timeout. Returns "ok", "not-equal" or "timed-out". The
+// check and the sleep happen under the block's lock, so a store followed by
+// notify() cannot slip in between them.
+ZymValue buffer_wait(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue expectedVal, ZymValue timeoutVal) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    BufferShared* shared = buf->shared;
+    _Atomic int32_t* slot = atomic_slot(vm, context, offsetVal, 4, "wait");
+    int64_t expected;
+    if (!slot || !atomic_arg(vm, expectedVal, 4, "wait", &expected)) return ZYM_ERROR;
+
+    // Negative or NaN waits not at all; past what a long holds, forever
+    long timeout_ms = -1;
+    if (zym_isNumber(timeoutVal)) {
+        double timeout = zym_asNumber(timeoutVal);
+        if (!(timeout >= 0)) timeout_ms = 0;
+        else if (timeout < (double)LONG_MAX) timeout_ms = (long)timeout;
+    }
+    double deadline_ms = timeout_ms < 0 ? -1 : buffer_now_ms() + (double)timeout_ms;
+
+    mutex_lock(&shared->wait_lock);
+    if (atomic_load(slot) != (int32_t)expected) {
+        mutex_unlock(&shared->wait_lock);
+        return zym_newString(vm, "not-equal");
+    }
+
+    BufferWaiter waiter = { .offset = (size_t)((uint8_t*)slot - buf->data), .notified = false, .next = shared->waiters };
+    shared->waiters = &waiter;
+    while (!waiter.notified) {
+        long remaining = -1;
+        if (deadline_ms >= 0) {
+            double left = deadline_ms - buffer_now_ms();
+            if (left <= 0) break;
+            remaining = (long)left + 1;
+        }
+        condvar_wait_ms(&shared->wait_cond, &shared->wait_lock, remaining);
+    }
+    if (!waiter.notified) {
+        BufferWaiter** link = &shared->waiters;
+        while (*link != &waiter) {
+            link = &(*link)->next;
+        }
+        *link = waiter.next;
+    }
+    mutex_unlock(&shared->wait_lock);
+
+    return zym_newString(vm, waiter.notified ? "ok" : "timed-out");
+}
+
+ZymValue buffer_wait_2(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue expectedVal) {
+    return buffer_wait(vm, context, offsetVal, expectedVal, zym_newNull());
+}
+
+// Wakes up to count threads waiting on offset (all of them by default) and
+// returns how many were woken
+ZymValue buffer_notify(ZymVM* vm, ZymValue context, ZymValue offsetVal, ZymValue countVal) {
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    BufferShared* shared = buf->shared;
+    uint8_t* slot = atomic_slot(vm, context, offsetVal, 4, "notify");
+    if (!slot) return ZYM_ERROR;
+    size_t offset = (size_t)(slot - buf->data);
+
+    double count = zym_isNumber(countVal) ? zym_asNumber(countVal) : -1;
+    int woken = 0;
+
+    mutex_lock(&shared->wait_lock);
+    BufferWaiter** link = &shared->waiters;
+    while (*link && (count < 0 || woken < count)) {
+        BufferWaiter* waiter = *link;
+        if (waiter->offset == offset) {
+            waiter->notified = true;
+            *link = waiter->next;
+            woken++;
+        } else {
+            link = &waiter->next;
+        }
+    }
+    if (woken > 0) {
+        condvar_broadcast(&shared->wait_cond);
+    }
+    mutex_unlock(&shared->wait_lock);
+
+    return zym_newNumber((double)woken);
+}
+
+ZymValue buffer_notify_1(ZymVM* vm, ZymValue context, ZymValue offsetVal) {
+    return buffer_notify(vm, context, offsetVal, zym_newNull());
+}
+
+// Adds the atomic methods to a Buffer object whose storage is a SharedBuffer
+static void buffer_add_atomics(ZymVM* vm, ZymValue obj, ZymValue context) {
+    zym_pushRoot(vm, obj);
+
+    #define CREATE_METHOD(name, func, sig) \
+        ZymValue name = zym_createNativeClosure(vm, sig, func, context); \
+        zym_pushRoot(vm, name);
+
+    CREATE_METHOD(atomicLoad32, buffer_atomicLoad32, "atomicLoad32(offset)");
+    CREATE_METHOD(atomicStore32, buffer_atomicStore32, "atomicStore32(offset, value)");
+    CREATE_METHOD(atomicAdd32, buffer_atomicAdd32, "atomicAdd32(offset, value)");
+    CREATE_METHOD(atomicCompareExchange32, buffer_atomicCompareExchange32, "atomicCompareExchange32(offset, expected, replacement)");
+    CREATE_METHOD(atomicLoad64, buffer_atomicLoad64, "atomicLoad64(offset)");
+    CREATE_METHOD(atomicStore64, buffer_atomicStore64, "atomicStore64(offset, value)");
+    CREATE_METHOD(atomicAdd64, buffer_atomicAdd64, "atomicAdd64(offset, value)");
+    CREATE_METHOD(atomicCompareExchange64, buffer_atomicCompareExchange64, "atomicCompareExchange64(offset, expected, replacement)");
+    CREATE_METHOD(wait_2, buffer_wait_2, "wait(offset, expected)");
+    CREATE_METHOD(wait_3, buffer_wait, "wait(offset, expected, timeoutMs)");
+    CREATE_METHOD(notify_1, buffer_notify_1, "notify(offset)");
+    CREATE_METHOD(notify_2, buffer_notify, "notify(offset, count)");
+
+    #undef CREATE_METHOD
+
+    ZymValue wait_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, wait_dispatcher);
+    zym_addOverload(vm, wait_dispatcher, wait_2);
+    zym_addOverload(vm, wait_dispatcher, wait_3);
+
+    ZymValue notify_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, notify_dispatcher);
+    zym_addOverload(vm, notify_dispatcher, notify_1);
+    zym_addOverload(vm, notify_dispatcher, notify_2);
+
+    zym_mapSet(vm, obj, "atomicLoad32", atomicLoad32);
+    zym_mapSet(vm, obj, "atomicStore32", atomicStore32);
+    zym_mapSet(vm, obj, "atomicAdd32", atomicAdd32);
+    zym_mapSet(vm, obj, "atomicCompareExchange32", atomicCompareExchange32);
+    zym_mapSet(vm, obj, "atomicLoad64", atomicLoad64);
+    zym_mapSet(vm, obj, "atomicStore64", atomicStore64);
+    zym_mapSet(vm, obj, "atomicAdd64", atomicAdd64);
+    zym_mapSet(vm, obj, "atomicCompareExchange64", atomicCompareExchange64);
+    zym_mapSet(vm, obj, "wait", wait_dispatcher);
+    zym_mapSet(vm, obj, "notify", notify_dispatcher);
+
+    // (obj + 12 methods + 2 dispatchers = 15)
+    for (int i = 0; i < 15; i++) {
+        zym_popRoot(vm);
+    }
+}
+
 ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal) {
     if (!zym_isNumber(sizeVal)) {
         zym_runtimeError(vm, "Buffer() requires a number argument");
@@ -845,7 +1283,7 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
     }
 
     size_t size = (size_t)zym_asNumber(sizeVal);
-    if (size == 0 || size > 100 * 1024 * 1024) {
+    if (size == 0 || size > BUFFER_MAX_SIZE) {
         zym_runtimeError(vm, "Buffer size must be between 1 and 104857600 bytes (100MB)");
         return ZYM_ERROR;
     }
@@ -855,8 +1293,13 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
         auto_grow = zym_asBool(autoGrowVal);
     }
 
+    if (!zymvm_quota_charge_buffer(vm, size)) {
+        return ZYM_ERROR;
+    }
+
     BufferData* buf = calloc(1, sizeof(BufferData));
     if (!buf) {
+        zymvm_quota_release_buffer(vm, size);
         zym_runtimeError(vm, "Out of memory");
         return ZYM_ERROR;
     }
@@ -864,6 +1307,7 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
     buf->data = calloc(size, 1);
     if (!buf->data) {
         free(buf);
+        zymvm_quota_release_buffer(vm, size);
         zym_runtimeError(vm, "Out of memory");
         return ZYM_ERROR;
     }
@@ -929,6 +1373,9 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
     CREATE_METHOD_0(toString, buffer_toString);
     CREATE_METHOD_0(getEndianness, buffer_getEndianness);
     CREATE_METHOD_1(setEndianness, buffer_setEndianness);
+    CREATE_METHOD_0(transfer, buffer_transfer);
+    CREATE_METHOD_0(share, buffer_share);
+    CREATE_METHOD_0(isShared, buffer_isShared);
 
     #undef CREATE_METHOD_0
     #undef CREATE_METHOD_1
@@ -977,9 +1424,12 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
     zym_mapSet(vm, obj, "toString", toString);
     zym_mapSet(vm, obj, "getEndianness", getEndianness);
     zym_mapSet(vm, obj, "setEndianness", setEndianness);
+    zym_mapSet(vm, obj, "transfer", transfer);
+    zym_mapSet(vm, obj, "share", share);
+    zym_mapSet(vm, obj, "isShared", isShared);
 
-    // (36 methods + context + obj = 38 total)
-    for (int i = 0; i < 38; i++) {
+    // (39 methods + context + obj = 41 total)
+    for (int i = 0; i < 41; i++) {
         zym_popRoot(vm);
     }
 
@@ -989,3 +1439,68 @@ ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal)
 ZymValue nativeBuffer_create_auto(ZymVM* vm, ZymValue lengthVal) {
     return nativeBuffer_create(vm, lengthVal, zym_newBool(true));
 }
+
+ZymValue nativeBuffer_adopt(ZymVM* vm, uint8_t* data, size_t capacity, size_t length, size_t position,
+                            bool auto_grow, int endianness, BufferShared* shared) {
+    // Moved storage becomes this VM's; shared blocks stay charged to the
+    // VM that allocated them
+    if (!shared && !zymvm_quota_charge_buffer(vm, capacity)) {
+        return ZYM_ERROR;
+    }
+    ZymValue obj = nativeBuffer_create(vm, zym_newNumber(1), zym_newBool(auto_grow));
+    if (obj == ZYM_ERROR) {
+        if (!shared) zymvm_quota_release_buffer(vm, capacity);
+        return ZYM_ERROR;
+    }
+
+    ZymValue getLength = zym_mapGet(vm, obj, "getLength");
+    BufferData* buf = (BufferData*)zym_getNativeData(zym_getClosureContext(getLength));
+    free(buf->data);
+    zymvm_quota_release_buffer(vm, buf->capacity);
+
+    buf->data = data;
+    buf->capacity = capacity;
+    buf->length = length;
+    buf->position = position <= length ? position : length;
+    buf->endianness = endianness == ENDIAN_BIG ? ENDIAN_BIG : ENDIAN_LITTLE;
+    if (shared) {
+        buffer_shared_retain(shared);
+        buf->shared = shared;
+        buf->read_only = !shared->writable;
+        buf->auto_grow = false;
+        if (shared->writable) {
+            buffer_add_atomics(vm, obj, zym_getClosureContext(getLength));
+        }
+    }
+    return obj;
+}
+
+ZymValue nativeSharedBuffer_create(ZymVM* vm, ZymValue sizeVal) {
+    ZymValue obj = nativeBuffer_create(vm, sizeVal, zym_newBool(false));
+    if (obj == ZYM_ERROR) {
+        return ZYM_ERROR;
+    }
+
+    ZymValue context = zym_getClosureContext(zym_mapGet(vm, obj, "getLength"));
+    BufferData* buf = (BufferData*)zym_getNativeData(context);
+
+    BufferShared* shared = calloc(1, sizeof(BufferShared));
+    if (!shared) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    atomic_init(&shared->refs, 1);
+    shared->data = buf->data;
+    shared->charged_vm = vm;
+    shared->charged = buf->capacity;
+    shared->writable = true;
+    mutex_init(&shared->wait_lock);
+    condvar_init(&shared->wait_cond);
+
+    // The memory is a fixed array, so every view sees all of it
+    buf->shared = shared;
+    buf->length = buf->capacity;
+
+    buffer_add_atomics(vm, obj, context);
+    return obj;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "zym/zym.h"
+
+#define BUFFER_MAX_SIZE (100 * 1024 * 1024)
+
+typedef enum {
+    ENDIAN_LITTLE,
+    ENDIAN_BIG
+} Endianness;
+
+// Storage behind a Buffer object. Other natives that read or fill Buffers
+// work on this directly; check it with buffer_check_readable() or
+// buffer_check_writable() first.
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+    size_t position;
+    bool auto_grow;
+    Endianness endianness;
+
+    // Set by transfer(): the next copy into another VM moves the storage out
+    // and leaves this Buffer empty (data == NULL) instead of copying it
+    bool transfer_pending;
+    // Set by share(): data belongs to `shared` and other VMs may be reading
+    // it concurrently, so nothing may write to it
+    bool read_only;
+    struct BufferShared* shared;
+} BufferData;
+
+// Returns the storage behind a Buffer object, or NULL for any other value.
+BufferData* buffer_from_value(ZymVM* vm, ZymValue value);
+
+// Raise a runtime error and return false when buf's storage has been
+// transferred to another VM, or (for writes) when it is read-only.
+bool buffer_check_readable(ZymVM* vm, BufferData* buf);
+bool buffer_check_writable(ZymVM* vm, BufferData* buf);
+
+// Makes room for `needed` bytes at buf->position, growing an auto-grow
+// Buffer the same way its own write methods do (100MB cap, charged to the
+// VM's buffer quota). Raises a runtime error and returns false otherwise.
+bool buffer_reserve(ZymVM* vm, BufferData* buf, size_t needed);
+// Copies bytes in at buf->position and advances it, extending the length.
+bool buffer_write_bytes(ZymVM* vm, BufferData* buf, const void* bytes, size_t length);
+// For writers that cannot raise (process output capture): grows buf toward
+// `needed` bytes at buf->position as far as its limits and the quota allow,
+// and returns how many of them fit. Read-only and transferred Buffers take
+// nothing and SharedBuffers never grow; the state is re-read on every call,
+// so callers should reserve before each write.
+size_t buffer_try_reserve(ZymVM* vm, BufferData* buf, size_t needed);
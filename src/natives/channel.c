@@ -0,0 +1,645 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <math.h>
+#include "./natives.h"
+#include "./channel.h"
+#include "./marshal.h"
+#include "./thread.h"
+
+#define CHANNEL_MAX_CAPACITY (1024 * 1024)
+
+// ---- Ring buffer ----------------------------------------------------------------
+// Bounded MPMC queue after Dmitry Vyukov: each cell carries a sequence number
+// that tells producers and consumers whose turn it is, so the fast path is a
+// single CAS on the head or tail. Threads only take `lock` to park when the
+// queue is full or empty.
+
+typedef struct {
+    atomic_size_t sequence;
+    MarshalBlob message;
+} ChannelCell;
+
+typedef struct ChannelSelect ChannelSelect;
+
+// A select() call waiting on this channel among others
+typedef struct ChannelSelectNode {
+    ChannelSelect* select;
+    struct ChannelSelectNode* next;
+} ChannelSelectNode;
+
+struct Channel {
+    atomic_int refs;
+
+    ChannelCell* cells;
+    size_t capacity;
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_bool closed;
+
+    // Parking for blocked senders and receivers. The waiter counts let the
+    // other side skip the lock entirely when nobody is asleep.
+    Mutex lock;
+    CondVar not_empty;
+    CondVar not_full;
+    atomic_int recv_waiters;
+    atomic_int send_waiters;
+    ChannelSelectNode* selects;
+};
+
+struct ChannelSelect {
+    Mutex lock;
+    CondVar cond;
+    bool signaled;
+};
+
+static atomic_uint channel_select_rotor;
+
+static double channel_now_ms(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
+// Milliseconds left before deadline_ms; -1 waits forever
+static long channel_remaining_ms(double deadline_ms) {
+    if (deadline_ms < 0) {
+        return -1;
+    }
+    double remaining = deadline_ms - channel_now_ms();
+    return remaining > 0 ? (long)remaining + 1 : 0;
+}
+
+static Channel* channel_new(size_t capacity) {
+    Channel* channel = calloc(1, sizeof(Channel));
+    if (!channel) {
+        return NULL;
+    }
+    channel->cells = calloc(capacity, sizeof(ChannelCell));
+    if (!channel->cells) {
+        free(channel);
+        return NULL;
+    }
+    channel->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&channel->cells[i].sequence, i);
+    }
+    atomic_init(&channel->refs, 1);
+    atomic_init(&channel->head, 0);
+    atomic_init(&channel->tail, 0);
+    atomic_init(&channel->closed, false);
+    atomic_init(&channel->recv_waiters, 0);
+    atomic_init(&channel->send_waiters, 0);
+    mutex_init(&channel->lock);
+    condvar_init(&channel->not_empty);
+    condvar_init(&channel->not_full);
+    return channel;
+}
+
+void channel_retain(Channel* channel) {
+    atomic_fetch_add_explicit(&channel->refs, 1, memory_order_relaxed);
+}
+
+void channel_release(Channel* channel) {
+    if (atomic_fetch_sub_explicit(&channel->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    // Nobody else can see the channel now, so whatever is still queued is ours
+    size_t head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    for (size_t pos = head; pos != tail; pos++) {
+        marshal_blob_free(&channel->cells[pos % channel->capacity].message);
+    }
+    mutex_destroy(&channel->lock);
+    condvar_destroy(&channel->not_empty);
+    condvar_destroy(&channel->not_full);
+    free(channel->cells);
+    free(channel);
+}
+
+static bool channel_try_push(Channel* channel, MarshalBlob* message) {
+    size_t pos = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    ChannelCell* cell;
+    for (;;) {
+        cell = &channel->cells[pos % channel->capacity];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&channel->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+        }
+    }
+    cell->message = *message;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool channel_try_pop(Channel* channel, MarshalBlob* out) {
+    size_t pos = atomic_load_explicit(&channel->head, memory_order_relaxed);
+    ChannelCell* cell;
+    for (;;) {
+        cell = &channel->cells[pos % channel->capacity];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&channel->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&channel->head, memory_order_relaxed);
+        }
+    }
+    *out = cell->message;
+    memset(&cell->message, 0, sizeof(cell->message));
+    atomic_store_explicit(&cell->sequence, pos + channel->capacity, memory_order_release);
+    return true;
+}
+
+static void channel_select_signal(ChannelSelect* select) {
+    mutex_lock(&select->lock);
+    select->signaled = true;
+    condvar_signal(&select->cond);
+    mutex_unlock(&select->lock);
+}
+
+// Called after a push. The fence pairs with the one a receiver issues after
+// registering, so either we see the waiter or it sees the message.
+static void channel_wake_receivers(Channel* channel) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&channel->recv_waiters, memory_order_relaxed) == 0) {
+        return;
+    }
+    mutex_lock(&channel->lock);
+    condvar_signal(&channel->not_empty);
+    for (ChannelSelectNode* node = channel->selects; node; node = node->next) {
+        channel_select_signal(node->select);
+    }
+    mutex_unlock(&channel->lock);
+}
+
+static void channel_wake_senders(Channel* channel) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&channel->send_waiters, memory_order_relaxed) == 0) {
+        return;
+    }
+    mutex_lock(&channel->lock);
+    condvar_signal(&channel->not_full);
+    mutex_unlock(&channel->lock);
+}
+
+// Returns false if the channel is closed or the timeout passes first. The
+// message is only consumed on success.
+static bool channel_push(Channel* channel, MarshalBlob* message, long timeout_ms) {
+    if (atomic_load(&channel->closed)) {
+        return false;
+    }
+    bool pushed = channel_try_push(channel, message);
+    if (!pushed && timeout_ms != 0) {
+        double deadline_ms = timeout_ms < 0 ? -1 : channel_now_ms() + (double)timeout_ms;
+        mutex_lock(&channel->lock);
+        atomic_fetch_add(&channel->send_waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        for (;;) {
+            if (atomic_load(&channel->closed)) {
+                break;
+            }
+            if ((pushed = channel_try_push(channel, message))) {
+                break;
+            }
+            long remaining = channel_remaining_ms(deadline_ms);
+            if (remaining == 0) {
+                break;
+            }
+            condvar_wait_ms(&channel->not_full, &channel->lock, remaining);
+        }
+        atomic_fetch_sub(&channel->send_waiters, 1);
+        mutex_unlock(&channel->lock);
+    }
+    if (pushed) {
+        channel_wake_receivers(channel);
+    }
+    return pushed;
+}
+
+// Returns false if the timeout passes first, or once the channel is closed
+// and drained.
+static bool channel_pop(Channel* channel, MarshalBlob* out, long timeout_ms) {
+    bool popped = channel_try_pop(channel, out);
+    if (!popped && timeout_ms != 0) {
+        double deadline_ms = timeout_ms < 0 ? -1 : channel_now_ms() + (double)timeout_ms;
+        mutex_lock(&channel->lock);
+        atomic_fetch_add(&channel->recv_waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        for (;;) {
+            if ((popped = channel_try_pop(channel, out))) {
+                break;
+            }
+            if (atomic_load(&channel->closed)) {
+                // A send may have landed just before close()
+                popped = channel_try_pop(channel, out);
+                break;
+            }
+            long remaining = channel_remaining_ms(deadline_ms);
+            if (remaining == 0) {
+                break;
+            }
+            condvar_wait_ms(&channel->not_empty, &channel->lock, remaining);
+        }
+        atomic_fetch_sub(&channel->recv_waiters, 1);
+        mutex_unlock(&channel->lock);
+    }
+    if (popped) {
+        channel_wake_senders(channel);
+    }
+    return popped;
+}
+
+static void channel_close(Channel* channel) {
+    mutex_lock(&channel->lock);
+    atomic_store(&channel->closed, true);
+    condvar_broadcast(&channel->not_empty);
+    condvar_broadcast(&channel->not_full);
+    for (ChannelSelectNode* node = channel->selects; node; node = node->next) {
+        channel_select_signal(node->select);
+    }
+    mutex_unlock(&channel->lock);
+}
+
+static size_t channel_length(Channel* channel) {
+    size_t head = atomic_load(&channel->head);
+    size_t tail = atomic_load(&channel->tail);
+    return tail > head ? tail - head : 0;
+}
+
+// ---- Script API -----------------------------------------------------------------
+
+// Longest finite wait, ~24.8 days; fits a 32-bit long and DWORD. Longer
+// timeouts (including infinity) wait forever.
+#define CHANNEL_MAX_TIMEOUT_MS 2147483647.0
+
+// A non-number (null) waits forever, negative timeouts don't wait at all.
+// Range-checked before the cast: NaN or an out-of-range double converted
+// to long is undefined.
+static bool channel_timeout_arg(ZymVM* vm, const char* method, ZymValue timeoutVal, long* timeout_ms) {
+    *timeout_ms = -1;
+    if (!zym_isNumber(timeoutVal)) {
+        return true;
+    }
+    double timeout = zym_asNumber(timeoutVal);
+    if (isnan(timeout)) {
+        zym_runtimeError(vm, "%s() timeout must be a number of milliseconds, not NaN", method);
+        return false;
+    }
+    if (timeout <= 0) {
+        *timeout_ms = 0;
+    } else if (timeout < CHANNEL_MAX_TIMEOUT_MS) {
+        *timeout_ms = (long)timeout;
+    }
+    return true;
+}
+
+static bool channel_pack_message(ZymVM* vm, ZymValue value, MarshalBlob* message) {
+    memset(message, 0, sizeof(*message));
+    if (!marshal_pack(vm, value, message)) {
+        marshal_blob_free(message);
+        zym_runtimeError(vm, "Cannot send unsupported type over a Channel (functions, structs, enums not supported)");
+        return false;
+    }
+    return true;
+}
+
+static ZymValue channel_unpack_message(ZymVM* vm, MarshalBlob* message) {
+    size_t offset = 0;
+    ZymValue value = marshal_unpack(vm, message, &offset);
+    marshal_blob_free(message);
+    if (value == ZYM_ERROR) {
+        zym_runtimeError(vm, "Failed to unmarshal Channel message");
+    }
+    return value;
+}
+
+static ZymValue channel_send_timeout(ZymVM* vm, ZymValue context, ZymValue value, long timeout_ms) {
+    Channel* channel = (Channel*)zym_getNativeData(context);
+    MarshalBlob message;
+    if (!channel_pack_message(vm, value, &message)) {
+        return ZYM_ERROR;
+    }
+    if (!channel_push(channel, &message, timeout_ms)) {
+        marshal_blob_free(&message);
+        return zym_newBool(false);
+    }
+    return zym_newBool(true);
+}
+
+ZymValue channel_send(ZymVM* vm, ZymValue context, ZymValue value, ZymValue timeoutVal) {
+    long timeout_ms;
+    if (!channel_timeout_arg(vm, "send", timeoutVal, &timeout_ms)) {
+        return ZYM_ERROR;
+    }
+    return channel_send_timeout(vm, context, value, timeout_ms);
+}
+
+ZymValue channel_send_1(ZymVM* vm, ZymValue context, ZymValue value) {
+    return channel_send_timeout(vm, context, value, -1);
+}
+
+ZymValue channel_trySend(ZymVM* vm, ZymValue context, ZymValue value) {
+    return channel_send_timeout(vm, context, value, 0);
+}
+
+static ZymValue channel_recv_timeout(ZymVM* vm, ZymValue context, long timeout_ms) {
+    Channel* channel = (Channel*)zym_getNativeData(context);
+    MarshalBlob message;
+    if (!channel_pop(channel, &message, timeout_ms)) {
+        return zym_newNull();
+    }
+    return channel_unpack_message(vm, &message);
+}
+
+ZymValue channel_recv(ZymVM* vm, ZymValue context, ZymValue timeoutVal) {
+    long timeout_ms;
+    if (!channel_timeout_arg(vm, "recv", timeoutVal, &timeout_ms)) {
+        return ZYM_ERROR;
+    }
+    return channel_recv_timeout(vm, context, timeout_ms);
+}
+
+ZymValue channel_recv_0(ZymVM* vm, ZymValue context) {
+    return channel_recv_timeout(vm, context, -1);
+}
+
+ZymValue channel_tryRecv(ZymVM* vm, ZymValue context) {
+    return channel_recv_timeout(vm, context, 0);
+}
+
+ZymValue channel_closeMethod(ZymVM* vm, ZymValue context) {
+    channel_close((Channel*)zym_getNativeData(context));
+    return zym_newNull();
+}
+
+ZymValue channel_isClosed(ZymVM* vm, ZymValue context) {
+    Channel* channel = (Channel*)zym_getNativeData(context);
+    return zym_newBool(atomic_load(&channel->closed));
+}
+
+ZymValue channel_getLength(ZymVM* vm, ZymValue context) {
+    Channel* channel = (Channel*)zym_getNativeData(context);
+    return zym_newNumber((double)channel_length(channel));
+}
+
+ZymValue channel_getCapacity(ZymVM* vm, ZymValue context) {
+    Channel* channel = (Channel*)zym_getNativeData(context);
+    return zym_newNumber((double)channel->capacity);
+}
+
+static void channel_cleanup(ZymVM* vm, void* ptr) {
+    channel_release((Channel*)ptr);
+}
+
+Channel* channel_from_value(ZymVM* vm, ZymValue value) {
+    if (!zym_isMap(value)) {
+        return NULL;
+    }
+    ZymValue trySend = zym_mapGet(vm, value, "trySend");
+    if (zym_isNull(trySend)) {
+        return NULL;
+    }
+    return (Channel*)zym_getNativeData(zym_getClosureContext(trySend));
+}
+
+ZymValue channel_wrap(ZymVM* vm, Channel* channel) {
+    channel_retain(channel);
+    ZymValue context = zym_createNativeContext(vm, channel, channel_cleanup);
+    zym_pushRoot(vm, context);
+
+    #define CREATE_METHOD(name, func, sig) \
+        ZymValue name = zym_createNativeClosure(vm, sig, func, context); \
+        zym_pushRoot(vm, name);
+
+    CREATE_METHOD(send_1, channel_send_1, "send(value)");
+    CREATE_METHOD(send_2, channel_send, "send(value, timeoutMs)");
+    CREATE_METHOD(trySend, channel_trySend, "trySend(value)");
+    CREATE_METHOD(recv_0, channel_recv_0, "recv()");
+    CREATE_METHOD(recv_1, channel_recv, "recv(timeoutMs)");
+    CREATE_METHOD(tryRecv, channel_tryRecv, "tryRecv()");
+    CREATE_METHOD(close, channel_closeMethod, "close()");
+    CREATE_METHOD(isClosed, channel_isClosed, "isClosed()");
+    CREATE_METHOD(getLength, channel_getLength, "getLength()");
+    CREATE_METHOD(getCapacity, channel_getCapacity, "getCapacity()");
+
+    #undef CREATE_METHOD
+
+    ZymValue send_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, send_dispatcher);
+    zym_addOverload(vm, send_dispatcher, send_1);
+    zym_addOverload(vm, send_dispatcher, send_2);
+
+    ZymValue recv_dispatcher = zym_createDispatcher(vm);
+    zym_pushRoot(vm, recv_dispatcher);
+    zym_addOverload(vm, recv_dispatcher, recv_0);
+    zym_addOverload(vm, recv_dispatcher, recv_1);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "send", send_dispatcher);
+    zym_mapSet(vm, obj, "trySend", trySend);
+    zym_mapSet(vm, obj, "recv", recv_dispatcher);
+    zym_mapSet(vm, obj, "tryRecv", tryRecv);
+    zym_mapSet(vm, obj, "close", close);
+    zym_mapSet(vm, obj, "isClosed", isClosed);
+    zym_mapSet(vm, obj, "getLength", getLength);
+    zym_mapSet(vm, obj, "getCapacity", getCapacity);
+
+    // (context + 10 methods + 2 dispatchers + obj = 14)
+    for (int i = 0; i < 14; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+ZymValue nativeChannel_create(ZymVM* vm, ZymValue capacityVal) {
+    if (!zym_isNumber(capacityVal)) {
+        zym_runtimeError(vm, "Channel() requires a numeric capacity");
+        return ZYM_ERROR;
+    }
+    double capacity = zym_asNumber(capacityVal);
+    if (!(capacity >= 1 && capacity <= CHANNEL_MAX_CAPACITY)) {  // false for NaN too
+        zym_runtimeError(vm, "Channel capacity must be between 1 and %d", CHANNEL_MAX_CAPACITY);
+        return ZYM_ERROR;
+    }
+
+    Channel* channel = channel_new((size_t)capacity);
+    if (!channel) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    // The object takes its own reference
+    ZymValue obj = channel_wrap(vm, channel);
+    channel_release(channel);
+    return obj;
+}
+
+// ---- Select ---------------------------------------------------------------------
+
+// Receives from whichever channel has a message first. Returns
+// {index, value}, or null on timeout or once every channel is closed and
+// drained. Start position rotates so one busy channel cannot starve the rest.
+ZymValue nativeChannel_select(ZymVM* vm, ZymValue channelsVal, ZymValue timeoutVal) {
+    if (!zym_isList(channelsVal) || zym_listLength(channelsVal) == 0) {
+        zym_runtimeError(vm, "channelSelect() requires a non-empty list of Channels");
+        return ZYM_ERROR;
+    }
+    long timeout_ms;
+    if (!channel_timeout_arg(vm, "channelSelect", timeoutVal, &timeout_ms)) {
+        return ZYM_ERROR;
+    }
+    int count = zym_listLength(channelsVal);
+    Channel** channels = calloc((size_t)count, sizeof(Channel*));
+    ChannelSelectNode* nodes = calloc((size_t)count, sizeof(ChannelSelectNode));
+    if (!channels || !nodes) {
+        free(channels);
+        free(nodes);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    for (int i = 0; i < count; i++) {
+        channels[i] = channel_from_value(vm, zym_listGet(vm, channelsVal, i));
+        if (!channels[i]) {
+            free(channels);
+            free(nodes);
+            zym_runtimeError(vm, "channelSelect() element %d is not a Channel", i);
+            return ZYM_ERROR;
+        }
+    }
+
+    double deadline_ms = timeout_ms < 0 ? -1 : channel_now_ms() + (double)timeout_ms;
+    int start = (int)(atomic_fetch_add(&channel_select_rotor, 1) % (unsigned)count);
+
+    ChannelSelect select;
+    mutex_init(&select.lock);
+    condvar_init(&select.cond);
+    select.signaled = false;
+    bool registered = false;
+
+    int ready = -1;
+    MarshalBlob message;
+    for (;;) {
+        mutex_lock(&select.lock);
+        select.signaled = false;
+        mutex_unlock(&select.lock);
+
+        bool all_closed = true;
+        for (int k = 0; k < count && ready < 0; k++) {
+            int i = (start + k) % count;
+            // Read closed first: a channel seen closed and then empty is drained
+            bool closed = atomic_load(&channels[i]->closed);
+            if (channel_try_pop(channels[i], &message)) {
+                ready = i;
+            } else if (!closed) {
+                all_closed = false;
+            }
+        }
+        if (ready >= 0 || all_closed) {
+            break;
+        }
+
+        long remaining = channel_remaining_ms(deadline_ms);
+        if (remaining == 0) {
+            break;
+        }
+
+        // Register once, then rescan before sleeping so a send that raced
+        // the registration is not missed
+        if (!registered) {
+            for (int i = 0; i < count; i++) {
+                nodes[i].select = &select;
+                mutex_lock(&channels[i]->lock);
+                nodes[i].next = channels[i]->selects;
+                channels[i]->selects = &nodes[i];
+                atomic_fetch_add(&channels[i]->recv_waiters, 1);
+                mutex_unlock(&channels[i]->lock);
+            }
+            atomic_thread_fence(memory_order_seq_cst);
+            registered = true;
+            continue;
+        }
+
+        mutex_lock(&select.lock);
+        while (!select.signaled) {
+            if (!condvar_wait_ms(&select.cond, &select.lock, remaining)) {
+                break;
+            }
+        }
+        mutex_unlock(&select.lock);
+    }
+
+    if (registered) {
+        for (int i = 0; i < count; i++) {
+            mutex_lock(&channels[i]->lock);
+            ChannelSelectNode** link = &channels[i]->selects;
+            while (*link && *link != &nodes[i]) {
+                link = &(*link)->next;
+            }
+            if (*link) {
+                *link = nodes[i].next;
+            }
+            atomic_fetch_sub(&channels[i]->recv_waiters, 1);
+            mutex_unlock(&channels[i]->lock);
+        }
+    }
+    mutex_destroy(&select.lock);
+    condvar_destroy(&select.cond);
+
+    if (ready < 0) {
+        free(channels);
+        free(nodes);
+        return zym_newNull();
+    }
+
+    channel_wake_senders(channels[ready]);
+    free(channels);
+    free(nodes);
+
+    ZymValue value = channel_unpack_message(vm, &message);
+    if (value == ZYM_ERROR) {
+        return ZYM_ERROR;
+    }
+    zym_pushRoot(vm, value);
+    ZymValue result = zym_newMap(vm);
+    zym_pushRoot(vm, result);
+    zym_mapSet(vm, result, "index", zym_newNumber((double)ready));
+    zym_mapSet(vm, result, "value", value);
+    zym_popRoot(vm);
+    zym_popRoot(vm);
+    return result;
+}
+
+ZymValue nativeChannel_select_1(ZymVM* vm, ZymValue channelsVal) {
+    return nativeChannel_select(vm, channelsVal, zym_newNull());
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "zym/zym.h"
+
+// Bounded multi-producer/multi-consumer queue of marshalled values. One
+// Channel is shared by every VM holding an object for it; each object owns a
+// reference and the last one frees it.
+typedef struct Channel Channel;
+
+// Returns the channel behind a Channel object, or NULL for any other value.
+Channel* channel_from_value(ZymVM* vm, ZymValue value);
+// Builds a Channel object in vm for an existing channel. Takes its own
+// reference, so it is safe to call from any thread that owns vm.
+ZymValue channel_wrap(ZymVM* vm, Channel* channel);
+
+void channel_retain(Channel* channel);
+void channel_release(Channel* channel);
@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <locale.h>
 #include "./natives.h"
+#include "./buffer.h"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -201,26 +202,12 @@ ZymValue console_writeBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Invalid Buffer object");
         return ZYM_ERROR;
     }
-
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-
-    typedef struct {
-        uint8_t* data;
-        size_t capacity;
-        size_t length;
-        size_t position;
-        bool auto_grow;
-        int endianness;
-    } BufferData;
-
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_readable(vm, buf)) {
         return ZYM_ERROR;
     }
 
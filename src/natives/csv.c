@@ -0,0 +1,1111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "./natives.h"
+#include "./buffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CSV_HAVE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#define CSV_CHUNK_SIZE (256 * 1024)
+#define CSV_DEFAULT_BATCH 1024
+
+// ---- Structural scanning -----------------------------------------------------
+
+static inline int csv_ctz(unsigned int mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Returns the first delimiter, quote, CR or LF in [p, end), or end. This is
+// the hot loop of both the reader (unquoted fields) and the writer (deciding
+// whether a field needs quoting), so it checks 16 bytes at a time with SSE2.
+static const char* csv_scan(const char* p, const char* end, char delimiter, char quote) {
+#ifdef CSV_HAVE_SSE2
+    const __m128i vdelim = _mm_set1_epi8(delimiter);
+    const __m128i vquote = _mm_set1_epi8(quote);
+    const __m128i vlf = _mm_set1_epi8('\n');
+    const __m128i vcr = _mm_set1_epi8('\r');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, vdelim), _mm_cmpeq_epi8(chunk, vquote)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, vlf), _mm_cmpeq_epi8(chunk, vcr)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+        if (mask) {
+            return p + csv_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p < end) {
+        char c = *p;
+        if (c == delimiter || c == quote || c == '\n' || c == '\r') {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+typedef struct {
+    char delimiter;
+    char quote;
+} CsvDialect;
+
+static bool csv_parse_dialect(ZymVM* vm, ZymValue optionsVal, const char* fn, CsvDialect* dialect) {
+    dialect->delimiter = ',';
+    dialect->quote = '"';
+
+    if (zym_isNull(optionsVal)) {
+        return true;
+    }
+    if (!zym_isMap(optionsVal)) {
+        zym_runtimeError(vm, "%s options must be a map", fn);
+        return false;
+    }
+
+    ZymValue delimiterVal = zym_mapGet(vm, optionsVal, "delimiter");
+    if (!zym_isNull(delimiterVal)) {
+        if (!zym_isString(delimiterVal) || strlen(zym_asCString(delimiterVal)) != 1) {
+            zym_runtimeError(vm, "%s option 'delimiter' must be a single character", fn);
+            return false;
+        }
+        dialect->delimiter = zym_asCString(delimiterVal)[0];
+    }
+
+    ZymValue quoteVal = zym_mapGet(vm, optionsVal, "quote");
+    if (!zym_isNull(quoteVal)) {
+        if (!zym_isString(quoteVal) || strlen(zym_asCString(quoteVal)) != 1) {
+            zym_runtimeError(vm, "%s option 'quote' must be a single character", fn);
+            return false;
+        }
+        dialect->quote = zym_asCString(quoteVal)[0];
+    }
+
+    if (dialect->delimiter == dialect->quote || dialect->delimiter == '\n' || dialect->delimiter == '\r') {
+        zym_runtimeError(vm, "%s has an invalid delimiter/quote combination", fn);
+        return false;
+    }
+
+    return true;
+}
+
+// ---- Reader ------------------------------------------------------------------
+
+typedef struct {
+    FILE* file;             // NULL when reading from memory
+    char* data;
+    size_t length;
+    size_t capacity;
+    size_t position;
+    bool eof;
+
+    CsvDialect dialect;
+    bool infer_types;
+    bool columnar;
+    int batch_size;
+
+    // Current row: NUL-separated field bytes plus the start offset of each field
+    char* fields;
+    size_t fields_length;
+    size_t fields_capacity;
+    size_t* field_starts;
+    int field_count;
+    int field_capacity;
+
+    char** header;
+    int header_count;
+    size_t rows_read;
+} CsvReaderData;
+
+void csv_reader_cleanup(ZymVM* vm, void* ptr) {
+    CsvReaderData* reader = (CsvReaderData*)ptr;
+    if (reader->file) {
+        fclose(reader->file);
+    }
+    for (int i = 0; i < reader->header_count; i++) {
+        free(reader->header[i]);
+    }
+    free(reader->header);
+    free(reader->data);
+    free(reader->fields);
+    free(reader->field_starts);
+    free(reader);
+}
+
+static bool csv_field_append(CsvReaderData* reader, const char* bytes, size_t len) {
+    if (reader->fields_length + len + 1 > reader->fields_capacity) {
+        size_t new_capacity = reader->fields_capacity ? reader->fields_capacity * 2 : 1024;
+        while (new_capacity < reader->fields_length + len + 1) new_capacity *= 2;
+        char* new_fields = realloc(reader->fields, new_capacity);
+        if (!new_fields) {
+            return false;
+        }
+        reader->fields = new_fields;
+        reader->fields_capacity = new_capacity;
+    }
+    memcpy(reader->fields + reader->fields_length, bytes, len);
+    reader->fields_length += len;
+    return true;
+}
+
+static bool csv_field_begin(CsvReaderData* reader) {
+    if (reader->field_count == reader->field_capacity) {
+        int new_capacity = reader->field_capacity ? reader->field_capacity * 2 : 32;
+        size_t* new_starts = realloc(reader->field_starts, sizeof(size_t) * new_capacity);
+        if (!new_starts) {
+            return false;
+        }
+        reader->field_starts = new_starts;
+        reader->field_capacity = new_capacity;
+    }
+    reader->field_starts[reader->field_count++] = reader->fields_length;
+    return true;
+}
+
+static bool csv_field_end(CsvReaderData* reader) {
+    if (!csv_field_append(reader, "", 0)) {
+        return false;
+    }
+    reader->fields[reader->fields_length++] = '\0';
+    return true;
+}
+
+static inline const char* csv_field(const CsvReaderData* reader, int index) {
+    return reader->fields + reader->field_starts[index];
+}
+
+// Pulls more input into the window, keeping the unconsumed tail.
+static bool csv_refill(CsvReaderData* reader) {
+    if (!reader->file) {
+        reader->eof = true;
+        return true;
+    }
+
+    if (reader->position > 0) {
+        memmove(reader->data, reader->data + reader->position, reader->length - reader->position);
+        reader->length -= reader->position;
+        reader->position = 0;
+    }
+
+    if (reader->length == reader->capacity) {
+        size_t new_capacity = reader->capacity * 2;
+        char* new_data = realloc(reader->data, new_capacity);
+        if (!new_data) {
+            return false;
+        }
+        reader->data = new_data;
+        reader->capacity = new_capacity;
+    }
+
+    size_t n = fread(reader->data + reader->length, 1, reader->capacity - reader->length, reader->file);
+    reader->length += n;
+    if (n == 0) {
+        reader->eof = true;
+    }
+    return true;
+}
+
+typedef enum {
+    CSV_ROW,
+    CSV_END,
+    CSV_NEED_MORE,
+    CSV_NO_MEMORY
+} CsvParseResult;
+
+// Parses one record starting at reader->position. A record cut off by the end
+// of the window reports CSV_NEED_MORE and is re-parsed after a refill.
+static CsvParseResult csv_parse_row(CsvReaderData* reader) {
+    const char* data = reader->data;
+    const char* p = data + reader->position;
+    const char* end = data + reader->length;
+    const char delimiter = reader->dialect.delimiter;
+    const char quote = reader->dialect.quote;
+    const bool eof = reader->eof;
+
+    reader->fields_length = 0;
+    reader->field_count = 0;
+
+    // Blank lines are skipped
+    while (p < end && (*p == '\n' || *p == '\r')) {
+        p++;
+    }
+    if (p == end) {
+        if (!eof) {
+            return CSV_NEED_MORE;
+        }
+        reader->position = reader->length;
+        return CSV_END;
+    }
+
+    for (;;) {
+        if (!csv_field_begin(reader)) return CSV_NO_MEMORY;
+
+        if (*p == quote) {
+            p++;
+            for (;;) {
+                const char* q = memchr(p, quote, (size_t)(end - p));
+                if (!q) {
+                    if (!eof) return CSV_NEED_MORE;
+                    // Unterminated quote: take the rest of the input
+                    if (!csv_field_append(reader, p, (size_t)(end - p))) return CSV_NO_MEMORY;
+                    p = end;
+                    break;
+                }
+                if (!csv_field_append(reader, p, (size_t)(q - p))) return CSV_NO_MEMORY;
+                if (q + 1 == end && !eof) return CSV_NEED_MORE;
+                if (q + 1 < end && q[1] == quote) {
+                    if (!csv_field_append(reader, &quote, 1)) return CSV_NO_MEMORY;
+                    p = q + 2;
+                    continue;
+                }
+                p = q + 1;
+                break;
+            }
+        }
+
+        // Unquoted bytes (or junk after a closing quote) up to the next structural char
+        for (;;) {
+            const char* s = csv_scan(p, end, delimiter, quote);
+            if (!csv_field_append(reader, p, (size_t)(s - p))) return CSV_NO_MEMORY;
+            p = s;
+            if (p < end && *p == quote) {
+                // A quote in the middle of an unquoted field is literal
+                if (!csv_field_append(reader, p, 1)) return CSV_NO_MEMORY;
+                p++;
+                continue;
+            }
+            break;
+        }
+
+        if (p == end) {
+            if (!eof) return CSV_NEED_MORE;
+            if (!csv_field_end(reader)) return CSV_NO_MEMORY;
+            reader->position = reader->length;
+            return CSV_ROW;
+        }
+
+        if (!csv_field_end(reader)) return CSV_NO_MEMORY;
+
+        if (*p == delimiter) {
+            p++;
+            if (p == end) {
+                if (!eof) return CSV_NEED_MORE;
+                // Trailing delimiter at end of input: one final empty field
+                if (!csv_field_begin(reader) || !csv_field_end(reader)) return CSV_NO_MEMORY;
+                reader->position = reader->length;
+                return CSV_ROW;
+            }
+            continue;
+        }
+
+        // CR, LF or CRLF ends the record
+        if (*p == '\r') {
+            if (p + 1 == end && !eof) return CSV_NEED_MORE;
+            p += (p + 1 < end && p[1] == '\n') ? 2 : 1;
+        } else {
+            p++;
+        }
+        reader->position = (size_t)(p - data);
+        return CSV_ROW;
+    }
+}
+
+static CsvParseResult csv_next_row(CsvReaderData* reader) {
+    for (;;) {
+        CsvParseResult result = csv_parse_row(reader);
+        if (result != CSV_NEED_MORE) {
+            if (result == CSV_ROW) reader->rows_read++;
+            return result;
+        }
+        if (!csv_refill(reader)) {
+            return CSV_NO_MEMORY;
+        }
+    }
+}
+
+static ZymValue csv_field_value(ZymVM* vm, const CsvReaderData* reader, int index) {
+    const char* text = csv_field(reader, index);
+
+    if (reader->infer_types && text[0] != '\0') {
+        char c = text[0];
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.') {
+            // Read with '.' as the decimal point whatever the locale
+            double number;
+            if (json_parse_double(text, strlen(text), &number) && isfinite(number)) {
+                return zym_newNumber(number);
+            }
+        }
+    }
+
+    return zym_newString(vm, text);
+}
+
+static ZymValue csv_row_to_list(ZymVM* vm, const CsvReaderData* reader) {
+    ZymValue row = zym_newList(vm);
+    zym_pushRoot(vm, row);
+
+    for (int i = 0; i < reader->field_count; i++) {
+        ZymValue value = csv_field_value(vm, reader, i);
+        zym_pushRoot(vm, value);
+        zym_listAppend(vm, row, value);
+        zym_popRoot(vm);
+    }
+
+    zym_popRoot(vm);
+    return row;
+}
+
+ZymValue csv_reader_next(ZymVM* vm, ZymValue context) {
+    CsvReaderData* reader = (CsvReaderData*)zym_getNativeData(context);
+
+    CsvParseResult result = csv_next_row(reader);
+    if (result == CSV_NO_MEMORY) {
+        zym_runtimeError(vm, "Out of memory while reading CSV");
+        return ZYM_ERROR;
+    }
+    if (result == CSV_END) {
+        return zym_newNull();
+    }
+
+    return csv_row_to_list(vm, reader);
+}
+
+// Columnar batch: one list per column, keyed by header name (or column index
+// when there is no header). Columns are fixed by the header or by the first
+// row of the batch; short rows are padded with null, extra fields dropped.
+static ZymValue csv_next_columns(ZymVM* vm, CsvReaderData* reader, int count) {
+    ZymValue columns = zym_newMap(vm);
+    zym_pushRoot(vm, columns);
+
+    ZymValue* lists = NULL;
+    int column_count = -1;
+    int rows = 0;
+
+    while (rows < count) {
+        CsvParseResult result = csv_next_row(reader);
+        if (result == CSV_NO_MEMORY) {
+            free(lists);
+            zym_popRoot(vm);
+            zym_runtimeError(vm, "Out of memory while reading CSV");
+            return ZYM_ERROR;
+        }
+        if (result == CSV_END) {
+            break;
+        }
+
+        if (column_count < 0) {
+            column_count = reader->header ? reader->header_count : reader->field_count;
+            lists = calloc(column_count > 0 ? column_count : 1, sizeof(ZymValue));
+            if (!lists) {
+                zym_popRoot(vm);
+                zym_runtimeError(vm, "Out of memory");
+                return ZYM_ERROR;
+            }
+            for (int c = 0; c < column_count; c++) {
+                lists[c] = zym_newList(vm);
+                zym_pushRoot(vm, lists[c]);
+                if (reader->header) {
+                    zym_mapSet(vm, columns, reader->header[c], lists[c]);
+                } else {
+                    char key[16];
+                    snprintf(key, sizeof(key), "%d", c);
+                    zym_mapSet(vm, columns, key, lists[c]);
+                }
+                zym_popRoot(vm);
+            }
+        }
+
+        for (int c = 0; c < column_count; c++) {
+            ZymValue value = c < reader->field_count ? csv_field_value(vm, reader, c) : zym_newNull();
+            zym_pushRoot(vm, value);
+            zym_listAppend(vm, lists[c], value);
+            zym_popRoot(vm);
+        }
+        rows++;
+    }
+
+    free(lists);
+    zym_popRoot(vm);
+
+    if (rows == 0) {
+        return zym_newNull();
+    }
+    return columns;
+}
+
+ZymValue csv_reader_nextBatch(ZymVM* vm, ZymValue context, ZymValue countVal) {
+    CsvReaderData* reader = (CsvReaderData*)zym_getNativeData(context);
+
+    int count = reader->batch_size;
+    if (!zym_isNull(countVal)) {
+        if (!zym_isNumber(countVal) || zym_asNumber(countVal) < 1) {
+            zym_runtimeError(vm, "nextBatch() requires a positive number");
+            return ZYM_ERROR;
+        }
+        count = (int)zym_asNumber(countVal);
+    }
+
+    if (reader->columnar) {
+        return csv_next_columns(vm, reader, count);
+    }
+
+    ZymValue rows = zym_newList(vm);
+    zym_pushRoot(vm, rows);
+
+    int read = 0;
+    while (read < count) {
+        CsvParseResult result = csv_next_row(reader);
+        if (result == CSV_NO_MEMORY) {
+            zym_popRoot(vm);
+            zym_runtimeError(vm, "Out of memory while reading CSV");
+            return ZYM_ERROR;
+        }
+        if (result == CSV_END) {
+            break;
+        }
+
+        ZymValue row = csv_row_to_list(vm, reader);
+        zym_pushRoot(vm, row);
+        zym_listAppend(vm, rows, row);
+        zym_popRoot(vm);
+        read++;
+    }
+
+    zym_popRoot(vm);
+
+    if (read == 0) {
+        return zym_newNull();
+    }
+    return rows;
+}
+
+ZymValue csv_reader_nextBatch_0(ZymVM* vm, ZymValue context) {
+    return csv_reader_nextBatch(vm, context, zym_newNull());
+}
+
+ZymValue csv_reader_getHeader(ZymVM* vm, ZymValue context) {
+    CsvReaderData* reader = (CsvReaderData*)zym_getNativeData(context);
+    if (!reader->header) {
+        return zym_newNull();
+    }
+
+    ZymValue list = zym_newList(vm);
+    zym_pushRoot(vm, list);
+    for (int i = 0; i < reader->header_count; i++) {
+        ZymValue name = zym_newString(vm, reader->header[i]);
+        zym_pushRoot(vm, name);
+        zym_listAppend(vm, list, name);
+        zym_popRoot(vm);
+    }
+    zym_popRoot(vm);
+    return list;
+}
+
+ZymValue csv_reader_getRowCount(ZymVM* vm, ZymValue context) {
+    CsvReaderData* reader = (CsvReaderData*)zym_getNativeData(context);
+    return zym_newNumber((double)reader->rows_read);
+}
+
+ZymValue csv_reader_close(ZymVM* vm, ZymValue context) {
+    CsvReaderData* reader = (CsvReaderData*)zym_getNativeData(context);
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+    reader->length = 0;
+    reader->position = 0;
+    reader->eof = true;
+    return context;
+}
+
+ZymValue nativeCsv_reader(ZymVM* vm, ZymValue sourceVal, ZymValue optionsVal) {
+    CsvDialect dialect;
+    if (!csv_parse_dialect(vm, optionsVal, "CsvReader()", &dialect)) {
+        return ZYM_ERROR;
+    }
+
+    bool header = false;
+    bool infer_types = false;
+    bool columnar = false;
+    int batch_size = CSV_DEFAULT_BATCH;
+
+    if (zym_isMap(optionsVal)) {
+        ZymValue headerVal = zym_mapGet(vm, optionsVal, "header");
+        if (zym_isBool(headerVal)) header = zym_asBool(headerVal);
+
+        ZymValue inferVal = zym_mapGet(vm, optionsVal, "inferTypes");
+        if (zym_isBool(inferVal)) infer_types = zym_asBool(inferVal);
+
+        ZymValue columnarVal = zym_mapGet(vm, optionsVal, "columnar");
+        if (zym_isBool(columnarVal)) columnar = zym_asBool(columnarVal);
+
+        ZymValue batchVal = zym_mapGet(vm, optionsVal, "batchSize");
+        if (zym_isNumber(batchVal) && zym_asNumber(batchVal) >= 1) batch_size = (int)zym_asNumber(batchVal);
+    }
+
+    CsvReaderData* reader = calloc(1, sizeof(CsvReaderData));
+    if (!reader) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    reader->dialect = dialect;
+    reader->infer_types = infer_types;
+    reader->columnar = columnar;
+    reader->batch_size = batch_size;
+
+    // In-memory sources are copied once so later script mutation can't move them
+    BufferData* buf = buffer_from_value(vm, sourceVal);
+    if (buf && !buffer_check_readable(vm, buf)) {
+        free(reader);
+        return ZYM_ERROR;
+    }
+    if (zym_isString(sourceVal) || buf) {
+        const char* bytes = buf ? (const char*)buf->data + buf->position : zym_asCString(sourceVal);
+        size_t len = buf ? (buf->position < buf->length ? buf->length - buf->position : 0) : strlen(bytes);
+        reader->data = malloc(len > 0 ? len : 1);
+        if (!reader->data) {
+            free(reader);
+            zym_runtimeError(vm, "Out of memory");
+            return ZYM_ERROR;
+        }
+        memcpy(reader->data, bytes, len);
+        reader->length = len;
+        reader->capacity = len;
+        reader->eof = true;
+    } else {
+        reader->file = nativeFile_dupHandle(vm, sourceVal);
+        if (!reader->file) {
+            free(reader);
+            zym_runtimeError(vm, "CsvReader() source must be an open File, a Buffer or a string");
+            return ZYM_ERROR;
+        }
+        reader->capacity = CSV_CHUNK_SIZE;
+        reader->data = malloc(reader->capacity);
+        if (!reader->data) {
+            csv_reader_cleanup(vm, reader);
+            zym_runtimeError(vm, "Out of memory");
+            return ZYM_ERROR;
+        }
+    }
+
+    if (header) {
+        CsvParseResult result = csv_next_row(reader);
+        if (result == CSV_NO_MEMORY) {
+            csv_reader_cleanup(vm, reader);
+            zym_runtimeError(vm, "Out of memory while reading CSV");
+            return ZYM_ERROR;
+        }
+        if (result == CSV_ROW) {
+            reader->header = calloc(reader->field_count, sizeof(char*));
+            if (reader->header) {
+                reader->header_count = reader->field_count;
+                for (int i = 0; i < reader->field_count; i++) {
+                    reader->header[i] = strdup(csv_field(reader, i));
+                }
+            }
+            reader->rows_read = 0;
+        }
+    }
+
+    ZymValue context = zym_createNativeContext(vm, reader, csv_reader_cleanup);
+    zym_pushRoot(vm, context);
+
+    ZymValue next = zym_createNativeClosure(vm, "next()", csv_reader_next, context);
+    zym_pushRoot(vm, next);
+    ZymValue nextBatch0 = zym_createNativeClosure(vm, "nextBatch()", csv_reader_nextBatch_0, context);
+    zym_pushRoot(vm, nextBatch0);
+    ZymValue nextBatch1 = zym_createNativeClosure(vm, "nextBatch(count)", csv_reader_nextBatch, context);
+    zym_pushRoot(vm, nextBatch1);
+    ZymValue nextBatch = zym_createDispatcher(vm);
+    zym_pushRoot(vm, nextBatch);
+    zym_addOverload(vm, nextBatch, nextBatch0);
+    zym_addOverload(vm, nextBatch, nextBatch1);
+    ZymValue getHeader = zym_createNativeClosure(vm, "getHeader()", csv_reader_getHeader, context);
+    zym_pushRoot(vm, getHeader);
+    ZymValue getRowCount = zym_createNativeClosure(vm, "getRowCount()", csv_reader_getRowCount, context);
+    zym_pushRoot(vm, getRowCount);
+    ZymValue close = zym_createNativeClosure(vm, "close()", csv_reader_close, context);
+    zym_pushRoot(vm, close);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "next", next);
+    zym_mapSet(vm, obj, "nextBatch", nextBatch);
+    zym_mapSet(vm, obj, "getHeader", getHeader);
+    zym_mapSet(vm, obj, "getRowCount", getRowCount);
+    zym_mapSet(vm, obj, "close", close);
+
+    // (context + 7 closures + obj = 9)
+    for (int i = 0; i < 9; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+ZymValue nativeCsv_reader_1(ZymVM* vm, ZymValue sourceVal) {
+    return nativeCsv_reader(vm, sourceVal, zym_newNull());
+}
+
+// ---- Writer ------------------------------------------------------------------
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} CsvOutput;
+
+static bool csv_out_reserve(CsvOutput* out, size_t extra) {
+    if (out->length + extra <= out->capacity) {
+        return true;
+    }
+    size_t new_capacity = out->capacity ? out->capacity * 2 : 4096;
+    while (new_capacity < out->length + extra) new_capacity *= 2;
+    char* new_data = realloc(out->data, new_capacity);
+    if (!new_data) {
+        return false;
+    }
+    out->data = new_data;
+    out->capacity = new_capacity;
+    return true;
+}
+
+static inline bool csv_out_append(CsvOutput* out, const char* bytes, size_t len) {
+    if (!csv_out_reserve(out, len)) {
+        return false;
+    }
+    memcpy(out->data + out->length, bytes, len);
+    out->length += len;
+    return true;
+}
+
+// Clean fields are copied verbatim; only fields containing a delimiter, quote
+// or line break are quoted, with embedded quotes doubled.
+static bool csv_write_field(CsvOutput* out, const CsvDialect* dialect, const char* text, size_t len) {
+    const char* end = text + len;
+    if (csv_scan(text, end, dialect->delimiter, dialect->quote) == end) {
+        return csv_out_append(out, text, len);
+    }
+
+    if (!csv_out_reserve(out, len + 2 + 8)) {
+        return false;
+    }
+    out->data[out->length++] = dialect->quote;
+
+    const char* p = text;
+    while (p < end) {
+        const char* q = memchr(p, dialect->quote, (size_t)(end - p));
+        size_t chunk = q ? (size_t)(q - p) + 1 : (size_t)(end - p);
+        if (!csv_out_append(out, p, chunk)) return false;
+        if (q && !csv_out_append(out, &dialect->quote, 1)) return false;
+        p += chunk;
+    }
+
+    return csv_out_append(out, &dialect->quote, 1);
+}
+
+static bool csv_write_value(ZymVM* vm, CsvOutput* out, const CsvDialect* dialect, ZymValue value) {
+    if (zym_isNull(value)) {
+        return true;
+    }
+
+    if (zym_isString(value)) {
+        const char* text = zym_asCString(value);
+        return csv_write_field(out, dialect, text, strlen(text));
+    }
+
+    char scratch[32];
+    int n;
+    if (zym_isNumber(value)) {
+        double number = zym_asNumber(value);
+        // Range-check before the cast: converting an out-of-range or
+        // non-finite double to an integer is undefined
+        if (isfinite(number) && fabs(number) < 1e15 && number == (double)(int64_t)number) {
+            n = snprintf(scratch, sizeof(scratch), "%lld", (long long)number);
+        } else {
+            // %.17g always reads back as the same double; '.' whatever the locale
+            n = json_format_double(scratch, sizeof(scratch), 17, number);
+        }
+    } else if (zym_isBool(value)) {
+        n = snprintf(scratch, sizeof(scratch), "%s", zym_asBool(value) ? "true" : "false");
+    } else {
+        zym_runtimeError(vm, "CSV fields must be strings, numbers, bools or null (got %s)", zym_typeName(value));
+        return false;
+    }
+
+    return csv_out_append(out, scratch, (size_t)n);
+}
+
+typedef struct {
+    CsvDialect dialect;
+    const char* line_ending;
+    char** columns;         // Field order for map rows (from the "header" option)
+    int column_count;
+} CsvWriteFormat;
+
+static void csv_format_free(CsvWriteFormat* format) {
+    for (int i = 0; i < format->column_count; i++) {
+        free(format->columns[i]);
+    }
+    free(format->columns);
+    format->columns = NULL;
+    format->column_count = 0;
+}
+
+static bool csv_parse_write_format(ZymVM* vm, ZymValue optionsVal, const char* fn, CsvWriteFormat* format) {
+    memset(format, 0, sizeof(CsvWriteFormat));
+    format->line_ending = "\n";
+
+    if (!csv_parse_dialect(vm, optionsVal, fn, &format->dialect)) {
+        return false;
+    }
+    if (!zym_isMap(optionsVal)) {
+        return true;
+    }
+
+    ZymValue lineEndingVal = zym_mapGet(vm, optionsVal, "lineEnding");
+    if (zym_isString(lineEndingVal)) {
+        format->line_ending = strcmp(zym_asCString(lineEndingVal), "\r\n") == 0 ? "\r\n" : "\n";
+    }
+
+    ZymValue headerVal = zym_mapGet(vm, optionsVal, "header");
+    if (zym_isList(headerVal)) {
+        int count = zym_listLength(headerVal);
+        format->columns = calloc(count > 0 ? count : 1, sizeof(char*));
+        if (!format->columns) {
+            zym_runtimeError(vm, "Out of memory");
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            ZymValue name = zym_listGet(vm, headerVal, i);
+            if (!zym_isString(name)) {
+                csv_format_free(format);
+                zym_runtimeError(vm, "%s option 'header' must be a list of strings", fn);
+                return false;
+            }
+            format->columns[format->column_count++] = strdup(zym_asCString(name));
+        }
+    }
+
+    return true;
+}
+
+static bool csv_write_header(CsvOutput* out, const CsvWriteFormat* format) {
+    for (int i = 0; i < format->column_count; i++) {
+        if (i > 0 && !csv_out_append(out, &format->dialect.delimiter, 1)) return false;
+        if (!csv_write_field(out, &format->dialect, format->columns[i], strlen(format->columns[i]))) return false;
+    }
+    return csv_out_append(out, format->line_ending, strlen(format->line_ending));
+}
+
+// A row is a list of values, or a map when a header was given.
+static bool csv_write_row_fields(ZymVM* vm, CsvOutput* out, const CsvWriteFormat* format, ZymValue row) {
+    if (zym_isList(row)) {
+        int count = zym_listLength(row);
+        for (int i = 0; i < count; i++) {
+            if (i > 0 && !csv_out_append(out, &format->dialect.delimiter, 1)) goto oom;
+            if (!csv_write_value(vm, out, &format->dialect, zym_listGet(vm, row, i))) {
+                return false;
+            }
+        }
+    } else if (zym_isMap(row) && format->column_count > 0) {
+        for (int i = 0; i < format->column_count; i++) {
+            if (i > 0 && !csv_out_append(out, &format->dialect.delimiter, 1)) goto oom;
+            if (!csv_write_value(vm, out, &format->dialect, zym_mapGet(vm, row, format->columns[i]))) {
+                return false;
+            }
+        }
+    } else {
+        zym_runtimeError(vm, "CSV rows must be lists (or maps when a header is set)");
+        return false;
+    }
+
+    if (csv_out_append(out, format->line_ending, strlen(format->line_ending))) {
+        return true;
+    }
+
+oom:
+    zym_runtimeError(vm, "Out of memory while writing CSV");
+    return false;
+}
+
+// A failed row is rolled back so the output never holds half a record.
+static bool csv_write_row(ZymVM* vm, CsvOutput* out, const CsvWriteFormat* format, ZymValue row) {
+    size_t mark = out->length;
+    if (!csv_write_row_fields(vm, out, format, row)) {
+        out->length = mark;
+        return false;
+    }
+    return true;
+}
+
+typedef struct {
+    // A File or a Buffer object, kept alive via the writer object. Output
+    // goes through the File's own stream, so the File's offset moves with
+    // it and anything the script writes to the File afterwards follows on.
+    ZymValue target;
+    bool to_file;
+    bool closed;
+    CsvWriteFormat format;
+    CsvOutput out;
+    bool header_pending;
+    size_t rows_written;
+} CsvWriterData;
+
+void csv_writer_cleanup(ZymVM* vm, void* ptr) {
+    CsvWriterData* writer = (CsvWriterData*)ptr;
+    // Output is never held back between calls: the target may already have
+    // been collected by the time this runs
+    csv_format_free(&writer->format);
+    free(writer->out.data);
+    free(writer);
+}
+
+static bool csv_writer_drain(ZymVM* vm, CsvWriterData* writer) {
+    if (writer->out.length == 0) {
+        return true;
+    }
+
+    if (writer->to_file) {
+        if (!nativeFile_writeBytes(vm, writer->target, writer->out.data, writer->out.length)) {
+            return false;
+        }
+        writer->out.length = 0;
+        return true;
+    }
+
+    BufferData* buf = buffer_from_value(vm, writer->target);
+    if (!buf) {
+        zym_runtimeError(vm, "CSV target Buffer is no longer valid");
+        return false;
+    }
+    if (!buffer_write_bytes(vm, buf, writer->out.data, writer->out.length)) {
+        return false;
+    }
+    writer->out.length = 0;
+    return true;
+}
+
+static bool csv_writer_begin(ZymVM* vm, CsvWriterData* writer) {
+    if (writer->closed) {
+        zym_runtimeError(vm, "CsvWriter has been closed");
+        return false;
+    }
+    if (writer->header_pending) {
+        writer->header_pending = false;
+        if (!csv_write_header(&writer->out, &writer->format)) {
+            zym_runtimeError(vm, "Out of memory while writing CSV");
+            return false;
+        }
+    }
+    return true;
+}
+
+ZymValue csv_writer_writeRow(ZymVM* vm, ZymValue context, ZymValue rowVal) {
+    CsvWriterData* writer = (CsvWriterData*)zym_getNativeData(context);
+
+    if (!csv_writer_begin(vm, writer) || !csv_write_row(vm, &writer->out, &writer->format, rowVal)) {
+        return ZYM_ERROR;
+    }
+    writer->rows_written++;
+
+    // Each row is handed over straight away; a File batches it in its own
+    // stream buffer
+    if (!csv_writer_drain(vm, writer)) {
+        return ZYM_ERROR;
+    }
+    return context;
+}
+
+ZymValue csv_writer_writeRows(ZymVM* vm, ZymValue context, ZymValue rowsVal) {
+    CsvWriterData* writer = (CsvWriterData*)zym_getNativeData(context);
+
+    if (!zym_isList(rowsVal)) {
+        zym_runtimeError(vm, "writeRows() requires a list of rows");
+        return ZYM_ERROR;
+    }
+
+    if (!csv_writer_begin(vm, writer)) {
+        return ZYM_ERROR;
+    }
+
+    int count = zym_listLength(rowsVal);
+    for (int i = 0; i < count; i++) {
+        if (!csv_write_row(vm, &writer->out, &writer->format, zym_listGet(vm, rowsVal, i))) {
+            return ZYM_ERROR;
+        }
+        writer->rows_written++;
+        if (writer->out.length >= CSV_CHUNK_SIZE && !csv_writer_drain(vm, writer)) {
+            return ZYM_ERROR;
+        }
+    }
+
+    if (!csv_writer_drain(vm, writer)) {
+        return ZYM_ERROR;
+    }
+    return context;
+}
+
+ZymValue csv_writer_flush(ZymVM* vm, ZymValue context) {
+    CsvWriterData* writer = (CsvWriterData*)zym_getNativeData(context);
+
+    if (!csv_writer_begin(vm, writer) || !csv_writer_drain(vm, writer)) {
+        return ZYM_ERROR;
+    }
+    if (writer->to_file && !nativeFile_flush(vm, writer->target)) {
+        return ZYM_ERROR;
+    }
+    return context;
+}
+
+ZymValue csv_writer_getRowCount(ZymVM* vm, ZymValue context) {
+    CsvWriterData* writer = (CsvWriterData*)zym_getNativeData(context);
+    return zym_newNumber((double)writer->rows_written);
+}
+
+ZymValue csv_writer_close(ZymVM* vm, ZymValue context) {
+    CsvWriterData* writer = (CsvWriterData*)zym_getNativeData(context);
+
+    if (writer->closed) {
+        return context;
+    }
+    if (!csv_writer_begin(vm, writer) || !csv_writer_drain(vm, writer)) {
+        return ZYM_ERROR;
+    }
+    // The File stays open; it belongs to the script
+    if (writer->to_file && !nativeFile_flush(vm, writer->target)) {
+        return ZYM_ERROR;
+    }
+    writer->closed = true;
+    return context;
+}
+
+ZymValue nativeCsv_writer(ZymVM* vm, ZymValue targetVal, ZymValue optionsVal) {
+    CsvWriterData* writer = calloc(1, sizeof(CsvWriterData));
+    if (!writer) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    if (!csv_parse_write_format(vm, optionsVal, "CsvWriter()", &writer->format)) {
+        free(writer);
+        return ZYM_ERROR;
+    }
+    writer->header_pending = writer->format.column_count > 0;
+
+    BufferData* target = buffer_from_value(vm, targetVal);
+    if (target) {
+        if (!buffer_check_writable(vm, target)) {
+            csv_format_free(&writer->format);
+            free(writer);
+            return ZYM_ERROR;
+        }
+    } else if (nativeFile_isWritable(vm, targetVal)) {
+        writer->to_file = true;
+    } else {
+        csv_format_free(&writer->format);
+        free(writer);
+        zym_runtimeError(vm, "CsvWriter() target must be a File open for writing or a Buffer");
+        return ZYM_ERROR;
+    }
+    writer->target = targetVal;
+
+    ZymValue context = zym_createNativeContext(vm, writer, csv_writer_cleanup);
+    zym_pushRoot(vm, context);
+
+    ZymValue writeRow = zym_createNativeClosure(vm, "writeRow(row)", csv_writer_writeRow, context);
+    zym_pushRoot(vm, writeRow);
+    ZymValue writeRows = zym_createNativeClosure(vm, "writeRows(rows)", csv_writer_writeRows, context);
+    zym_pushRoot(vm, writeRows);
+    ZymValue flush = zym_createNativeClosure(vm, "flush()", csv_writer_flush, context);
+    zym_pushRoot(vm, flush);
+    ZymValue getRowCount = zym_createNativeClosure(vm, "getRowCount()", csv_writer_getRowCount, context);
+    zym_pushRoot(vm, getRowCount);
+    ZymValue close = zym_createNativeClosure(vm, "close()", csv_writer_close, context);
+    zym_pushRoot(vm, close);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "writeRow", writeRow);
+    zym_mapSet(vm, obj, "writeRows", writeRows);
+    zym_mapSet(vm, obj, "flush", flush);
+    zym_mapSet(vm, obj, "getRowCount", getRowCount);
+    zym_mapSet(vm, obj, "close", close);
+    // Keeps the target reachable for as long as the writer is
+    zym_mapSet(vm, obj, "target", targetVal);
+
+    // (context + 5 methods + obj = 7)
+    for (int i = 0; i < 7; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+ZymValue nativeCsv_writer_1(ZymVM* vm, ZymValue targetVal) {
+    return nativeCsv_writer(vm, targetVal, zym_newNull());
+}
+
+ZymValue nativeCsv_format(ZymVM* vm, ZymValue rowsVal, ZymValue optionsVal) {
+    if (!zym_isList(rowsVal)) {
+        zym_runtimeError(vm, "csvFormat() requires a list of rows");
+        return ZYM_ERROR;
+    }
+
+    CsvWriteFormat format;
+    if (!csv_parse_write_format(vm, optionsVal, "csvFormat()", &format)) {
+        return ZYM_ERROR;
+    }
+
+    CsvOutput out = { NULL, 0, 0 };
+    bool ok = format.column_count == 0 || csv_write_header(&out, &format);
+    if (!ok) {
+        zym_runtimeError(vm, "Out of memory while writing CSV");
+    }
+
+    int count = zym_listLength(rowsVal);
+    for (int i = 0; ok && i < count; i++) {
+        ok = csv_write_row(vm, &out, &format, zym_listGet(vm, rowsVal, i));
+    }
+
+    csv_format_free(&format);
+
+    if (ok && !csv_out_reserve(&out, 1)) {
+        zym_runtimeError(vm, "Out of memory while writing CSV");
+        ok = false;
+    }
+    if (!ok) {
+        free(out.data);
+        return ZYM_ERROR;
+    }
+    out.data[out.length] = '\0';
+
+    ZymValue result = zym_newString(vm, out.data);
+    free(out.data);
+    return result;
+}
+
+ZymValue nativeCsv_format_1(ZymVM* vm, ZymValue rowsVal) {
+    return nativeCsv_format(vm, rowsVal, zym_newNull());
+}
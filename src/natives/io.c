@@ -1,3 +1,7 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,6 +9,7 @@
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <stdatomic.h>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -20,20 +25,16 @@
 #else
     #include <unistd.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <limits.h>
+    #include <sys/uio.h>
     #define PATH_SEP '/'
     #define PATH_SEP_STR "/"
 #endif
 
 #include "./natives.h"
-
-typedef struct {
-    uint8_t* data;
-    size_t capacity;
-    size_t length;
-    size_t position;
-    bool auto_grow;
-    int endianness;
-} BufferData;
+#include "./buffer.h"
+#include "./thread.h"
 
 typedef enum {
     FILE_MODE_READ,
@@ -46,18 +47,210 @@ typedef enum {
     FILE_MODE_READ_WRITE_BIN
 } FileMode;
 
+typedef enum {
+    FLUSH_SIZE,     // Flush whenever the buffer fills (stdio default)
+    FLUSH_NONE,     // Every write goes straight to the OS
+    FLUSH_LINE,     // Flush on newline
+    FLUSH_MANUAL    // Flush only on flush()/close(), or when the buffer overflows
+} FlushPolicy;
+
+#define FILE_DEFAULT_BUFFER_SIZE (64 * 1024)
+
+// Background writer: the VM thread appends into `pending` and a worker thread
+// swaps it out and writes it, so writes never block on disk.
+typedef struct {
+    FILE* handle;
+    Mutex lock;
+    CondVar wake;
+    CondVar drained;
+    ThreadHandle thread;
+    char* pending;
+    size_t pending_len;
+    size_t pending_cap;
+    char* writing;
+    size_t writing_cap;
+    size_t threshold;
+    size_t max_pending;
+    bool flush_requested;
+    bool busy;
+    bool stop;
+    int error;
+} AsyncWriter;
+
 typedef struct {
     FILE* handle;
     char* path;
     FileMode mode;
     bool is_open;
     size_t position;
+    FlushPolicy flush;
+    size_t buffer_size;
+    char* stdio_buffer;
+    AsyncWriter* writer;
 } FileData;
 
+static void async_writer_main(void* arg) {
+    AsyncWriter* writer = (AsyncWriter*)arg;
+
+    mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->stop && !writer->flush_requested && writer->pending_len < writer->threshold) {
+            condvar_wait(&writer->wake, &writer->lock);
+        }
+
+        if (writer->pending_len == 0) {
+            writer->flush_requested = false;
+            condvar_broadcast(&writer->drained);
+            if (writer->stop) {
+                break;
+            }
+            continue;
+        }
+
+        char* chunk = writer->pending;
+        size_t chunk_len = writer->pending_len;
+        size_t chunk_cap = writer->pending_cap;
+        writer->pending = writer->writing;
+        writer->pending_cap = writer->writing_cap;
+        writer->pending_len = 0;
+        writer->writing = chunk;
+        writer->writing_cap = chunk_cap;
+        writer->busy = true;
+        mutex_unlock(&writer->lock);
+
+        size_t written = fwrite(chunk, 1, chunk_len, writer->handle);
+        int err = (written != chunk_len || fflush(writer->handle) != 0) ? (errno ? errno : EIO) : 0;
+
+        mutex_lock(&writer->lock);
+        writer->busy = false;
+        if (err && !writer->error) {
+            writer->error = err;
+        }
+        condvar_broadcast(&writer->drained);
+    }
+    mutex_unlock(&writer->lock);
+}
+
+static AsyncWriter* async_writer_start(FILE* handle, FlushPolicy policy, size_t buffer_size) {
+    AsyncWriter* writer = calloc(1, sizeof(AsyncWriter));
+    if (!writer) {
+        return NULL;
+    }
+
+    writer->handle = handle;
+    writer->threshold = policy == FLUSH_NONE ? 1 :
+                        policy == FLUSH_MANUAL ? SIZE_MAX : buffer_size;
+    writer->max_pending = buffer_size * 4;
+    mutex_init(&writer->lock);
+    condvar_init(&writer->wake);
+    condvar_init(&writer->drained);
+
+    if (!thread_start(&writer->thread, async_writer_main, writer)) {
+        condvar_destroy(&writer->drained);
+        condvar_destroy(&writer->wake);
+        mutex_destroy(&writer->lock);
+        free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+// Returns 0 or the errno of the first failed background write.
+static int async_writer_write(AsyncWriter* writer, const char* data, size_t len, bool wake_now) {
+    mutex_lock(&writer->lock);
+
+    // Backpressure: wait for the worker rather than buffering without bound
+    while (!writer->error && writer->pending_len > 0 && writer->pending_len + len > writer->max_pending) {
+        writer->flush_requested = true;
+        condvar_signal(&writer->wake);
+        condvar_wait(&writer->drained, &writer->lock);
+    }
+
+    if (writer->error) {
+        int err = writer->error;
+        mutex_unlock(&writer->lock);
+        return err;
+    }
+
+    if (writer->pending_len + len > writer->pending_cap) {
+        size_t new_cap = writer->pending_cap ? writer->pending_cap : 4096;
+        while (new_cap < writer->pending_len + len) new_cap *= 2;
+        char* new_pending = realloc(writer->pending, new_cap);
+        if (!new_pending) {
+            mutex_unlock(&writer->lock);
+            return ENOMEM;
+        }
+        writer->pending = new_pending;
+        writer->pending_cap = new_cap;
+    }
+
+    memcpy(writer->pending + writer->pending_len, data, len);
+    writer->pending_len += len;
+
+    if (wake_now) {
+        writer->flush_requested = true;
+    }
+    if (wake_now || writer->pending_len >= writer->threshold) {
+        condvar_signal(&writer->wake);
+    }
+
+    mutex_unlock(&writer->lock);
+    return 0;
+}
+
+// Blocks until everything queued so far has reached the OS.
+static int async_writer_drain(AsyncWriter* writer) {
+    mutex_lock(&writer->lock);
+    writer->flush_requested = true;
+    condvar_signal(&writer->wake);
+    while (writer->pending_len > 0 || writer->busy) {
+        condvar_wait(&writer->drained, &writer->lock);
+    }
+    int err = writer->error;
+    writer->error = 0;
+    mutex_unlock(&writer->lock);
+    return err;
+}
+
+static int async_writer_stop(AsyncWriter* writer) {
+    mutex_lock(&writer->lock);
+    writer->stop = true;
+    condvar_signal(&writer->wake);
+    mutex_unlock(&writer->lock);
+
+    thread_join(writer->thread);
+
+    int err = writer->error;
+    condvar_destroy(&writer->drained);
+    condvar_destroy(&writer->wake);
+    mutex_destroy(&writer->lock);
+    free(writer->pending);
+    free(writer->writing);
+    free(writer);
+    return err;
+}
+
+static int file_close_handle(FileData* file) {
+    int err = 0;
+    if (file->writer) {
+        err = async_writer_stop(file->writer);
+        file->writer = NULL;
+    }
+    if (fclose(file->handle) != 0 && !err) {
+        err = errno;
+    }
+    file->handle = NULL;
+    file->is_open = false;
+    free(file->stdio_buffer);
+    file->stdio_buffer = NULL;
+    return err;
+}
+
 void file_cleanup(ZymVM* vm, void* ptr) {
     FileData* file = (FileData*)ptr;
     if (file->is_open && file->handle) {
-        fclose(file->handle);
+        file_close_handle(file);
     }
     free(file->path);
     free(file);
@@ -93,7 +286,9 @@ static bool parse_file_mode(const char* mode_str, FileMode* out_mode) {
 }
 
 static void sync_file_position(FileData* file) {
-    if (file->is_open && file->handle) {
+    // With a background writer the handle belongs to the worker; position is
+    // tracked by the write paths instead.
+    if (file->is_open && file->handle && !file->writer) {
         long pos = ftell(file->handle);
         if (pos >= 0) {
             file->position = (size_t)pos;
@@ -101,6 +296,35 @@ static void sync_file_position(FileData* file) {
     }
 }
 
+// Waits for the background writer (if any) so the handle can be used directly.
+static bool file_quiesce(ZymVM* vm, FileData* file) {
+    if (!file->writer) {
+        return true;
+    }
+
+    int err = async_writer_drain(file->writer);
+    if (err) {
+        zym_runtimeError(vm, "Failed to write to file '%s': %s", file->path, strerror(err));
+        return false;
+    }
+    return true;
+}
+
+static bool file_put(ZymVM* vm, FileData* file, const char* data, size_t len, bool end_of_line) {
+    if (file->writer) {
+        bool wake_now = file->flush == FLUSH_NONE || (file->flush == FLUSH_LINE && end_of_line);
+        int err = async_writer_write(file->writer, data, len, wake_now);
+        if (err) {
+            zym_runtimeError(vm, "Failed to write to file '%s': %s", file->path, strerror(err));
+            return false;
+        }
+        file->position += len;
+        return true;
+    }
+
+    return fwrite(data, 1, len, file->handle) == len;
+}
+
 ZymValue file_read(ZymVM* vm, ZymValue context) {
     FileData* file = (FileData*)zym_getNativeData(context);
 
@@ -109,6 +333,10 @@ ZymValue file_read(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     long original_pos = ftell(file->handle);
 
     fseek(file->handle, 0, SEEK_END);
@@ -149,6 +377,10 @@ ZymValue file_readBytes(ZymVM* vm, ZymValue context, ZymValue countVal) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     if (!zym_isNumber(countVal)) {
         zym_runtimeError(vm, "readBytes() requires a number argument");
         return ZYM_ERROR;
@@ -183,6 +415,10 @@ ZymValue file_readLine(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     size_t buffer_size = 256;
     char* buffer = malloc(buffer_size);
     if (!buffer) {
@@ -244,6 +480,10 @@ ZymValue file_readLines(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     ZymValue list = zym_newList(vm);
     zym_pushRoot(vm, list);
 
@@ -277,11 +517,13 @@ ZymValue file_write(ZymVM* vm, ZymValue context, ZymValue dataVal) {
     const char* data = zym_asCString(dataVal);
     size_t len = strlen(data);
 
-    size_t written = fwrite(data, 1, len, file->handle);
+    bool ok = file_put(vm, file, data, len, memchr(data, '\n', len) != NULL);
     sync_file_position(file);
 
-    if (written != len) {
-        zym_runtimeError(vm, "Failed to write all bytes to file");
+    if (!ok) {
+        if (!file->writer) {
+            zym_runtimeError(vm, "Failed to write all bytes to file");
+        }
         return ZYM_ERROR;
     }
 
@@ -304,18 +546,139 @@ ZymValue file_writeLine(ZymVM* vm, ZymValue context, ZymValue dataVal) {
     const char* data = zym_asCString(dataVal);
     size_t len = strlen(data);
 
-    size_t written = fwrite(data, 1, len, file->handle);
-    if (written != len) {
-        zym_runtimeError(vm, "Failed to write line to file");
+    if (!file_put(vm, file, data, len, false) || !file_put(vm, file, "\n", 1, true)) {
+        if (!file->writer) {
+            zym_runtimeError(vm, "Failed to write line to file");
+        }
         return ZYM_ERROR;
     }
 
-    fputc('\n', file->handle);
     sync_file_position(file);
 
     return context;
 }
 
+// Writes every string in the list with as few syscalls as possible: small
+// batches go through the stdio buffer, larger ones are flushed with writev().
+ZymValue file_writeAll(ZymVM* vm, ZymValue context, ZymValue listVal) {
+    FileData* file = (FileData*)zym_getNativeData(context);
+
+    if (!file->is_open || !file->handle) {
+        zym_runtimeError(vm, "File is not open");
+        return ZYM_ERROR;
+    }
+
+    if (!zym_isList(listVal)) {
+        zym_runtimeError(vm, "writeAll() requires a list of strings");
+        return ZYM_ERROR;
+    }
+
+    int count = zym_listLength(listVal);
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        ZymValue item = zym_listGet(vm, listVal, i);
+        if (!zym_isString(item)) {
+            zym_runtimeError(vm, "writeAll() list must contain only strings");
+            return ZYM_ERROR;
+        }
+        total += strlen(zym_asCString(item));
+    }
+
+    if (count == 0) {
+        return zym_newNumber(0);
+    }
+
+    if (file->writer) {
+        for (int i = 0; i < count; i++) {
+            const char* data = zym_asCString(zym_listGet(vm, listVal, i));
+            size_t len = strlen(data);
+            bool last = i == count - 1;
+            if (!file_put(vm, file, data, len, last)) {
+                return ZYM_ERROR;
+            }
+        }
+        return zym_newNumber((double)total);
+    }
+
+    size_t buffer_size = file->buffer_size ? file->buffer_size : BUFSIZ;
+
+#ifndef _WIN32
+    if (file->flush == FLUSH_NONE || total >= buffer_size / 2) {
+        if (fflush(file->handle) != 0) {
+            zym_runtimeError(vm, "Failed to flush file");
+            return ZYM_ERROR;
+        }
+
+        int fd = fileno(file->handle);
+    #ifdef IOV_MAX
+        int batch_max = IOV_MAX;
+    #else
+        int batch_max = 1024;
+    #endif
+        struct iovec* iov = malloc(sizeof(struct iovec) * (count < batch_max ? count : batch_max));
+        if (!iov) {
+            zym_runtimeError(vm, "Out of memory");
+            return ZYM_ERROR;
+        }
+
+        int index = 0;
+        while (index < count) {
+            int batch = 0;
+            while (batch < batch_max && index + batch < count) {
+                const char* data = zym_asCString(zym_listGet(vm, listVal, index + batch));
+                iov[batch].iov_base = (void*)data;
+                iov[batch].iov_len = strlen(data);
+                batch++;
+            }
+
+            struct iovec* cur = iov;
+            int remaining = batch;
+            while (remaining > 0) {
+                ssize_t n = writev(fd, cur, remaining);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    free(iov);
+                    zym_runtimeError(vm, "Failed to write to file '%s': %s", file->path, strerror(errno));
+                    return ZYM_ERROR;
+                }
+
+                // Skip fully written vectors and trim a partially written one
+                while (remaining > 0 && (size_t)n >= cur->iov_len) {
+                    n -= (ssize_t)cur->iov_len;
+                    cur++;
+                    remaining--;
+                }
+                if (remaining > 0) {
+                    cur->iov_base = (char*)cur->iov_base + n;
+                    cur->iov_len -= (size_t)n;
+                }
+            }
+
+            index += batch;
+        }
+
+        free(iov);
+
+        // The fd offset moved underneath stdio; resynchronise the stream
+        fseek(file->handle, 0, SEEK_CUR);
+        sync_file_position(file);
+        return zym_newNumber((double)total);
+    }
+#endif
+
+    for (int i = 0; i < count; i++) {
+        const char* data = zym_asCString(zym_listGet(vm, listVal, i));
+        size_t len = strlen(data);
+        if (fwrite(data, 1, len, file->handle) != len) {
+            zym_runtimeError(vm, "Failed to write all bytes to file");
+            return ZYM_ERROR;
+        }
+    }
+
+    sync_file_position(file);
+    return zym_newNumber((double)total);
+}
+
 ZymValue file_flush(ZymVM* vm, ZymValue context) {
     FileData* file = (FileData*)zym_getNativeData(context);
 
@@ -324,6 +687,10 @@ ZymValue file_flush(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     if (fflush(file->handle) != 0) {
         zym_runtimeError(vm, "Failed to flush file");
         return ZYM_ERROR;
@@ -340,6 +707,10 @@ ZymValue file_seek(ZymVM* vm, ZymValue context, ZymValue posVal) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     if (!zym_isNumber(posVal)) {
         zym_runtimeError(vm, "seek() requires a number argument");
         return ZYM_ERROR;
@@ -363,6 +734,10 @@ ZymValue file_tell(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     long pos = ftell(file->handle);
     if (pos < 0) {
         zym_runtimeError(vm, "Failed to get file position");
@@ -380,6 +755,10 @@ ZymValue file_size(ZymVM* vm, ZymValue context) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     long original_pos = ftell(file->handle);
     fseek(file->handle, 0, SEEK_END);
     long size = ftell(file->handle);
@@ -400,6 +779,10 @@ ZymValue file_eof(ZymVM* vm, ZymValue context) {
         return zym_newBool(true);
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     if (feof(file->handle)) {
         return zym_newBool(true);
     }
@@ -419,9 +802,11 @@ ZymValue file_close(ZymVM* vm, ZymValue context) {
         return context;
     }
 
-    fclose(file->handle);
-    file->handle = NULL;
-    file->is_open = false;
+    int err = file_close_handle(file);
+    if (err) {
+        zym_runtimeError(vm, "Failed to write to file '%s': %s", file->path, strerror(err));
+        return ZYM_ERROR;
+    }
 
     return context;
 }
@@ -454,6 +839,9 @@ ZymValue file_setPosition(ZymVM* vm, ZymValue context, ZymValue posVal) {
         return ZYM_ERROR;
     }
     if (file->is_open && file->handle) {
+        if (!file_quiesce(vm, file)) {
+            return ZYM_ERROR;
+        }
         long pos = (long)zym_asNumber(posVal);
         if (fseek(file->handle, pos, SEEK_SET) == 0) {
             file->position = (size_t)pos;
@@ -487,21 +875,22 @@ ZymValue file_readToBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
         return ZYM_ERROR;
     }
 
+    if (!file_quiesce(vm, file)) {
+        return ZYM_ERROR;
+    }
+
     if (!zym_isMap(bufferVal)) {
         zym_runtimeError(vm, "readToBuffer() requires a Buffer argument");
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Argument is not a valid Buffer");
         return ZYM_ERROR;
     }
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_writable(vm, buf)) {
         return ZYM_ERROR;
     }
 
@@ -551,16 +940,13 @@ ZymValue file_writeFromBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal, Z
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Argument is not a valid Buffer");
         return ZYM_ERROR;
     }
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_readable(vm, buf)) {
         return ZYM_ERROR;
     }
 
@@ -576,6 +962,14 @@ ZymValue file_writeFromBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal, Z
         return zym_newNumber(0);
     }
 
+    if (file->writer) {
+        if (!file_put(vm, file, (const char*)buf->data + buf->position, bytesToWrite, true)) {
+            return ZYM_ERROR;
+        }
+        buf->position += bytesToWrite;
+        return zym_newNumber((double)bytesToWrite);
+    }
+
     size_t written = fwrite(buf->data + buf->position, 1, bytesToWrite, file->handle);
     sync_file_position(file);
 
@@ -589,7 +983,7 @@ ZymValue file_writeFromBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal, Z
     return zym_newNumber((double)written);
 }
 
-ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
+ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal, ZymValue optionsVal) {
     if (!zym_isString(pathVal)) {
         zym_runtimeError(vm, "File.open() requires a string path");
         return ZYM_ERROR;
@@ -608,6 +1002,42 @@ ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
         }
     }
 
+    FlushPolicy flush_policy = FLUSH_SIZE;
+    size_t buffer_size = 0;
+    bool background = false;
+
+    if (zym_isMap(optionsVal)) {
+        ZymValue bufferSizeVal = zym_mapGet(vm, optionsVal, "bufferSize");
+        if (!zym_isNull(bufferSizeVal)) {
+            if (!zym_isNumber(bufferSizeVal) || zym_asNumber(bufferSizeVal) < 0) {
+                zym_runtimeError(vm, "fileOpen() option 'bufferSize' must be a non-negative number");
+                return ZYM_ERROR;
+            }
+            buffer_size = (size_t)zym_asNumber(bufferSizeVal);
+        }
+
+        ZymValue flushVal = zym_mapGet(vm, optionsVal, "flush");
+        if (!zym_isNull(flushVal)) {
+            const char* flush_str = zym_isString(flushVal) ? zym_asCString(flushVal) : "";
+            if (strcmp(flush_str, "size") == 0) flush_policy = FLUSH_SIZE;
+            else if (strcmp(flush_str, "none") == 0) flush_policy = FLUSH_NONE;
+            else if (strcmp(flush_str, "line") == 0) flush_policy = FLUSH_LINE;
+            else if (strcmp(flush_str, "manual") == 0) flush_policy = FLUSH_MANUAL;
+            else {
+                zym_runtimeError(vm, "fileOpen() option 'flush' must be one of \"none\", \"line\", \"size\", \"manual\"");
+                return ZYM_ERROR;
+            }
+        }
+
+        ZymValue backgroundVal = zym_mapGet(vm, optionsVal, "background");
+        if (zym_isBool(backgroundVal)) {
+            background = zym_asBool(backgroundVal);
+        }
+    } else if (!zym_isNull(optionsVal)) {
+        zym_runtimeError(vm, "fileOpen() options must be a map");
+        return ZYM_ERROR;
+    }
+
     const char* path = zym_asCString(pathVal);
 
     FileData* file = calloc(1, sizeof(FileData));
@@ -627,6 +1057,30 @@ ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
     file->mode = mode;
     file->is_open = true;
     file->position = 0;
+    file->flush = flush_policy;
+    file->buffer_size = buffer_size;
+
+    if (background) {
+        // The worker does its own batching, so stdio buffering is disabled
+        if (file->buffer_size == 0) file->buffer_size = FILE_DEFAULT_BUFFER_SIZE;
+        setvbuf(file->handle, NULL, _IONBF, 0);
+        file->writer = async_writer_start(file->handle, flush_policy, file->buffer_size);
+        if (!file->writer) {
+            file_cleanup(vm, file);
+            zym_runtimeError(vm, "Failed to start background writer for '%s'", path);
+            return ZYM_ERROR;
+        }
+    } else if (flush_policy == FLUSH_NONE) {
+        setvbuf(file->handle, NULL, _IONBF, 0);
+    } else if (flush_policy != FLUSH_SIZE || buffer_size > 0) {
+        // setvbuf() ignores the size for a NULL buffer on some libcs, so own it.
+        // MSVC has no real line buffering; _IOLBF behaves like _IOFBF there.
+        if (file->buffer_size == 0) file->buffer_size = FILE_DEFAULT_BUFFER_SIZE;
+        file->stdio_buffer = malloc(file->buffer_size);
+        if (file->stdio_buffer) {
+            setvbuf(file->handle, file->stdio_buffer, flush_policy == FLUSH_LINE ? _IOLBF : _IOFBF, file->buffer_size);
+        }
+    }
     ZymValue context = zym_createNativeContext(vm, file, file_cleanup);
     zym_pushRoot(vm, context);
 
@@ -648,6 +1102,7 @@ ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
     CREATE_METHOD_0(readLines, file_readLines);
     CREATE_METHOD_1(write, file_write);
     CREATE_METHOD_1(writeLine, file_writeLine);
+    CREATE_METHOD_1(writeAll, file_writeAll);
     CREATE_METHOD_0(flush, file_flush);
     CREATE_METHOD_1(seek, file_seek);
     CREATE_METHOD_0(tell, file_tell);
@@ -675,6 +1130,7 @@ ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
     zym_mapSet(vm, obj, "readLines", readLines);
     zym_mapSet(vm, obj, "write", write);
     zym_mapSet(vm, obj, "writeLine", writeLine);
+    zym_mapSet(vm, obj, "writeAll", writeAll);
     zym_mapSet(vm, obj, "flush", flush);
     zym_mapSet(vm, obj, "seek", seek);
     zym_mapSet(vm, obj, "tell", tell);
@@ -689,14 +1145,111 @@ ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
     zym_mapSet(vm, obj, "getPosition", getPosition);
     zym_mapSet(vm, obj, "setPosition", setPosition);
 
-    // (context + 19 methods + obj = 21)
-    for (int i = 0; i < 21; i++) {
+    // (context + 20 methods + obj = 22)
+    for (int i = 0; i < 22; i++) {
         zym_popRoot(vm);
     }
 
     return obj;
 }
 
+// The FileData behind a script File object, or NULL if `fileVal` is not an
+// open one
+static FileData* file_from_value(ZymVM* vm, ZymValue fileVal) {
+    if (!zym_isMap(fileVal)) {
+        return NULL;
+    }
+
+    ZymValue getMode = zym_mapGet(vm, fileVal, "getMode");
+    ZymValue readLines = zym_mapGet(vm, fileVal, "readLines");
+    if (zym_isNull(getMode) || zym_isNull(readLines)) {
+        return NULL;
+    }
+
+    FileData* file = (FileData*)zym_getNativeData(zym_getClosureContext(getMode));
+    if (!file || !file->is_open || !file->handle) {
+        return NULL;
+    }
+    return file;
+}
+
+static bool file_mode_readable(FileMode mode) {
+    return mode != FILE_MODE_WRITE && mode != FILE_MODE_WRITE_BINARY &&
+           mode != FILE_MODE_APPEND && mode != FILE_MODE_APPEND_BINARY;
+}
+
+static bool file_mode_writable(FileMode mode) {
+    return mode != FILE_MODE_READ && mode != FILE_MODE_READ_BINARY;
+}
+
+// Gives other natives (CSV, ...) a private read stream on a script File
+// object. The file is reopened by path rather than dup()ed, so the new
+// stream has its own offset and reading through it never moves the File's;
+// it starts at the File's current logical position. Returns NULL if
+// `fileVal` is not an open File or was not opened for reading.
+FILE* nativeFile_dupHandle(ZymVM* vm, ZymValue fileVal) {
+    FileData* file = file_from_value(vm, fileVal);
+    if (!file || !file_mode_readable(file->mode) || !file->path) {
+        return NULL;
+    }
+
+    if (file->writer && async_writer_drain(file->writer) != 0) {
+        return NULL;
+    }
+
+    long pos = ftell(file->handle);
+    fflush(file->handle);
+
+    FILE* handle = fopen(file->path, "rb");
+    if (handle && pos >= 0 && fseek(handle, pos, SEEK_SET) != 0) {
+        fclose(handle);
+        return NULL;
+    }
+    return handle;
+}
+
+bool nativeFile_isWritable(ZymVM* vm, ZymValue fileVal) {
+    FileData* file = file_from_value(vm, fileVal);
+    return file && file_mode_writable(file->mode);
+}
+
+// Writes through the File's own stream, as write() does, so whatever the
+// script writes to the File next follows on from this data
+bool nativeFile_writeBytes(ZymVM* vm, ZymValue fileVal, const char* data, size_t len) {
+    FileData* file = file_from_value(vm, fileVal);
+    if (!file || !file_mode_writable(file->mode)) {
+        zym_runtimeError(vm, "File is not open for writing");
+        return false;
+    }
+
+    bool ok = file_put(vm, file, data, len, memchr(data, '\n', len) != NULL);
+    sync_file_position(file);
+    if (!ok && !file->writer) {
+        zym_runtimeError(vm, "Failed to write all bytes to file");
+    }
+    return ok;
+}
+
+bool nativeFile_flush(ZymVM* vm, ZymValue fileVal) {
+    FileData* file = file_from_value(vm, fileVal);
+    if (!file) {
+        zym_runtimeError(vm, "File is not open");
+        return false;
+    }
+    if (!file_quiesce(vm, file)) {
+        return false;
+    }
+    if (fflush(file->handle) != 0) {
+        zym_runtimeError(vm, "Failed to flush file");
+        return false;
+    }
+    return true;
+}
+
+ZymValue nativeFile_open_2(ZymVM* vm, ZymValue pathVal, ZymValue modeVal) {
+    return nativeFile_open(vm, pathVal, modeVal, zym_newNull());
+}
+
 ZymValue nativeFile_readFile(ZymVM* vm, ZymValue pathVal) {
     if (!zym_isString(pathVal)) {
         zym_runtimeError(vm, "File.readFile() requires a string path");
@@ -909,22 +1462,400 @@ ZymValue nativeFile_stat(ZymVM* vm, ZymValue pathVal) {
     return info;
 }
 
-ZymValue nativeFile_readToNewBuffer(ZymVM* vm, ZymValue pathVal) {
-    if (!zym_isString(pathVal)) {
-        zym_runtimeError(vm, "fileReadBuffer() requires a string path");
-        return ZYM_ERROR;
-    }
+// ---- Batched stat ------------------------------------------------------------
+// fileStatMany() stats a whole list of paths off the VM thread and returns one
+// list (or Buffer of doubles) per requested field, instead of a map per file.
+// On Linux it uses statx() with only the fields actually asked for.
 
-    const char* path = zym_asCString(pathVal);
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        zym_runtimeError(vm, "Failed to open file '%s': %s", path, strerror(errno));
-        return ZYM_ERROR;
-    }
+typedef enum {
+    STATF_SIZE,
+    STATF_MODIFIED,
+    STATF_ACCESSED,
+    STATF_CHANGED,
+    STATF_CREATED,
+    STATF_MODE,
+    STATF_IS_FILE,
+    STATF_IS_DIRECTORY,
+    STATF_COUNT
+} StatField;
+
+static const char* stat_field_names[STATF_COUNT] = {
+    "size", "modified", "accessed", "changed", "created", "mode", "isFile", "isDirectory"
+};
 
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+typedef struct {
+    double values[STATF_COUNT];
+    uint16_t present;   // Bit per StatField; unset when the filesystem did not report it
+    bool exists;
+} StatResult;
+
+typedef struct {
+    char** paths;
+    StatResult* results;
+    size_t start;
+    size_t end;
+    uint32_t fields;
+} StatJob;
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+static unsigned int stat_fields_to_statx_mask(uint32_t fields) {
+    unsigned int mask = 0;
+    if (fields & (1u << STATF_SIZE)) mask |= STATX_SIZE;
+    if (fields & (1u << STATF_MODIFIED)) mask |= STATX_MTIME;
+    if (fields & (1u << STATF_ACCESSED)) mask |= STATX_ATIME;
+    if (fields & (1u << STATF_CHANGED)) mask |= STATX_CTIME;
+    if (fields & (1u << STATF_CREATED)) mask |= STATX_BTIME;
+    if (fields & ((1u << STATF_MODE) | (1u << STATF_IS_FILE) | (1u << STATF_IS_DIRECTORY))) {
+        mask |= STATX_TYPE | STATX_MODE;
+    }
+    return mask;
+}
+
+static inline double statx_time(struct statx_timestamp ts) {
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+#endif
+
+// Fractional seconds, matching what the statx path reports
+#if defined(_WIN32)
+    #define STAT_TIME(st, field) ((double)(st)->st_##field##time)
+#elif defined(__APPLE__)
+    #define STAT_TIME(st, field) \
+        ((double)(st)->st_##field##timespec.tv_sec + (double)(st)->st_##field##timespec.tv_nsec / 1e9)
+#else
+    #define STAT_TIME(st, field) \
+        ((double)(st)->st_##field##tim.tv_sec + (double)(st)->st_##field##tim.tv_nsec / 1e9)
+#endif
+
+static void stat_fill_from_stat(StatResult* result, const struct stat* st) {
+    result->values[STATF_SIZE] = (double)st->st_size;
+    result->values[STATF_MODIFIED] = STAT_TIME(st, m);
+    result->values[STATF_ACCESSED] = STAT_TIME(st, a);
+    result->values[STATF_MODE] = (double)(st->st_mode & 07777);
+    result->values[STATF_IS_FILE] = S_ISREG(st->st_mode) ? 1.0 : 0.0;
+    result->values[STATF_IS_DIRECTORY] = S_ISDIR(st->st_mode) ? 1.0 : 0.0;
+    result->present = (1u << STATF_SIZE) | (1u << STATF_MODIFIED) | (1u << STATF_ACCESSED) |
+                      (1u << STATF_MODE) | (1u << STATF_IS_FILE) | (1u << STATF_IS_DIRECTORY);
+#ifdef _WIN32
+    // st_ctime is the creation time on Windows
+    result->values[STATF_CREATED] = STAT_TIME(st, c);
+    result->present |= (1u << STATF_CREATED);
+#else
+    result->values[STATF_CHANGED] = STAT_TIME(st, c);
+    result->present |= (1u << STATF_CHANGED);
+#endif
+}
+
+static void stat_one(const char* path, uint32_t fields, StatResult* result) {
+    memset(result, 0, sizeof(StatResult));
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+    // Shared by every thread that stats files; set once the kernel says ENOSYS
+    static atomic_bool statx_unsupported = false;
+    if (!atomic_load_explicit(&statx_unsupported, memory_order_relaxed)) {
+        struct statx stx;
+        if (statx(AT_FDCWD, path, AT_STATX_DONT_SYNC, stat_fields_to_statx_mask(fields), &stx) == 0) {
+            result->exists = true;
+            if (stx.stx_mask & STATX_SIZE) {
+                result->values[STATF_SIZE] = (double)stx.stx_size;
+                result->present |= (1u << STATF_SIZE);
+            }
+            if (stx.stx_mask & STATX_MTIME) {
+                result->values[STATF_MODIFIED] = statx_time(stx.stx_mtime);
+                result->present |= (1u << STATF_MODIFIED);
+            }
+            if (stx.stx_mask & STATX_ATIME) {
+                result->values[STATF_ACCESSED] = statx_time(stx.stx_atime);
+                result->present |= (1u << STATF_ACCESSED);
+            }
+            if (stx.stx_mask & STATX_CTIME) {
+                result->values[STATF_CHANGED] = statx_time(stx.stx_ctime);
+                result->present |= (1u << STATF_CHANGED);
+            }
+            if (stx.stx_mask & STATX_BTIME) {
+                result->values[STATF_CREATED] = statx_time(stx.stx_btime);
+                result->present |= (1u << STATF_CREATED);
+            }
+            if (stx.stx_mask & STATX_TYPE) {
+                result->values[STATF_MODE] = (double)(stx.stx_mode & 07777);
+                result->values[STATF_IS_FILE] = S_ISREG(stx.stx_mode) ? 1.0 : 0.0;
+                result->values[STATF_IS_DIRECTORY] = S_ISDIR(stx.stx_mode) ? 1.0 : 0.0;
+                result->present |= (1u << STATF_MODE) | (1u << STATF_IS_FILE) | (1u << STATF_IS_DIRECTORY);
+            }
+            return;
+        }
+        if (errno != ENOSYS) {
+            return;
+        }
+        atomic_store_explicit(&statx_unsupported, true, memory_order_relaxed);
+    }
+#else
+    (void)fields;
+#endif
+
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        result->exists = true;
+        stat_fill_from_stat(result, &st);
+    }
+}
+
+static void stat_job_run(void* arg) {
+    StatJob* job = (StatJob*)arg;
+    for (size_t i = job->start; i < job->end; i++) {
+        stat_one(job->paths[i], job->fields, &job->results[i]);
+    }
+}
+
+// Below this many paths the thread startup cost outweighs the parallelism.
+#define STAT_MANY_PARALLEL_THRESHOLD 256
+
+static void stat_many_run(char** paths, StatResult* results, size_t count, uint32_t fields, int threads) {
+    if (threads > (int)(count / (STAT_MANY_PARALLEL_THRESHOLD / 4))) {
+        threads = (int)(count / (STAT_MANY_PARALLEL_THRESHOLD / 4));
+    }
+    if (count < STAT_MANY_PARALLEL_THRESHOLD || threads <= 1) {
+        StatJob job = { paths, results, 0, count, fields };
+        stat_job_run(&job);
+        return;
+    }
+
+    StatJob* jobs = calloc(threads, sizeof(StatJob));
+    ThreadHandle* handles = calloc(threads, sizeof(ThreadHandle));
+    if (!jobs || !handles) {
+        free(jobs);
+        free(handles);
+        StatJob job = { paths, results, 0, count, fields };
+        stat_job_run(&job);
+        return;
+    }
+
+    size_t per_thread = (count + threads - 1) / threads;
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        jobs[i].paths = paths;
+        jobs[i].results = results;
+        jobs[i].fields = fields;
+        jobs[i].start = (size_t)i * per_thread;
+        jobs[i].end = jobs[i].start + per_thread > count ? count : jobs[i].start + per_thread;
+        if (jobs[i].start >= jobs[i].end) {
+            continue;
+        }
+
+        // Thread 0's range is done on the calling thread below
+        if (i > 0 && thread_start(&handles[started], stat_job_run, &jobs[i])) {
+            started++;
+        } else if (i > 0) {
+            stat_job_run(&jobs[i]);
+        }
+    }
+
+    stat_job_run(&jobs[0]);
+
+    for (int i = 0; i < started; i++) {
+        thread_join(handles[i]);
+    }
+
+    free(jobs);
+    free(handles);
+}
+
+static ZymValue stat_many_make_buffer(ZymVM* vm, const StatResult* results, size_t count, int field, bool is_exists) {
+    ZymValue buffer = nativeBuffer_create_auto(vm, zym_newNumber((double)(count > 0 ? count * 8 : 8)));
+    if (buffer == ZYM_ERROR || zym_isNull(buffer)) {
+        return ZYM_ERROR;
+    }
+
+    BufferData* buf = buffer_from_value(vm, buffer);
+
+    // Doubles are stored little-endian, matching the Buffer default
+    for (size_t i = 0; i < count; i++) {
+        double value;
+        if (is_exists) {
+            value = results[i].exists ? 1.0 : 0.0;
+        } else {
+            value = (results[i].present & (1u << field)) ? results[i].values[field] : -1.0;
+        }
+
+        uint64_t bits;
+        memcpy(&bits, &value, 8);
+        for (int b = 0; b < 8; b++) {
+            buf->data[i * 8 + b] = (uint8_t)(bits >> (b * 8));
+        }
+    }
+    buf->length = count * 8;
+    buf->position = 0;
+
+    return buffer;
+}
+
+static ZymValue stat_many_make_list(ZymVM* vm, const StatResult* results, size_t count, int field, bool is_exists) {
+    ZymValue list = zym_newList(vm);
+    zym_pushRoot(vm, list);
+
+    bool as_bool = is_exists || field == STATF_IS_FILE || field == STATF_IS_DIRECTORY;
+
+    for (size_t i = 0; i < count; i++) {
+        ZymValue value;
+        if (is_exists) {
+            value = zym_newBool(results[i].exists);
+        } else if (!(results[i].present & (1u << field))) {
+            value = zym_newNull();
+        } else if (as_bool) {
+            value = zym_newBool(results[i].values[field] != 0.0);
+        } else {
+            value = zym_newNumber(results[i].values[field]);
+        }
+        zym_listAppend(vm, list, value);
+    }
+
+    zym_popRoot(vm);
+    return list;
+}
+
+ZymValue nativeFile_statMany(ZymVM* vm, ZymValue pathsVal, ZymValue fieldsVal, ZymValue optionsVal) {
+    if (!zym_isList(pathsVal)) {
+        zym_runtimeError(vm, "fileStatMany() requires a list of paths");
+        return ZYM_ERROR;
+    }
+    if (!zym_isList(fieldsVal)) {
+        zym_runtimeError(vm, "fileStatMany() requires a list of field names");
+        return ZYM_ERROR;
+    }
+
+    uint32_t fields = 0;
+    int field_count = zym_listLength(fieldsVal);
+    for (int i = 0; i < field_count; i++) {
+        ZymValue fieldVal = zym_listGet(vm, fieldsVal, i);
+        if (!zym_isString(fieldVal)) {
+            zym_runtimeError(vm, "fileStatMany() field names must be strings");
+            return ZYM_ERROR;
+        }
+
+        const char* name = zym_asCString(fieldVal);
+        if (strcmp(name, "exists") == 0) {
+            continue;
+        }
+
+        int found = -1;
+        for (int f = 0; f < STATF_COUNT; f++) {
+            if (strcmp(name, stat_field_names[f]) == 0) {
+                found = f;
+                break;
+            }
+        }
+        if (found < 0) {
+            zym_runtimeError(vm, "fileStatMany() unknown field '%s'", name);
+            return ZYM_ERROR;
+        }
+        fields |= (1u << found);
+    }
+
+    int threads = thread_cpu_count();
+    if (threads > 8) threads = 8;
+    bool as_buffers = false;
+
+    if (zym_isMap(optionsVal)) {
+        ZymValue threadsVal = zym_mapGet(vm, optionsVal, "threads");
+        if (zym_isNumber(threadsVal)) {
+            threads = (int)zym_asNumber(threadsVal);
+            if (threads < 1) threads = 1;
+            if (threads > 64) threads = 64;
+        }
+
+        ZymValue buffersVal = zym_mapGet(vm, optionsVal, "buffers");
+        if (zym_isBool(buffersVal)) {
+            as_buffers = zym_asBool(buffersVal);
+        }
+    } else if (!zym_isNull(optionsVal)) {
+        zym_runtimeError(vm, "fileStatMany() options must be a map");
+        return ZYM_ERROR;
+    }
+
+    size_t count = (size_t)zym_listLength(pathsVal);
+    char** paths = calloc(count > 0 ? count : 1, sizeof(char*));
+    StatResult* results = calloc(count > 0 ? count : 1, sizeof(StatResult));
+    if (!paths || !results) {
+        free(paths);
+        free(results);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    // Paths are copied out so worker threads never touch VM objects
+    for (size_t i = 0; i < count; i++) {
+        ZymValue pathVal = zym_listGet(vm, pathsVal, (int)i);
+        if (!zym_isString(pathVal)) {
+            for (size_t j = 0; j < i; j++) free(paths[j]);
+            free(paths);
+            free(results);
+            zym_runtimeError(vm, "fileStatMany() paths must be strings");
+            return ZYM_ERROR;
+        }
+        paths[i] = strdup(zym_asCString(pathVal));
+    }
+
+    stat_many_run(paths, results, count, fields, threads);
+
+    for (size_t i = 0; i < count; i++) free(paths[i]);
+    free(paths);
+
+    ZymValue out = zym_newMap(vm);
+    zym_pushRoot(vm, out);
+
+    ZymValue column = as_buffers ? stat_many_make_buffer(vm, results, count, 0, true)
+                                 : stat_many_make_list(vm, results, count, 0, true);
+    if (column == ZYM_ERROR) {
+        zym_popRoot(vm);
+        free(results);
+        return ZYM_ERROR;
+    }
+    zym_pushRoot(vm, column);
+    zym_mapSet(vm, out, "exists", column);
+    zym_popRoot(vm);
+
+    for (int f = 0; f < STATF_COUNT; f++) {
+        if (!(fields & (1u << f))) {
+            continue;
+        }
+
+        column = as_buffers ? stat_many_make_buffer(vm, results, count, f, false)
+                            : stat_many_make_list(vm, results, count, f, false);
+        if (column == ZYM_ERROR) {
+            zym_popRoot(vm);
+            free(results);
+            return ZYM_ERROR;
+        }
+        zym_pushRoot(vm, column);
+        zym_mapSet(vm, out, stat_field_names[f], column);
+        zym_popRoot(vm);
+    }
+
+    free(results);
+    zym_popRoot(vm);
+    return out;
+}
+
+ZymValue nativeFile_statMany_2(ZymVM* vm, ZymValue pathsVal, ZymValue fieldsVal) {
+    return nativeFile_statMany(vm, pathsVal, fieldsVal, zym_newNull());
+}
+
+ZymValue nativeFile_readToNewBuffer(ZymVM* vm, ZymValue pathVal) {
+    if (!zym_isString(pathVal)) {
+        zym_runtimeError(vm, "fileReadBuffer() requires a string path");
+        return ZYM_ERROR;
+    }
+
+    const char* path = zym_asCString(pathVal);
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        zym_runtimeError(vm, "Failed to open file '%s': %s", path, strerror(errno));
+        return ZYM_ERROR;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
 
     if (size < 0) {
         fclose(f);
@@ -941,16 +1872,7 @@ ZymValue nativeFile_readToNewBuffer(ZymVM* vm, ZymValue pathVal) {
 
     zym_pushRoot(vm, buffer);
 
-    ZymValue getLength = zym_mapGet(vm, buffer, "getLength");
-    if (zym_isNull(getLength)) {
-        fclose(f);
-        zym_popRoot(vm);
-        zym_runtimeError(vm, "Invalid buffer object");
-        return ZYM_ERROR;
-    }
-
-    ZymValue context = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(context);
+    BufferData* buf = buffer_from_value(vm, buffer);
     if (!buf) {
         fclose(f);
         zym_popRoot(vm);
@@ -987,16 +1909,13 @@ ZymValue nativeFile_writeFromNewBuffer(ZymVM* vm, ZymValue pathVal, ZymValue buf
 
     const char* path = zym_asCString(pathVal);
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Argument is not a valid Buffer");
         return ZYM_ERROR;
     }
 
-    ZymValue context = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(context);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_readable(vm, buf)) {
         return ZYM_ERROR;
     }
 
@@ -1125,6 +2044,1019 @@ ZymValue nativeDir_exists(ZymVM* vm, ZymValue pathVal) {
     return zym_newBool(S_ISDIR(st.st_mode));
 }
 
+// ---- Directory walking -------------------------------------------------------
+// dirWalk()/dirWalker() take the entry type straight from readdir's d_type and
+// only fall back to fstatat() for DT_UNKNOWN (or when resolving symlinks), so a
+// traversal costs one getdents per directory instead of one stat per entry.
+
+typedef enum {
+    WALK_FILE,
+    WALK_DIR,
+    WALK_SYMLINK,
+    WALK_OTHER
+} WalkEntryType;
+
+typedef struct {
+    char* path;
+    size_t name_offset;
+    WalkEntryType type;
+    int depth;
+} WalkEntry;
+
+typedef struct {
+    WalkEntry* items;
+    size_t count;
+    size_t capacity;
+} WalkEntryList;
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    bool used;
+} WalkVisitedSlot;
+
+typedef struct {
+    WalkVisitedSlot* slots;
+    size_t capacity;
+    size_t count;
+    Mutex lock;
+} WalkVisited;
+
+typedef struct {
+    int max_depth;
+    bool follow_symlinks;
+    char** include;
+    int include_count;
+    char** exclude;
+    int exclude_count;
+    int threads;
+    size_t root_len;
+    WalkVisited visited;
+} WalkOptions;
+
+typedef struct {
+#ifdef _WIN32
+    HANDLE find;
+    WIN32_FIND_DATAA data;
+    bool started;
+#else
+    DIR* dir;
+#endif
+} WalkDir;
+
+static const char* walk_type_name(WalkEntryType type) {
+    switch (type) {
+        case WALK_FILE: return "file";
+        case WALK_DIR: return "dir";
+        case WALK_SYMLINK: return "symlink";
+        default: return "other";
+    }
+}
+
+static inline bool walk_is_sep(char c) {
+    return c == '/' || c == PATH_SEP;
+}
+
+// Glob matcher: '*' and '?' stay within one path segment, '**' crosses
+// separators, '[a-z]' / '[!a-z]' are character classes.
+static bool walk_glob_match(const char* pattern, const char* text) {
+    while (*pattern) {
+        if (*pattern == '*') {
+            bool any_depth = pattern[1] == '*';
+            pattern += any_depth ? 2 : 1;
+
+            if (any_depth && *pattern == '/') {
+                pattern++;
+                for (const char* t = text; ; t++) {
+                    if ((t == text || walk_is_sep(t[-1])) && walk_glob_match(pattern, t)) return true;
+                    if (*t == '\0') return false;
+                }
+            }
+
+            for (const char* t = text; ; t++) {
+                if (walk_glob_match(pattern, t)) return true;
+                if (*t == '\0' || (!any_depth && walk_is_sep(*t))) return false;
+            }
+        }
+
+        if (*text == '\0') {
+            return false;
+        }
+
+        if (*pattern == '?') {
+            if (walk_is_sep(*text)) return false;
+            pattern++;
+            text++;
+            continue;
+        }
+
+        if (*pattern == '[') {
+            const char* p = pattern + 1;
+            bool negate = (*p == '!' || *p == '^');
+            if (negate) p++;
+
+            bool matched = false;
+            bool first = true;
+            while (*p && (*p != ']' || first)) {
+                first = false;
+                if (p[1] == '-' && p[2] && p[2] != ']') {
+                    if ((unsigned char)*text >= (unsigned char)p[0] &&
+                        (unsigned char)*text <= (unsigned char)p[2]) {
+                        matched = true;
+                    }
+                    p += 3;
+                } else {
+                    if (*p == *text) matched = true;
+                    p++;
+                }
+            }
+
+            if (*p == ']') {
+                if (matched == negate) return false;
+                pattern = p + 1;
+                text++;
+                continue;
+            }
+            // Unterminated class: treat '[' literally
+        }
+
+#ifndef _WIN32
+        if (*pattern == '\\' && pattern[1]) {
+            pattern++;
+        }
+#endif
+
+        if (*pattern == '/' ? !walk_is_sep(*text) : *pattern != *text) {
+            return false;
+        }
+        pattern++;
+        text++;
+    }
+
+    return *text == '\0';
+}
+
+static bool walk_matches_any(char** patterns, int count, const char* rel_path, const char* name) {
+    for (int i = 0; i < count; i++) {
+        // Patterns containing a separator match the path relative to the root
+        const char* target = strchr(patterns[i], '/') ? rel_path : name;
+        if (walk_glob_match(patterns[i], target)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef enum {
+    WALK_OPEN_OK,
+    WALK_OPEN_SKIP,     // Unreadable, or already visited through another link
+    WALK_OPEN_NO_MEMORY
+} WalkOpenResult;
+
+// Records the directory identified by (dev, ino): the device and inode, or on
+// Windows the volume serial number and file index. Returns WALK_OPEN_SKIP if
+// it was already present. Only consulted when following symlinks, where it is
+// the only thing preventing cycles.
+static WalkOpenResult walk_visited_insert(WalkVisited* visited, uint64_t dev, uint64_t ino) {
+    mutex_lock(&visited->lock);
+
+    if ((visited->count + 1) * 2 > visited->capacity) {
+        size_t new_capacity = visited->capacity ? visited->capacity * 2 : 256;
+        WalkVisitedSlot* new_slots = calloc(new_capacity, sizeof(WalkVisitedSlot));
+        if (!new_slots) {
+            mutex_unlock(&visited->lock);
+            return WALK_OPEN_NO_MEMORY;
+        }
+        for (size_t i = 0; i < visited->capacity; i++) {
+            if (!visited->slots[i].used) continue;
+            uint64_t h = (visited->slots[i].dev * 0x9E3779B97F4A7C15ULL) ^ visited->slots[i].ino;
+            size_t idx = (size_t)(h * 0x9E3779B97F4A7C15ULL) & (new_capacity - 1);
+            while (new_slots[idx].used) idx = (idx + 1) & (new_capacity - 1);
+            new_slots[idx] = visited->slots[i];
+        }
+        free(visited->slots);
+        visited->slots = new_slots;
+        visited->capacity = new_capacity;
+    }
+
+    uint64_t h = (dev * 0x9E3779B97F4A7C15ULL) ^ ino;
+    size_t idx = (size_t)(h * 0x9E3779B97F4A7C15ULL) & (visited->capacity - 1);
+    while (visited->slots[idx].used) {
+        if (visited->slots[idx].dev == dev && visited->slots[idx].ino == ino) {
+            mutex_unlock(&visited->lock);
+            return WALK_OPEN_SKIP;
+        }
+        idx = (idx + 1) & (visited->capacity - 1);
+    }
+
+    visited->slots[idx].dev = dev;
+    visited->slots[idx].ino = ino;
+    visited->slots[idx].used = true;
+    visited->count++;
+
+    mutex_unlock(&visited->lock);
+    return WALK_OPEN_OK;
+}
+
+static WalkOpenResult walk_dir_open(WalkDir* wd, const char* path, WalkOptions* opts) {
+#ifdef _WIN32
+    wd->find = INVALID_HANDLE_VALUE;
+    if (opts->follow_symlinks) {
+        // Junctions and directory symlinks can point back up the tree; the
+        // handle is opened through any reparse point, so it names the target
+        HANDLE dir = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+        if (dir == INVALID_HANDLE_VALUE) {
+            return WALK_OPEN_SKIP;
+        }
+        BY_HANDLE_FILE_INFORMATION info;
+        BOOL have_info = GetFileInformationByHandle(dir, &info);
+        CloseHandle(dir);
+        if (!have_info) {
+            return WALK_OPEN_SKIP;
+        }
+        uint64_t index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+        WalkOpenResult seen = walk_visited_insert(&opts->visited, (uint64_t)info.dwVolumeSerialNumber, index);
+        if (seen != WALK_OPEN_OK) {
+            return seen;
+        }
+    }
+
+    char search_path[MAX_PATH];
+    snprintf(search_path, MAX_PATH, "%s\\*", path);
+    wd->find = FindFirstFileA(search_path, &wd->data);
+    wd->started = false;
+    return wd->find != INVALID_HANDLE_VALUE ? WALK_OPEN_OK : WALK_OPEN_SKIP;
+#else
+    wd->dir = opendir(path);
+    if (!wd->dir) {
+        return WALK_OPEN_SKIP;
+    }
+
+    if (opts->follow_symlinks) {
+        struct stat st;
+        WalkOpenResult seen = fstat(dirfd(wd->dir), &st) == 0
+            ? walk_visited_insert(&opts->visited, (uint64_t)st.st_dev, (uint64_t)st.st_ino)
+            : WALK_OPEN_OK;
+        if (seen != WALK_OPEN_OK) {
+            closedir(wd->dir);
+            wd->dir = NULL;
+            return seen;
+        }
+    }
+    return WALK_OPEN_OK;
+#endif
+}
+
+// Returns the next entry name (valid until the following call) or NULL.
+static const char* walk_dir_next(WalkDir* wd, const WalkOptions* opts, WalkEntryType* type) {
+#ifdef _WIN32
+    for (;;) {
+        if (wd->started && !FindNextFileA(wd->find, &wd->data)) {
+            return NULL;
+        }
+        wd->started = true;
+
+        const char* name = wd->data.cFileName;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+
+        DWORD attrs = wd->data.dwFileAttributes;
+        if ((attrs & FILE_ATTRIBUTE_REPARSE_POINT) && !opts->follow_symlinks) {
+            *type = WALK_SYMLINK;
+        } else if (attrs & FILE_ATTRIBUTE_DIRECTORY) {
+            *type = WALK_DIR;
+        } else {
+            *type = WALK_FILE;
+        }
+        return name;
+    }
+#else
+    struct dirent* entry;
+    while ((entry = readdir(wd->dir)) != NULL) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+#ifdef DT_UNKNOWN
+        unsigned char dtype = entry->d_type;
+        bool need_stat = dtype == DT_UNKNOWN || (dtype == DT_LNK && opts->follow_symlinks);
+        *type = dtype == DT_DIR ? WALK_DIR :
+                dtype == DT_REG ? WALK_FILE :
+                dtype == DT_LNK ? WALK_SYMLINK : WALK_OTHER;
+#else
+        bool need_stat = true;
+        *type = WALK_OTHER;
+#endif
+
+        if (need_stat) {
+            struct stat st;
+            int flags = opts->follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (fstatat(dirfd(wd->dir), name, &st, flags) == 0) {
+                if (S_ISDIR(st.st_mode)) *type = WALK_DIR;
+                else if (S_ISREG(st.st_mode)) *type = WALK_FILE;
+                else if (S_ISLNK(st.st_mode)) *type = WALK_SYMLINK;
+                else *type = WALK_OTHER;
+            }
+        }
+        return name;
+    }
+    return NULL;
+#endif
+}
+
+static void walk_dir_close(WalkDir* wd) {
+#ifdef _WIN32
+    if (wd->find != INVALID_HANDLE_VALUE) {
+        FindClose(wd->find);
+        wd->find = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (wd->dir) {
+        closedir(wd->dir);
+        wd->dir = NULL;
+    }
+#endif
+}
+
+static char* walk_join(const char* parent, const char* name, size_t* name_offset) {
+    size_t parent_len = strlen(parent);
+    size_t name_len = strlen(name);
+    bool has_sep = parent_len > 0 && walk_is_sep(parent[parent_len - 1]);
+
+    char* path = malloc(parent_len + name_len + 2);
+    if (!path) {
+        return NULL;
+    }
+
+    memcpy(path, parent, parent_len);
+    size_t pos = parent_len;
+    if (!has_sep) {
+        path[pos++] = PATH_SEP;
+    }
+    memcpy(path + pos, name, name_len + 1);
+
+    *name_offset = pos;
+    return path;
+}
+
+static const char* walk_relative(const WalkOptions* opts, const char* path) {
+    const char* rel = path + opts->root_len;
+    while (walk_is_sep(*rel)) rel++;
+    return rel;
+}
+
+static bool walk_list_push(WalkEntryList* list, WalkEntry entry) {
+    if (list->count == list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : 64;
+        WalkEntry* new_items = realloc(list->items, new_capacity * sizeof(WalkEntry));
+        if (!new_items) {
+            return false;
+        }
+        list->items = new_items;
+        list->capacity = new_capacity;
+    }
+    list->items[list->count++] = entry;
+    return true;
+}
+
+static void walk_list_free(WalkEntryList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->items[i].path);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// Decides what happens to one child entry: reported, descended into, or both.
+static void walk_classify(const WalkOptions* opts, const char* path, size_t name_offset,
+                          WalkEntryType type, int depth, bool* report, bool* descend) {
+    const char* name = path + name_offset;
+    const char* rel = walk_relative(opts, path);
+
+    if (opts->exclude_count > 0 && walk_matches_any(opts->exclude, opts->exclude_count, rel, name)) {
+        *report = false;
+        *descend = false;
+        return;
+    }
+
+    *report = opts->include_count == 0 || walk_matches_any(opts->include, opts->include_count, rel, name);
+    *descend = type == WALK_DIR && (opts->max_depth < 0 || depth < opts->max_depth);
+}
+
+typedef bool (*WalkPushDir)(void* ctx, char* path, int depth);
+
+// Reads one directory, appending reported entries to `out` and handing every
+// subdirectory to `push_dir`. Returns false only on allocation failure.
+static bool walk_scan_dir(WalkOptions* opts, const char* dir_path, int dir_depth,
+                          WalkEntryList* out, WalkPushDir push_dir, void* ctx) {
+    WalkDir wd;
+    WalkOpenResult opened = walk_dir_open(&wd, dir_path, opts);
+    if (opened != WALK_OPEN_OK) {
+        return opened == WALK_OPEN_SKIP;  // Unreadable directories are skipped
+    }
+
+    int depth = dir_depth + 1;
+    WalkEntryType type;
+    const char* name;
+    bool ok = true;
+
+    while (ok && (name = walk_dir_next(&wd, opts, &type)) != NULL) {
+        size_t name_offset;
+        char* path = walk_join(dir_path, name, &name_offset);
+        if (!path) {
+            ok = false;
+            break;
+        }
+
+        bool report, descend;
+        walk_classify(opts, path, name_offset, type, depth, &report, &descend);
+
+        if (descend) {
+            char* dir_copy = report ? strdup(path) : path;
+            if (!dir_copy || !push_dir(ctx, dir_copy, depth)) {
+                free(dir_copy);
+                if (report) free(path);
+                ok = false;
+                break;
+            }
+        }
+
+        if (report) {
+            WalkEntry entry = { path, name_offset, type, depth };
+            if (!walk_list_push(out, entry)) {
+                free(path);
+                ok = false;
+            }
+        } else if (!descend) {
+            free(path);
+        }
+    }
+
+    walk_dir_close(&wd);
+    return ok;
+}
+
+typedef struct {
+    char* path;
+    int depth;
+} WalkTask;
+
+typedef struct {
+    WalkOptions* opts;
+    WalkTask* tasks;
+    size_t task_count;
+    size_t task_capacity;
+    size_t active;
+    bool failed;
+    Mutex lock;
+    CondVar cond;
+} WalkShared;
+
+typedef struct {
+    WalkShared* shared;
+    WalkEntryList results;
+} WalkWorker;
+
+static bool walk_push_task(WalkShared* shared, char* path, int depth) {
+    if (shared->task_count == shared->task_capacity) {
+        size_t new_capacity = shared->task_capacity ? shared->task_capacity * 2 : 64;
+        WalkTask* new_tasks = realloc(shared->tasks, new_capacity * sizeof(WalkTask));
+        if (!new_tasks) {
+            return false;
+        }
+        shared->tasks = new_tasks;
+        shared->task_capacity = new_capacity;
+    }
+    shared->tasks[shared->task_count].path = path;
+    shared->tasks[shared->task_count].depth = depth;
+    shared->task_count++;
+    return true;
+}
+
+static bool walk_push_local(void* ctx, char* path, int depth) {
+    return walk_push_task((WalkShared*)ctx, path, depth);
+}
+
+static bool walk_push_locked(void* ctx, char* path, int depth) {
+    WalkShared* shared = (WalkShared*)ctx;
+    mutex_lock(&shared->lock);
+    bool ok = walk_push_task(shared, path, depth);
+    if (ok) {
+        condvar_signal(&shared->cond);
+    }
+    mutex_unlock(&shared->lock);
+    return ok;
+}
+
+static void walk_worker_main(void* arg) {
+    WalkWorker* worker = (WalkWorker*)arg;
+    WalkShared* shared = worker->shared;
+
+    mutex_lock(&shared->lock);
+    for (;;) {
+        while (shared->task_count == 0 && shared->active > 0 && !shared->failed) {
+            condvar_wait(&shared->cond, &shared->lock);
+        }
+        if (shared->task_count == 0 || shared->failed) {
+            break;
+        }
+
+        WalkTask task = shared->tasks[--shared->task_count];
+        shared->active++;
+        mutex_unlock(&shared->lock);
+
+        bool ok = walk_scan_dir(shared->opts, task.path, task.depth, &worker->results, walk_push_locked, shared);
+        free(task.path);
+
+        mutex_lock(&shared->lock);
+        shared->active--;
+        if (!ok) {
+            shared->failed = true;
+        }
+        if ((shared->active == 0 && shared->task_count == 0) || shared->failed) {
+            condvar_broadcast(&shared->cond);
+        }
+    }
+    mutex_unlock(&shared->lock);
+}
+
+// Collects every entry under the root. With threads > 1 directories are
+// fanned out across workers and the result order is unspecified.
+static bool walk_collect(WalkOptions* opts, const char* root, WalkEntryList* out) {
+    WalkShared shared;
+    memset(&shared, 0, sizeof(shared));
+    shared.opts = opts;
+
+    char* root_copy = strdup(root);
+    if (!root_copy || !walk_push_task(&shared, root_copy, 0)) {
+        free(root_copy);
+        return false;
+    }
+
+    if (opts->threads <= 1) {
+        bool ok = true;
+        while (ok && shared.task_count > 0) {
+            WalkTask task = shared.tasks[--shared.task_count];
+            ok = walk_scan_dir(opts, task.path, task.depth, out, walk_push_local, &shared);
+            free(task.path);
+        }
+        for (size_t i = 0; i < shared.task_count; i++) free(shared.tasks[i].path);
+        free(shared.tasks);
+        return ok;
+    }
+
+    mutex_init(&shared.lock);
+    condvar_init(&shared.cond);
+
+    int thread_count = opts->threads;
+    WalkWorker* workers = calloc(thread_count, sizeof(WalkWorker));
+    ThreadHandle* handles = calloc(thread_count, sizeof(ThreadHandle));
+    int started = 0;
+
+    if (workers && handles) {
+        for (int i = 0; i < thread_count; i++) {
+            workers[i].shared = &shared;
+            if (!thread_start(&handles[i], walk_worker_main, &workers[i])) {
+                break;
+            }
+            started++;
+        }
+    }
+
+    if (started == 0) {
+        // Could not start any thread: walk on this one instead
+        WalkWorker self = { &shared, { NULL, 0, 0 } };
+        walk_worker_main(&self);
+        *out = self.results;
+    } else {
+        for (int i = 0; i < started; i++) {
+            thread_join(handles[i]);
+        }
+        for (int i = 0; i < started; i++) {
+            WalkEntryList* part = &workers[i].results;
+            for (size_t j = 0; j < part->count; j++) {
+                if (!walk_list_push(out, part->items[j])) {
+                    free(part->items[j].path);
+                    shared.failed = true;
+                }
+            }
+            free(part->items);
+        }
+    }
+
+    for (size_t i = 0; i < shared.task_count; i++) free(shared.tasks[i].path);
+    free(shared.tasks);
+    free(workers);
+    free(handles);
+    condvar_destroy(&shared.cond);
+    mutex_destroy(&shared.lock);
+
+    return !shared.failed;
+}
+
+static void walk_options_free(WalkOptions* opts) {
+    for (int i = 0; i < opts->include_count; i++) free(opts->include[i]);
+    for (int i = 0; i < opts->exclude_count; i++) free(opts->exclude[i]);
+    free(opts->include);
+    free(opts->exclude);
+    free(opts->visited.slots);
+    mutex_destroy(&opts->visited.lock);
+}
+
+static bool walk_parse_patterns(ZymVM* vm, ZymValue val, const char* option, char*** out, int* out_count) {
+    *out = NULL;
+    *out_count = 0;
+
+    if (zym_isNull(val)) {
+        return true;
+    }
+
+    if (zym_isString(val)) {
+        *out = malloc(sizeof(char*));
+        if (!*out) {
+            zym_runtimeError(vm, "Out of memory");
+            return false;
+        }
+        (*out)[0] = strdup(zym_asCString(val));
+        *out_count = 1;
+        return true;
+    }
+
+    if (!zym_isList(val)) {
+        zym_runtimeError(vm, "dirWalk() option '%s' must be a string or a list of strings", option);
+        return false;
+    }
+
+    int count = zym_listLength(val);
+    *out = calloc(count > 0 ? count : 1, sizeof(char*));
+    if (!*out) {
+        zym_runtimeError(vm, "Out of memory");
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        ZymValue item = zym_listGet(vm, val, i);
+        if (!zym_isString(item)) {
+            zym_runtimeError(vm, "dirWalk() option '%s' must contain only strings", option);
+            return false;
+        }
+        (*out)[(*out_count)++] = strdup(zym_asCString(item));
+    }
+    return true;
+}
+
+static bool walk_parse_options(ZymVM* vm, ZymValue pathVal, ZymValue optionsVal, WalkOptions* opts) {
+    memset(opts, 0, sizeof(WalkOptions));
+    opts->max_depth = -1;
+    opts->threads = 1;
+    mutex_init(&opts->visited.lock);
+
+    if (!zym_isString(pathVal)) {
+        zym_runtimeError(vm, "dirWalk() requires a string path");
+        return false;
+    }
+    opts->root_len = strlen(zym_asCString(pathVal));
+
+    if (zym_isNull(optionsVal)) {
+        return true;
+    }
+    if (!zym_isMap(optionsVal)) {
+        zym_runtimeError(vm, "dirWalk() options must be a map");
+        return false;
+    }
+
+    ZymValue maxDepthVal = zym_mapGet(vm, optionsVal, "maxDepth");
+    if (zym_isNumber(maxDepthVal)) {
+        opts->max_depth = (int)zym_asNumber(maxDepthVal);
+    }
+
+    ZymValue followVal = zym_mapGet(vm, optionsVal, "followSymlinks");
+    if (zym_isBool(followVal)) {
+        opts->follow_symlinks = zym_asBool(followVal);
+    }
+
+    ZymValue threadsVal = zym_mapGet(vm, optionsVal, "threads");
+    if (zym_isNumber(threadsVal)) {
+        int threads = (int)zym_asNumber(threadsVal);
+        if (threads <= 0) threads = thread_cpu_count();
+        opts->threads = threads > 64 ? 64 : threads;
+    }
+
+    if (!walk_parse_patterns(vm, zym_mapGet(vm, optionsVal, "include"), "include", &opts->include, &opts->include_count)) {
+        return false;
+    }
+    if (!walk_parse_patterns(vm, zym_mapGet(vm, optionsVal, "exclude"), "exclude", &opts->exclude, &opts->exclude_count)) {
+        return false;
+    }
+
+    return true;
+}
+
+static ZymValue walk_entry_to_value(ZymVM* vm, const WalkEntry* entry) {
+    ZymValue info = zym_newMap(vm);
+    zym_pushRoot(vm, info);
+
+    ZymValue pathStr = zym_newString(vm, entry->path);
+    zym_pushRoot(vm, pathStr);
+    zym_mapSet(vm, info, "path", pathStr);
+    zym_popRoot(vm);
+
+    ZymValue nameStr = zym_newString(vm, entry->path + entry->name_offset);
+    zym_pushRoot(vm, nameStr);
+    zym_mapSet(vm, info, "name", nameStr);
+    zym_popRoot(vm);
+
+    ZymValue typeStr = zym_newString(vm, walk_type_name(entry->type));
+    zym_pushRoot(vm, typeStr);
+    zym_mapSet(vm, info, "type", typeStr);
+    zym_popRoot(vm);
+
+    zym_mapSet(vm, info, "depth", zym_newNumber((double)entry->depth));
+
+    zym_popRoot(vm);
+    return info;
+}
+
+static bool walk_check_root(ZymVM* vm, const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        zym_runtimeError(vm, "Failed to open directory '%s': %s", path, strerror(errno));
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        zym_runtimeError(vm, "dirWalk() path is not a directory: '%s'", path);
+        return false;
+    }
+    return true;
+}
+
+ZymValue nativeDir_walk(ZymVM* vm, ZymValue pathVal, ZymValue optionsVal) {
+    WalkOptions opts;
+    if (!walk_parse_options(vm, pathVal, optionsVal, &opts)) {
+        walk_options_free(&opts);
+        return ZYM_ERROR;
+    }
+
+    const char* path = zym_asCString(pathVal);
+    if (!walk_check_root(vm, path)) {
+        walk_options_free(&opts);
+        return ZYM_ERROR;
+    }
+
+    WalkEntryList entries = { NULL, 0, 0 };
+    bool ok = walk_collect(&opts, path, &entries);
+    walk_options_free(&opts);
+
+    if (!ok) {
+        walk_list_free(&entries);
+        zym_runtimeError(vm, "Out of memory while walking '%s'", path);
+        return ZYM_ERROR;
+    }
+
+    ZymValue list = zym_newList(vm);
+    zym_pushRoot(vm, list);
+
+    for (size_t i = 0; i < entries.count; i++) {
+        ZymValue info = walk_entry_to_value(vm, &entries.items[i]);
+        zym_pushRoot(vm, info);
+        zym_listAppend(vm, list, info);
+        zym_popRoot(vm);
+    }
+
+    walk_list_free(&entries);
+
+    zym_popRoot(vm);
+    return list;
+}
+
+ZymValue nativeDir_walk_1(ZymVM* vm, ZymValue pathVal) {
+    return nativeDir_walk(vm, pathVal, zym_newNull());
+}
+
+typedef struct {
+    WalkDir dir;
+    char* path;
+    int depth;
+} WalkFrame;
+
+typedef struct {
+    WalkOptions opts;
+    WalkFrame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+} WalkerData;
+
+static void walker_pop_frame(WalkerData* walker) {
+    WalkFrame* frame = &walker->frames[--walker->frame_count];
+    walk_dir_close(&frame->dir);
+    free(frame->path);
+}
+
+// Takes ownership of `path`. Unreadable directories are silently skipped;
+// returns false only on allocation failure.
+static bool walker_push_frame(WalkerData* walker, char* path, int depth) {
+    if (walker->frame_count == walker->frame_capacity) {
+        size_t new_capacity = walker->frame_capacity ? walker->frame_capacity * 2 : 16;
+        WalkFrame* new_frames = realloc(walker->frames, new_capacity * sizeof(WalkFrame));
+        if (!new_frames) {
+            free(path);
+            return false;
+        }
+        walker->frames = new_frames;
+        walker->frame_capacity = new_capacity;
+    }
+
+    WalkFrame* frame = &walker->frames[walker->frame_count];
+    WalkOpenResult opened = walk_dir_open(&frame->dir, path, &walker->opts);
+    if (opened != WALK_OPEN_OK) {
+        free(path);
+        return opened == WALK_OPEN_SKIP;
+    }
+    frame->path = path;
+    frame->depth = depth;
+    walker->frame_count++;
+    return true;
+}
+
+void walker_cleanup(ZymVM* vm, void* ptr) {
+    WalkerData* walker = (WalkerData*)ptr;
+    while (walker->frame_count > 0) {
+        walker_pop_frame(walker);
+    }
+    free(walker->frames);
+    walk_options_free(&walker->opts);
+    free(walker);
+}
+
+// Advances the depth-first walk by one reported entry. Returns false when done.
+static bool walker_advance(ZymVM* vm, WalkerData* walker, WalkEntry* out, bool* failed) {
+    *failed = false;
+
+    while (walker->frame_count > 0) {
+        WalkFrame* frame = &walker->frames[walker->frame_count - 1];
+        WalkEntryType type;
+        const char* name = walk_dir_next(&frame->dir, &walker->opts, &type);
+        if (!name) {
+            walker_pop_frame(walker);
+            continue;
+        }
+
+        int depth = frame->depth + 1;
+        size_t name_offset;
+        char* path = walk_join(frame->path, name, &name_offset);
+        if (!path) {
+            *failed = true;
+            return false;
+        }
+
+        bool report, descend;
+        walk_classify(&walker->opts, path, name_offset, type, depth, &report, &descend);
+
+        if (descend) {
+            char* dir_copy = strdup(path);
+            if (!dir_copy || !walker_push_frame(walker, dir_copy, depth)) {
+                free(path);
+                *failed = true;
+                return false;
+            }
+        }
+
+        if (report) {
+            out->path = path;
+            out->name_offset = name_offset;
+            out->type = type;
+            out->depth = depth;
+            return true;
+        }
+
+        free(path);
+    }
+
+    return false;
+}
+
+ZymValue walker_next(ZymVM* vm, ZymValue context) {
+    WalkerData* walker = (WalkerData*)zym_getNativeData(context);
+
+    WalkEntry entry;
+    bool failed;
+    if (!walker_advance(vm, walker, &entry, &failed)) {
+        if (failed) {
+            zym_runtimeError(vm, "Out of memory while walking directory");
+            return ZYM_ERROR;
+        }
+        return zym_newNull();
+    }
+
+    ZymValue info = walk_entry_to_value(vm, &entry);
+    free(entry.path);
+    return info;
+}
+
+ZymValue walker_nextBatch(ZymVM* vm, ZymValue context, ZymValue countVal) {
+    WalkerData* walker = (WalkerData*)zym_getNativeData(context);
+
+    if (!zym_isNumber(countVal)) {
+        zym_runtimeError(vm, "nextBatch() requires a number argument");
+        return ZYM_ERROR;
+    }
+
+    int count = (int)zym_asNumber(countVal);
+    ZymValue list = zym_newList(vm);
+    zym_pushRoot(vm, list);
+
+    for (int i = 0; i < count; i++) {
+        WalkEntry entry;
+        bool failed;
+        if (!walker_advance(vm, walker, &entry, &failed)) {
+            if (failed) {
+                zym_popRoot(vm);
+                zym_runtimeError(vm, "Out of memory while walking directory");
+                return ZYM_ERROR;
+            }
+            break;
+        }
+
+        ZymValue info = walk_entry_to_value(vm, &entry);
+        free(entry.path);
+        zym_pushRoot(vm, info);
+        zym_listAppend(vm, list, info);
+        zym_popRoot(vm);
+    }
+
+    zym_popRoot(vm);
+    return list;
+}
+
+ZymValue walker_close(ZymVM* vm, ZymValue context) {
+    WalkerData* walker = (WalkerData*)zym_getNativeData(context);
+    while (walker->frame_count > 0) {
+        walker_pop_frame(walker);
+    }
+    return context;
+}
+
+ZymValue nativeDir_walker(ZymVM* vm, ZymValue pathVal, ZymValue optionsVal) {
+    WalkerData* walker = calloc(1, sizeof(WalkerData));
+    if (!walker) {
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    if (!walk_parse_options(vm, pathVal, optionsVal, &walker->opts)) {
+        walk_options_free(&walker->opts);
+        free(walker);
+        return ZYM_ERROR;
+    }
+
+    const char* path = zym_asCString(pathVal);
+    if (!walk_check_root(vm, path)) {
+        walk_options_free(&walker->opts);
+        free(walker);
+        return ZYM_ERROR;
+    }
+
+    char* root = strdup(path);
+    if (!root || !walker_push_frame(walker, root, 0)) {
+        walker_cleanup(vm, walker);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    ZymValue context = zym_createNativeContext(vm, walker, walker_cleanup);
+    zym_pushRoot(vm, context);
+
+    ZymValue next = zym_createNativeClosure(vm, "next()", walker_next, context);
+    zym_pushRoot(vm, next);
+    ZymValue nextBatch = zym_createNativeClosure(vm, "nextBatch(count)", walker_nextBatch, context);
+    zym_pushRoot(vm, nextBatch);
+    ZymValue close = zym_createNativeClosure(vm, "close()", walker_close, context);
+    zym_pushRoot(vm, close);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "next", next);
+    zym_mapSet(vm, obj, "nextBatch", nextBatch);
+    zym_mapSet(vm, obj, "close", close);
+
+    // (context + 3 methods + obj = 5)
+    for (int i = 0; i < 5; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+ZymValue nativeDir_walker_1(ZymVM* vm, ZymValue pathVal) {
+    return nativeDir_walker(vm, pathVal, zym_newNull());
+}
+
 ZymValue nativePath_join(ZymVM* vm, ZymValue part1Val, ZymValue part2Val) {
     if (!zym_isString(part1Val) || !zym_isString(part2Val)) {
         zym_runtimeError(vm, "Path.join() requires two string arguments");
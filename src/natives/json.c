@@ -0,0 +1,1280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <locale.h>
+#include "./natives.h"
+#include "./buffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define JSON_HAVE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#define JSON_MAX_DEPTH 1024
+
+static inline int json_ctz64(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// ---- Stage 1: structural index -------------------------------------------------
+// The input is classified 64 bytes at a time into bitmasks of quotes and
+// structural characters ({}[]:,). A prefix-XOR over the quote mask yields the
+// "inside a string" mask, which removes structurals that appear in strings.
+// The result is the list of offsets of every structural character and every
+// unescaped quote; stage 2 walks that list instead of the raw bytes.
+
+typedef struct {
+    char* text;             // Copy of the input, padded for 64-byte blocks
+    size_t length;
+    uint32_t* index;
+    size_t index_count;
+} JsonDoc;
+
+static void json_doc_free(JsonDoc* doc) {
+    free(doc->text);
+    free(doc->index);
+    doc->text = NULL;
+    doc->index = NULL;
+}
+
+static inline uint64_t json_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// A quote is escaped when preceded by an odd run of backslashes.
+static inline bool json_quote_is_escaped(const char* text, size_t pos) {
+    size_t run = 0;
+    while (pos > run && text[pos - run - 1] == '\\') {
+        run++;
+    }
+    return (run & 1) != 0;
+}
+
+static void json_classify_block(const char* block, uint64_t* quotes, uint64_t* backslashes, uint64_t* structurals) {
+#ifdef JSON_HAVE_SSE2
+    const __m128i vquote = _mm_set1_epi8('"');
+    const __m128i vslash = _mm_set1_epi8('\\');
+    const __m128i vcolon = _mm_set1_epi8(':');
+    const __m128i vcomma = _mm_set1_epi8(',');
+    // '[' and '{' (and ']' and '}') differ only in bit 0x20, so OR-ing 0x20
+    // folds square brackets onto braces: two compares cover all four
+    const __m128i vfold = _mm_set1_epi8(0x20);
+    const __m128i vopen = _mm_set1_epi8('{');
+    const __m128i vclose = _mm_set1_epi8('}');
+
+    uint64_t q = 0, b = 0, s = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(block + i * 16));
+        __m128i folded = _mm_or_si128(chunk, vfold);
+        __m128i structural = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, vopen), _mm_cmpeq_epi8(folded, vclose)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, vcolon), _mm_cmpeq_epi8(chunk, vcomma)));
+        q |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vquote)) << (i * 16);
+        b |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vslash)) << (i * 16);
+        s |= (uint64_t)(uint16_t)_mm_movemask_epi8(structural) << (i * 16);
+    }
+    *quotes = q;
+    *backslashes = b;
+    *structurals = s;
+#else
+    uint64_t q = 0, b = 0, s = 0;
+    for (int i = 0; i < 64; i++) {
+        char c = block[i];
+        uint64_t bit = (uint64_t)1 << i;
+        if (c == '"') q |= bit;
+        else if (c == '\\') b |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') s |= bit;
+    }
+    *quotes = q;
+    *backslashes = b;
+    *structurals = s;
+#endif
+}
+
+// Takes a private, padded copy of the input and indexes it.
+static bool json_doc_build(JsonDoc* doc, const char* input, size_t length) {
+    memset(doc, 0, sizeof(JsonDoc));
+
+    if (length > UINT32_MAX - 64) {
+        return false;
+    }
+
+    size_t padded = (length + 63) & ~(size_t)63;
+    doc->text = malloc(padded + 64);
+    if (!doc->text) {
+        return false;
+    }
+    memcpy(doc->text, input, length);
+    memset(doc->text + length, ' ', padded + 64 - length);
+    doc->length = length;
+
+    // Worst case every byte is structural; start smaller and grow
+    size_t index_capacity = length / 4 + 16;
+    doc->index = malloc(index_capacity * sizeof(uint32_t));
+    if (!doc->index) {
+        json_doc_free(doc);
+        return false;
+    }
+
+    bool in_string = false;
+    bool prev_backslash = false;
+
+    for (size_t offset = 0; offset < padded; offset += 64) {
+        uint64_t quotes, backslashes, structurals;
+        json_classify_block(doc->text + offset, &quotes, &backslashes, &structurals);
+
+        // Rare path: backslashes in (or leading into) this block may escape quotes
+        if ((backslashes || prev_backslash) && quotes) {
+            uint64_t remaining = quotes;
+            while (remaining) {
+                int bit = json_ctz64(remaining);
+                remaining &= remaining - 1;
+                if (json_quote_is_escaped(doc->text, offset + bit)) {
+                    quotes &= ~((uint64_t)1 << bit);
+                }
+            }
+        }
+        prev_backslash = (backslashes >> 63) & 1;
+
+        uint64_t inside = json_prefix_xor(quotes);
+        if (in_string) {
+            inside = ~inside;
+        }
+        in_string = (inside >> 63) & 1;
+
+        uint64_t tokens = (structurals & ~inside) | quotes;
+
+        size_t needed = doc->index_count + (size_t)64;
+        if (needed > index_capacity) {
+            while (index_capacity < needed) index_capacity *= 2;
+            uint32_t* new_index = realloc(doc->index, index_capacity * sizeof(uint32_t));
+            if (!new_index) {
+                json_doc_free(doc);
+                return false;
+            }
+            doc->index = new_index;
+        }
+
+        while (tokens) {
+            int bit = json_ctz64(tokens);
+            tokens &= tokens - 1;
+            doc->index[doc->index_count++] = (uint32_t)(offset + bit);
+        }
+    }
+
+    return true;
+}
+
+// ---- Stage 2: building values -----------------------------------------------------
+
+typedef struct {
+    ZymVM* vm;
+    JsonDoc* doc;
+    size_t token;           // Next index entry
+    size_t cursor;          // Byte offset just past the last consumed token
+    const char* error;
+    size_t error_offset;
+    char* scratch;
+    size_t scratch_capacity;
+} JsonParser;
+
+static bool json_fail(JsonParser* parser, const char* message, size_t offset) {
+    if (!parser->error) {
+        parser->error = message;
+        parser->error_offset = offset;
+    }
+    return false;
+}
+
+static inline bool json_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline size_t json_skip_space(const JsonDoc* doc, size_t pos) {
+    while (pos < doc->length && json_is_space(doc->text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+static inline size_t json_token_pos(const JsonParser* parser) {
+    return parser->token < parser->doc->index_count ? parser->doc->index[parser->token] : parser->doc->length;
+}
+
+static bool json_scratch_reserve(JsonParser* parser, size_t size) {
+    if (size <= parser->scratch_capacity) {
+        return true;
+    }
+    size_t new_capacity = parser->scratch_capacity ? parser->scratch_capacity : 256;
+    while (new_capacity < size) new_capacity *= 2;
+    char* new_scratch = realloc(parser->scratch, new_capacity);
+    if (!new_scratch) {
+        return false;
+    }
+    parser->scratch = new_scratch;
+    parser->scratch_capacity = new_capacity;
+    return true;
+}
+
+static int json_hex4(const char* p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+static char* json_put_utf8(char* out, uint32_t cp) {
+    if (cp < 0x80) {
+        *out++ = (char)cp;
+    } else if (cp < 0x800) {
+        *out++ = (char)(0xC0 | (cp >> 6));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *out++ = (char)(0xE0 | (cp >> 12));
+        *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (cp >> 18));
+        *out++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+// Returns the offset of the first byte needing an escape (quote, backslash,
+// control character), or len. Inside a parsed string the first hit is a
+// backslash or a raw control character, since quotes only appear escaped.
+static size_t json_scan_escape(const char* s, size_t len) {
+    size_t i = 0;
+#ifdef JSON_HAVE_SSE2
+    const __m128i vquote = _mm_set1_epi8('"');
+    const __m128i vslash = _mm_set1_epi8('\\');
+    const __m128i vctrl = _mm_set1_epi8(0x1F);
+    while (len - i >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(s + i));
+        // Unsigned c <= 0x1F  <=>  max(c, 0x1F) == 0x1F
+        __m128i ctrl = _mm_cmpeq_epi8(_mm_max_epu8(chunk, vctrl), vctrl);
+        __m128i hits = _mm_or_si128(ctrl, _mm_or_si128(_mm_cmpeq_epi8(chunk, vquote), _mm_cmpeq_epi8(chunk, vslash)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+        if (mask) {
+            return i + (size_t)json_ctz64(mask);
+        }
+        i += 16;
+    }
+#endif
+    while (i < len) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\' || c < 0x20) return i;
+        i++;
+    }
+    return len;
+}
+
+// Decodes the string whose opening quote is the current token into the
+// scratch buffer (NUL-terminated). Escapes never grow the output, so the raw
+// length is always enough. Raw control characters are rejected, as is
+// \u0000: strings are NUL-terminated, so it would silently cut them short.
+static const char* json_read_string(JsonParser* parser) {
+    const JsonDoc* doc = parser->doc;
+    size_t open = doc->index[parser->token];
+    if (parser->token + 1 >= doc->index_count || doc->text[doc->index[parser->token + 1]] != '"') {
+        json_fail(parser, "Unterminated string", open);
+        return NULL;
+    }
+    size_t close = doc->index[parser->token + 1];
+    parser->token += 2;
+    parser->cursor = close + 1;
+
+    const char* src = doc->text + open + 1;
+    size_t len = close - open - 1;
+    if (!json_scratch_reserve(parser, len + 1)) {
+        json_fail(parser, "Out of memory", open);
+        return NULL;
+    }
+
+    char* out = parser->scratch;
+    const char* p = src;
+    const char* end = src + len;
+
+    while (p < end) {
+        if (*p != '\\') {
+            size_t run = json_scan_escape(p, (size_t)(end - p));
+            memcpy(out, p, run);
+            out += run;
+            p += run;
+            if (p < end && *p != '\\') {
+                json_fail(parser, "Unescaped control character in string", (size_t)(p - doc->text));
+                return NULL;
+            }
+            continue;
+        }
+        if (p + 1 >= end) {
+            json_fail(parser, "Invalid escape sequence", (size_t)(p - doc->text));
+            return NULL;
+        }
+        char e = p[1];
+        p += 2;
+        switch (e) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                int cp = end - p >= 4 ? json_hex4(p) : -1;
+                if (cp < 0) {
+                    json_fail(parser, "Invalid \\u escape", (size_t)(p - doc->text));
+                    return NULL;
+                }
+                if (cp == 0) {
+                    json_fail(parser, "\\u0000 is not supported in strings", (size_t)(p - 2 - doc->text));
+                    return NULL;
+                }
+                p += 4;
+                uint32_t code = (uint32_t)cp;
+                if (code >= 0xD800 && code <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    int low = json_hex4(p + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                out = json_put_utf8(out, code);
+                break;
+            }
+            default:
+                json_fail(parser, "Invalid escape sequence", (size_t)(p - 2 - doc->text));
+                return NULL;
+        }
+    }
+
+    *out = '\0';
+    return parser->scratch;
+}
+
+// Console() calls setlocale(LC_ALL, ""), after which strtod() and printf()
+// use the user's decimal separator. JSON always uses '.', so numbers are
+// translated to and from the locale's form around those calls.
+static const char* json_decimal_point(void) {
+    const char* point = localeconv()->decimal_point;
+    return point && point[0] ? point : ".";
+}
+
+// Converts a validated JSON number of len bytes. Returns false when out of
+// memory.
+static bool json_strtod(const char* text, size_t len, double* out) {
+    const char* point = json_decimal_point();
+    if (strcmp(point, ".") == 0) {
+        // The padded copy is followed by whitespace/structural, so strtod stops in place
+        *out = strtod(text, NULL);
+        return true;
+    }
+
+    // Otherwise a following ',' could be read as part of the number, so it
+    // is converted from a terminated copy
+    size_t point_len = strlen(point);
+    char local[64];
+    char* copy = len + point_len < sizeof(local) ? local : malloc(len + point_len + 1);
+    if (!copy) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '.') {
+            memcpy(copy + n, point, point_len);
+            n += point_len;
+        } else {
+            copy[n++] = text[i];
+        }
+    }
+    copy[n] = '\0';
+    *out = strtod(copy, NULL);
+    if (copy != local) {
+        free(copy);
+    }
+    return true;
+}
+
+// Shared with CSV: reads a number written with '.' whatever the locale.
+// False unless all len bytes form one finite-or-not number, or when out of
+// memory.
+bool json_parse_double(const char* text, size_t len, double* out) {
+    const char* point = json_decimal_point();
+    size_t point_len = strlen(point);
+    if (strcmp(point, ".") != 0 && memchr(text, point[0], len)) {
+        return false;  // "1,5" is not a number just because the locale says so
+    }
+    char local[64];
+    char* copy = len * point_len < sizeof(local) ? local : malloc(len * point_len + 1);
+    if (!copy) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '.') {
+            memcpy(copy + n, point, point_len);
+            n += point_len;
+        } else {
+            copy[n++] = text[i];
+        }
+    }
+    copy[n] = '\0';
+    char* end = NULL;
+    *out = strtod(copy, &end);
+    bool whole = n > 0 && end == copy + n;
+    if (copy != local) {
+        free(copy);
+    }
+    return whole;
+}
+
+// Shared with CSV: snprintf("%.*g") with '.' as the decimal point whatever
+// the locale. Returns the length written.
+int json_format_double(char* out, size_t size, int precision, double number) {
+    int n = snprintf(out, size, "%.*g", precision, number);
+    if (n < 0 || (size_t)n >= size) {
+        return n;
+    }
+    const char* point = json_decimal_point();
+    char* at = strcmp(point, ".") != 0 ? strstr(out, point) : NULL;
+    if (at) {
+        size_t point_len = strlen(point);
+        *at = '.';
+        memmove(at + 1, at + point_len, (size_t)(out + n - (at + point_len)) + 1);
+        n -= (int)(point_len - 1);
+    }
+    return n;
+}
+
+// Parses a number/true/false/null that sits between two tokens.
+static bool json_read_scalar(JsonParser* parser, size_t start, ZymValue* out) {
+    const JsonDoc* doc = parser->doc;
+    size_t limit = json_token_pos(parser);
+    size_t end = start;
+    while (end < limit && !json_is_space(doc->text[end])) {
+        end++;
+    }
+    if (json_skip_space(doc, end) != limit) {
+        return json_fail(parser, "Unexpected character", end);
+    }
+    parser->cursor = end;
+
+    const char* p = doc->text + start;
+    size_t len = end - start;
+
+    if (len == 4 && memcmp(p, "true", 4) == 0) { *out = zym_newBool(true); return true; }
+    if (len == 5 && memcmp(p, "false", 5) == 0) { *out = zym_newBool(false); return true; }
+    if (len == 4 && memcmp(p, "null", 4) == 0) { *out = zym_newNull(); return true; }
+
+    if (len == 0 || !(p[0] == '-' || (p[0] >= '0' && p[0] <= '9'))) {
+        return json_fail(parser, len == 0 ? "Expected a value" : "Unexpected literal", start);
+    }
+
+    // Fast path: plain integers that fit a double exactly
+    size_t i = p[0] == '-' ? 1 : 0;
+    if (len - i > 0 && len - i <= 15) {
+        int64_t value = 0;
+        size_t j = i;
+        while (j < len && p[j] >= '0' && p[j] <= '9') {
+            value = value * 10 + (p[j] - '0');
+            j++;
+        }
+        if (j == len) {
+            if (len - i > 1 && p[i] == '0') {
+                return json_fail(parser, "Leading zeros are not allowed", start);
+            }
+            *out = zym_newNumber((double)(i ? -value : value));
+            return true;
+        }
+    }
+
+    // Validate the JSON number grammar, then let strtod do the conversion
+    size_t j = i;
+    if (j < len && p[j] == '0') {
+        j++;
+    } else {
+        if (j >= len || p[j] < '1' || p[j] > '9') return json_fail(parser, "Invalid number", start);
+        while (j < len && p[j] >= '0' && p[j] <= '9') j++;
+    }
+    if (j < len && p[j] == '.') {
+        j++;
+        if (j >= len || p[j] < '0' || p[j] > '9') return json_fail(parser, "Invalid number", start);
+        while (j < len && p[j] >= '0' && p[j] <= '9') j++;
+    }
+    if (j < len && (p[j] == 'e' || p[j] == 'E')) {
+        j++;
+        if (j < len && (p[j] == '+' || p[j] == '-')) j++;
+        if (j >= len || p[j] < '0' || p[j] > '9') return json_fail(parser, "Invalid number", start);
+        while (j < len && p[j] >= '0' && p[j] <= '9') j++;
+    }
+    if (j != len) {
+        return json_fail(parser, "Invalid number", start);
+    }
+
+    double number;
+    if (!json_strtod(p, len, &number)) {
+        return json_fail(parser, "Out of memory", start);
+    }
+    *out = zym_newNumber(number);
+    return true;
+}
+
+static inline char json_token_char(const JsonParser* parser) {
+    return parser->token < parser->doc->index_count ? parser->doc->text[parser->doc->index[parser->token]] : '\0';
+}
+
+// Expects the current token to be `c` with only whitespace before it.
+static bool json_expect(JsonParser* parser, char c) {
+    size_t pos = json_token_pos(parser);
+    if (json_token_char(parser) != c || json_skip_space(parser->doc, parser->cursor) != pos) {
+        return json_fail(parser, c == ':' ? "Expected ':'" : "Unexpected token", json_skip_space(parser->doc, parser->cursor));
+    }
+    parser->token++;
+    parser->cursor = pos + 1;
+    return true;
+}
+
+static bool json_parse_value(JsonParser* parser, int depth, ZymValue* out);
+
+static bool json_parse_array(JsonParser* parser, int depth, ZymValue* out) {
+    ZymVM* vm = parser->vm;
+    ZymValue list = zym_newList(vm);
+    zym_pushRoot(vm, list);
+
+    size_t next = json_skip_space(parser->doc, parser->cursor);
+    if (json_token_char(parser) == ']' && json_token_pos(parser) == next) {
+        parser->token++;
+        parser->cursor = next + 1;
+        zym_popRoot(vm);
+        *out = list;
+        return true;
+    }
+
+    for (;;) {
+        ZymValue item;
+        if (!json_parse_value(parser, depth + 1, &item)) {
+            zym_popRoot(vm);
+            return false;
+        }
+        zym_pushRoot(vm, item);
+        zym_listAppend(vm, list, item);
+        zym_popRoot(vm);
+
+        char c = json_token_char(parser);
+        if (c == ',' && json_expect(parser, ',')) continue;
+        if (c == ']' && json_expect(parser, ']')) break;
+        zym_popRoot(vm);
+        return json_fail(parser, "Expected ',' or ']'", json_skip_space(parser->doc, parser->cursor));
+    }
+
+    zym_popRoot(vm);
+    *out = list;
+    return true;
+}
+
+static bool json_parse_object(JsonParser* parser, int depth, ZymValue* out) {
+    ZymVM* vm = parser->vm;
+    ZymValue map = zym_newMap(vm);
+    zym_pushRoot(vm, map);
+
+    size_t next = json_skip_space(parser->doc, parser->cursor);
+    if (json_token_char(parser) == '}' && json_token_pos(parser) == next) {
+        parser->token++;
+        parser->cursor = next + 1;
+        zym_popRoot(vm);
+        *out = map;
+        return true;
+    }
+
+    char* key = NULL;
+    for (;;) {
+        if (json_token_char(parser) != '"' || json_token_pos(parser) != json_skip_space(parser->doc, parser->cursor)) {
+            free(key);
+            zym_popRoot(vm);
+            return json_fail(parser, "Expected a string key", json_skip_space(parser->doc, parser->cursor));
+        }
+
+        // The scratch buffer is reused by the value, so the key needs its own copy
+        const char* scratch_key = json_read_string(parser);
+        if (!scratch_key) {
+            free(key);
+            zym_popRoot(vm);
+            return false;
+        }
+        free(key);
+        key = strdup(scratch_key);
+
+        ZymValue value;
+        if (!key || !json_expect(parser, ':') || !json_parse_value(parser, depth + 1, &value)) {
+            free(key);
+            zym_popRoot(vm);
+            return key ? false : json_fail(parser, "Out of memory", parser->cursor);
+        }
+        zym_pushRoot(vm, value);
+        zym_mapSet(vm, map, key, value);
+        zym_popRoot(vm);
+
+        char c = json_token_char(parser);
+        if (c == ',' && json_expect(parser, ',')) continue;
+        if (c == '}' && json_expect(parser, '}')) break;
+        free(key);
+        zym_popRoot(vm);
+        return json_fail(parser, "Expected ',' or '}'", json_skip_space(parser->doc, parser->cursor));
+    }
+
+    free(key);
+    zym_popRoot(vm);
+    *out = map;
+    return true;
+}
+
+static bool json_parse_value(JsonParser* parser, int depth, ZymValue* out) {
+    if (depth > JSON_MAX_DEPTH) {
+        return json_fail(parser, "Nesting too deep", parser->cursor);
+    }
+
+    size_t start = json_skip_space(parser->doc, parser->cursor);
+    if (start != json_token_pos(parser)) {
+        return json_read_scalar(parser, start, out);
+    }
+
+    switch (json_token_char(parser)) {
+        case '{':
+            parser->token++;
+            parser->cursor = start + 1;
+            return json_parse_object(parser, depth, out);
+        case '[':
+            parser->token++;
+            parser->cursor = start + 1;
+            return json_parse_array(parser, depth, out);
+        case '"': {
+            const char* text = json_read_string(parser);
+            if (!text) return false;
+            *out = zym_newString(parser->vm, text);
+            return true;
+        }
+        default:
+            return json_fail(parser, start >= parser->doc->length ? "Unexpected end of input" : "Unexpected token", start);
+    }
+}
+
+// Accepts a string or a Buffer (from its position to its length).
+static bool json_source_bytes(ZymVM* vm, ZymValue sourceVal, const char* fn, const char** bytes, size_t* length) {
+    if (zym_isString(sourceVal)) {
+        *bytes = zym_asCString(sourceVal);
+        *length = strlen(*bytes);
+        return true;
+    }
+
+    BufferData* buf = buffer_from_value(vm, sourceVal);
+    if (buf) {
+        if (!buffer_check_readable(vm, buf)) {
+            return false;
+        }
+        *bytes = (const char*)buf->data + buf->position;
+        *length = buf->position < buf->length ? buf->length - buf->position : 0;
+        return true;
+    }
+
+    zym_runtimeError(vm, "%s requires a string or a Buffer", fn);
+    return false;
+}
+
+static void json_report(ZymVM* vm, const char* fn, JsonParser* parser) {
+    zym_runtimeError(vm, "%s: %s at offset %zu", fn, parser->error ? parser->error : "Invalid JSON", parser->error_offset);
+}
+
+ZymValue nativeJson_parse(ZymVM* vm, ZymValue sourceVal) {
+    const char* bytes;
+    size_t length;
+    if (!json_source_bytes(vm, sourceVal, "jsonParse()", &bytes, &length)) {
+        return ZYM_ERROR;
+    }
+
+    JsonDoc doc;
+    if (!json_doc_build(&doc, bytes, length)) {
+        zym_runtimeError(vm, "jsonParse(): Out of memory");
+        return ZYM_ERROR;
+    }
+
+    JsonParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.vm = vm;
+    parser.doc = &doc;
+
+    ZymValue result;
+    bool ok = json_parse_value(&parser, 0, &result);
+    if (ok && (parser.token != doc.index_count || json_skip_space(&doc, parser.cursor) != doc.length)) {
+        ok = json_fail(&parser, "Unexpected data after JSON value", json_skip_space(&doc, parser.cursor));
+    }
+
+    if (!ok) {
+        json_report(vm, "jsonParse()", &parser);
+    }
+
+    free(parser.scratch);
+    json_doc_free(&doc);
+    return ok ? result : ZYM_ERROR;
+}
+
+// ---- Lazy documents -----------------------------------------------------------------
+// JsonDocument keeps the structural index and materialises only the values a
+// path query lands on. Unwanted subtrees are skipped by walking the index and
+// counting brackets, without decoding strings or numbers.
+
+// Advances past one value starting at the current token/cursor.
+static bool json_skip_value(JsonParser* parser) {
+    size_t start = json_skip_space(parser->doc, parser->cursor);
+    if (start != json_token_pos(parser)) {
+        // Scalar: ends at the next token
+        ZymValue ignored;
+        return json_read_scalar(parser, start, &ignored);
+    }
+
+    char c = json_token_char(parser);
+    if (c == '"') {
+        if (parser->token + 1 >= parser->doc->index_count) {
+            return json_fail(parser, "Unterminated string", start);
+        }
+        parser->cursor = parser->doc->index[parser->token + 1] + 1;
+        parser->token += 2;
+        return true;
+    }
+    if (c != '{' && c != '[') {
+        return json_fail(parser, "Unexpected token", start);
+    }
+
+    int depth = 0;
+    while (parser->token < parser->doc->index_count) {
+        char t = json_token_char(parser);
+        if (t == '"') {
+            parser->token += 2;
+            continue;
+        }
+        if (t == '{' || t == '[') depth++;
+        else if (t == '}' || t == ']') depth--;
+        parser->cursor = parser->doc->index[parser->token] + 1;
+        parser->token++;
+        if (depth == 0) {
+            return true;
+        }
+    }
+    return json_fail(parser, "Unexpected end of input", parser->doc->length);
+}
+
+typedef struct {
+    bool is_index;
+    long index;
+    char* key;
+} JsonPathStep;
+
+static void json_path_free(JsonPathStep* steps, int count) {
+    for (int i = 0; i < count; i++) {
+        free(steps[i].key);
+    }
+    free(steps);
+}
+
+// Accepts "a.b[2].c" or a list of keys/indices.
+static bool json_path_parse(ZymVM* vm, ZymValue pathVal, JsonPathStep** out_steps, int* out_count) {
+    *out_steps = NULL;
+    *out_count = 0;
+
+    if (zym_isList(pathVal)) {
+        int count = zym_listLength(pathVal);
+        JsonPathStep* steps = calloc(count > 0 ? count : 1, sizeof(JsonPathStep));
+        if (!steps) {
+            zym_runtimeError(vm, "Out of memory");
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            ZymValue part = zym_listGet(vm, pathVal, i);
+            if (zym_isNumber(part)) {
+                steps[i].is_index = true;
+                steps[i].index = (long)zym_asNumber(part);
+            } else if (zym_isString(part)) {
+                steps[i].key = strdup(zym_asCString(part));
+            } else {
+                json_path_free(steps, count);
+                zym_runtimeError(vm, "JSON path segments must be strings or numbers");
+                return false;
+            }
+        }
+        *out_steps = steps;
+        *out_count = count;
+        return true;
+    }
+
+    if (!zym_isString(pathVal)) {
+        zym_runtimeError(vm, "JSON path must be a string or a list");
+        return false;
+    }
+
+    const char* p = zym_asCString(pathVal);
+    size_t max_steps = 1;
+    for (const char* q = p; *q; q++) {
+        if (*q == '.' || *q == '[') max_steps++;
+    }
+    JsonPathStep* steps = calloc(max_steps, sizeof(JsonPathStep));
+    if (!steps) {
+        zym_runtimeError(vm, "Out of memory");
+        return false;
+    }
+
+    int count = 0;
+    while (*p) {
+        if (*p == '.') {
+            p++;
+            continue;
+        }
+        if (*p == '[') {
+            char* end;
+            long index = strtol(p + 1, &end, 10);
+            if (end == p + 1 || *end != ']') {
+                json_path_free(steps, count);
+                zym_runtimeError(vm, "Invalid JSON path near '%s'", p);
+                return false;
+            }
+            steps[count].is_index = true;
+            steps[count].index = index;
+            count++;
+            p = end + 1;
+            continue;
+        }
+        const char* start = p;
+        while (*p && *p != '.' && *p != '[') p++;
+        steps[count].key = malloc((size_t)(p - start) + 1);
+        if (!steps[count].key) {
+            json_path_free(steps, count);
+            zym_runtimeError(vm, "Out of memory");
+            return false;
+        }
+        memcpy(steps[count].key, start, (size_t)(p - start));
+        steps[count].key[p - start] = '\0';
+        count++;
+    }
+
+    *out_steps = steps;
+    *out_count = count;
+    return true;
+}
+
+// Positions the parser on the value addressed by `steps`. Returns false with
+// no error set when the path does not exist.
+static bool json_seek_path(JsonParser* parser, const JsonPathStep* steps, int count) {
+    for (int s = 0; s < count; s++) {
+        size_t start = json_skip_space(parser->doc, parser->cursor);
+        if (start != json_token_pos(parser)) {
+            return false;
+        }
+        char c = json_token_char(parser);
+
+        if (steps[s].is_index) {
+            if (c != '[') return false;
+            parser->token++;
+            parser->cursor = start + 1;
+
+            size_t next = json_skip_space(parser->doc, parser->cursor);
+            if (json_token_char(parser) == ']' && json_token_pos(parser) == next) return false;
+
+            for (long i = 0; i < steps[s].index; i++) {
+                if (!json_skip_value(parser)) return false;
+                if (json_token_char(parser) != ',') return false;
+                parser->cursor = json_token_pos(parser) + 1;
+                parser->token++;
+            }
+            if (steps[s].index < 0) return false;
+            continue;
+        }
+
+        if (c != '{') return false;
+        parser->token++;
+        parser->cursor = start + 1;
+
+        bool found = false;
+        for (;;) {
+            if (json_token_char(parser) != '"') return false;
+            const char* key = json_read_string(parser);
+            if (!key) return false;
+            bool match = strcmp(key, steps[s].key) == 0;
+            if (!json_expect(parser, ':')) return false;
+            if (match) {
+                found = true;
+                break;
+            }
+            if (!json_skip_value(parser)) return false;
+            if (json_token_char(parser) != ',') return false;
+            parser->cursor = json_token_pos(parser) + 1;
+            parser->token++;
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    JsonDoc doc;
+} JsonDocumentData;
+
+void json_document_cleanup(ZymVM* vm, void* ptr) {
+    JsonDocumentData* data = (JsonDocumentData*)ptr;
+    json_doc_free(&data->doc);
+    free(data);
+}
+
+static ZymValue json_document_lookup(ZymVM* vm, ZymValue context, ZymValue pathVal, bool materialise) {
+    JsonDocumentData* data = (JsonDocumentData*)zym_getNativeData(context);
+
+    JsonPathStep* steps;
+    int count;
+    if (!json_path_parse(vm, pathVal, &steps, &count)) {
+        return ZYM_ERROR;
+    }
+
+    JsonParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.vm = vm;
+    parser.doc = &data->doc;
+
+    ZymValue result = materialise ? zym_newNull() : zym_newBool(false);
+    if (json_seek_path(&parser, steps, count)) {
+        if (!materialise) {
+            result = zym_newBool(true);
+        } else if (!json_parse_value(&parser, 0, &result)) {
+            json_report(vm, "JsonDocument.get()", &parser);
+            result = ZYM_ERROR;
+        }
+    }
+
+    free(parser.scratch);
+    json_path_free(steps, count);
+    return result;
+}
+
+ZymValue json_document_get(ZymVM* vm, ZymValue context, ZymValue pathVal) {
+    return json_document_lookup(vm, context, pathVal, true);
+}
+
+ZymValue json_document_has(ZymVM* vm, ZymValue context, ZymValue pathVal) {
+    return json_document_lookup(vm, context, pathVal, false);
+}
+
+ZymValue json_document_getMany(ZymVM* vm, ZymValue context, ZymValue pathsVal) {
+    if (!zym_isList(pathsVal)) {
+        zym_runtimeError(vm, "getMany() requires a list of paths");
+        return ZYM_ERROR;
+    }
+
+    ZymValue results = zym_newList(vm);
+    zym_pushRoot(vm, results);
+
+    int count = zym_listLength(pathsVal);
+    for (int i = 0; i < count; i++) {
+        ZymValue value = json_document_lookup(vm, context, zym_listGet(vm, pathsVal, i), true);
+        if (value == ZYM_ERROR) {
+            zym_popRoot(vm);
+            return ZYM_ERROR;
+        }
+        zym_pushRoot(vm, value);
+        zym_listAppend(vm, results, value);
+        zym_popRoot(vm);
+    }
+
+    zym_popRoot(vm);
+    return results;
+}
+
+ZymValue nativeJson_document(ZymVM* vm, ZymValue sourceVal) {
+    const char* bytes;
+    size_t length;
+    if (!json_source_bytes(vm, sourceVal, "JsonDocument()", &bytes, &length)) {
+        return ZYM_ERROR;
+    }
+
+    JsonDocumentData* data = calloc(1, sizeof(JsonDocumentData));
+    if (!data || !json_doc_build(&data->doc, bytes, length)) {
+        free(data);
+        zym_runtimeError(vm, "JsonDocument(): Out of memory");
+        return ZYM_ERROR;
+    }
+
+    ZymValue context = zym_createNativeContext(vm, data, json_document_cleanup);
+    zym_pushRoot(vm, context);
+
+    ZymValue get = zym_createNativeClosure(vm, "get(path)", json_document_get, context);
+    zym_pushRoot(vm, get);
+    ZymValue has = zym_createNativeClosure(vm, "has(path)", json_document_has, context);
+    zym_pushRoot(vm, has);
+    ZymValue getMany = zym_createNativeClosure(vm, "getMany(paths)", json_document_getMany, context);
+    zym_pushRoot(vm, getMany);
+
+    ZymValue obj = zym_newMap(vm);
+    zym_pushRoot(vm, obj);
+
+    zym_mapSet(vm, obj, "get", get);
+    zym_mapSet(vm, obj, "has", has);
+    zym_mapSet(vm, obj, "getMany", getMany);
+
+    // (context + 3 methods + obj = 5)
+    for (int i = 0; i < 5; i++) {
+        zym_popRoot(vm);
+    }
+
+    return obj;
+}
+
+// ---- Stringify ------------------------------------------------------------------------
+
+typedef struct {
+    ZymVM* vm;
+    char* data;
+    size_t length;
+    size_t capacity;
+    int indent;
+    bool failed;
+} JsonWriter;
+
+static bool json_out_reserve(JsonWriter* w, size_t extra) {
+    if (w->length + extra <= w->capacity) {
+        return true;
+    }
+    size_t new_capacity = w->capacity ? w->capacity * 2 : 1024;
+    while (new_capacity < w->length + extra) new_capacity *= 2;
+    char* new_data = realloc(w->data, new_capacity);
+    if (!new_data) {
+        if (!w->failed) zym_runtimeError(w->vm, "jsonStringify(): Out of memory");
+        w->failed = true;
+        return false;
+    }
+    w->data = new_data;
+    w->capacity = new_capacity;
+    return true;
+}
+
+static inline void json_out_append(JsonWriter* w, const char* bytes, size_t len) {
+    if (!json_out_reserve(w, len)) return;
+    memcpy(w->data + w->length, bytes, len);
+    w->length += len;
+}
+
+static inline void json_out_char(JsonWriter* w, char c) {
+    if (!json_out_reserve(w, 1)) return;
+    w->data[w->length++] = c;
+}
+
+static void json_out_newline(JsonWriter* w, int depth) {
+    if (w->indent <= 0) return;
+    size_t n = (size_t)w->indent * (size_t)depth;
+    if (!json_out_reserve(w, n + 1)) return;
+    w->data[w->length++] = '\n';
+    memset(w->data + w->length, ' ', n);
+    w->length += n;
+}
+
+static void json_write_string(JsonWriter* w, const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    size_t len = strlen(s);
+
+    json_out_char(w, '"');
+    size_t i = 0;
+    while (i < len) {
+        size_t clean = json_scan_escape(s + i, len - i);
+        json_out_append(w, s + i, clean);
+        i += clean;
+        if (i >= len) break;
+
+        unsigned char c = (unsigned char)s[i++];
+        switch (c) {
+            case '"': json_out_append(w, "\\\"", 2); break;
+            case '\\': json_out_append(w, "\\\\", 2); break;
+            case '\n': json_out_append(w, "\\n", 2); break;
+            case '\r': json_out_append(w, "\\r", 2); break;
+            case '\t': json_out_append(w, "\\t", 2); break;
+            case '\b': json_out_append(w, "\\b", 2); break;
+            case '\f': json_out_append(w, "\\f", 2); break;
+            default: {
+                char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                json_out_append(w, esc, 6);
+            }
+        }
+    }
+    json_out_char(w, '"');
+}
+
+// Integers are emitted digit by digit; everything else uses the shortest
+// of %.15g/%.16g/%.17g that round-trips.
+static void json_write_number(JsonWriter* w, double number) {
+    if (!isfinite(number)) {
+        json_out_append(w, "null", 4);
+        return;
+    }
+
+    char scratch[32];
+    if (fabs(number) < 9007199254740992.0 && number == (double)(int64_t)number) {
+        int64_t value = (int64_t)number;
+        uint64_t magnitude = value < 0 ? (uint64_t)(-value) : (uint64_t)value;
+        char* end = scratch + sizeof(scratch);
+        char* p = end;
+        do {
+            *--p = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0 || (value == 0 && signbit(number))) *--p = '-';
+        json_out_append(w, p, (size_t)(end - p));
+        return;
+    }
+
+    // The shortest of %.15g..%.17g that reads back as the same double
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        n = json_format_double(scratch, sizeof(scratch), precision, number);
+        double back;
+        if (json_parse_double(scratch, (size_t)n, &back) && back == number) break;
+    }
+    json_out_append(w, scratch, (size_t)n);
+}
+
+static void json_write_value(JsonWriter* w, ZymValue value, int depth);
+
+typedef struct {
+    JsonWriter* writer;
+    int depth;
+    bool first;
+} JsonMapWriteContext;
+
+static bool json_write_map_entry(ZymVM* vm, const char* key, ZymValue value, void* userdata) {
+    JsonMapWriteContext* ctx = (JsonMapWriteContext*)userdata;
+    JsonWriter* w = ctx->writer;
+
+    if (!ctx->first) json_out_char(w, ',');
+    ctx->first = false;
+    json_out_newline(w, ctx->depth + 1);
+    json_write_string(w, key);
+    json_out_char(w, ':');
+    if (w->indent > 0) json_out_char(w, ' ');
+    json_write_value(w, value, ctx->depth + 1);
+
+    return !w->failed;
+}
+
+static void json_write_value(JsonWriter* w, ZymValue value, int depth) {
+    if (w->failed) return;
+
+    if (depth > JSON_MAX_DEPTH) {
+        zym_runtimeError(w->vm, "jsonStringify(): nesting too deep (cyclic value?)");
+        w->failed = true;
+        return;
+    }
+
+    if (zym_isNull(value)) {
+        json_out_append(w, "null", 4);
+    } else if (zym_isBool(value)) {
+        if (zym_asBool(value)) json_out_append(w, "true", 4);
+        else json_out_append(w, "false", 5);
+    } else if (zym_isNumber(value)) {
+        json_write_number(w, zym_asNumber(value));
+    } else if (zym_isString(value)) {
+        json_write_string(w, zym_asCString(value));
+    } else if (zym_isList(value)) {
+        int count = zym_listLength(value);
+        json_out_char(w, '[');
+        for (int i = 0; i < count && !w->failed; i++) {
+            if (i > 0) json_out_char(w, ',');
+            json_out_newline(w, depth + 1);
+            json_write_value(w, zym_listGet(w->vm, value, i), depth + 1);
+        }
+        if (count > 0) json_out_newline(w, depth);
+        json_out_char(w, ']');
+    } else if (zym_isMap(value)) {
+        JsonMapWriteContext ctx = { w, depth, true };
+        json_out_char(w, '{');
+        zym_mapForEach(w->vm, value, json_write_map_entry, &ctx);
+        if (!ctx.first) json_out_newline(w, depth);
+        json_out_char(w, '}');
+    } else {
+        zym_runtimeError(w->vm, "jsonStringify(): cannot serialize value of type %s", zym_typeName(value));
+        w->failed = true;
+    }
+}
+
+ZymValue nativeJson_stringify(ZymVM* vm, ZymValue value, ZymValue optionsVal) {
+    JsonWriter w;
+    memset(&w, 0, sizeof(w));
+    w.vm = vm;
+
+    ZymValue targetVal = zym_newNull();
+    if (zym_isMap(optionsVal)) {
+        ZymValue indentVal = zym_mapGet(vm, optionsVal, "indent");
+        if (zym_isNumber(indentVal)) {
+            w.indent = (int)zym_asNumber(indentVal);
+            if (w.indent > 16) w.indent = 16;
+        }
+        targetVal = zym_mapGet(vm, optionsVal, "buffer");
+    } else if (!zym_isNull(optionsVal)) {
+        zym_runtimeError(vm, "jsonStringify() options must be a map");
+        return ZYM_ERROR;
+    }
+
+    json_write_value(&w, value, 0);
+    if (w.failed) {
+        free(w.data);
+        return ZYM_ERROR;
+    }
+
+    // With a target Buffer the output is appended at its position, growing it
+    if (!zym_isNull(targetVal)) {
+        BufferData* buf = buffer_from_value(vm, targetVal);
+        if (!buf) {
+            free(w.data);
+            zym_runtimeError(vm, "jsonStringify() option 'buffer' must be a Buffer");
+            return ZYM_ERROR;
+        }
+
+        bool written = buffer_write_bytes(vm, buf, w.data, w.length);
+        free(w.data);
+        return written ? targetVal : ZYM_ERROR;
+    }
+
+    json_out_char(&w, '\0');
+    if (w.failed) {
+        free(w.data);
+        return ZYM_ERROR;
+    }
+
+    ZymValue result = zym_newString(vm, w.data);
+    free(w.data);
+    return result;
+}
+
+ZymValue nativeJson_stringify_1(ZymVM* vm, ZymValue value) {
+    return nativeJson_stringify(vm, value, zym_newNull());
+}
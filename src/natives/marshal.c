@@ -5,145 +5,877 @@
 #include <stdbool.h>
 #include "./marshal.h"
 #include "./natives.h"
+#include "./buffer.h"
+#include "./channel.h"
+
+// Copies through the packed form, so shared and cyclic values come out with
+// the same shape they went in with.
+ZymValue marshal_reconstruct_value(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue value) {
+    if (zym_isNull(value) || zym_isBool(value) || zym_isNumber(value)) {
+        return value;
+    }
+
+    MarshalBlob blob = {0};
+    if (!marshal_pack_pending(source_vm, value, &blob)) {
+        marshal_blob_free(&blob);
+        return zym_newNull();
+    }
+
+    size_t offset = 0;
+    ZymValue result = marshal_unpack(target_vm, &blob, &offset);
+    marshal_settle(source_vm, &blob, result != ZYM_ERROR);
+    marshal_blob_free(&blob);
+    if (result == ZYM_ERROR) {
+        zym_runtimeError(caller_vm, "Failed to copy value between VMs");
+    }
+    return result;
+}
+
+// ---- Packed form ----------------------------------------------------------------
+// One tag byte per value followed by its payload; lengths are uint32.
+// Strings (values and map keys) go into a string table on first use and are
+// referred to by index after that. Lists, maps and Buffers get an object id
+// in the order they are first seen; seeing one again writes a back-reference,
+// which keeps shared values shared and makes cycles finite.
+
+enum {
+    MARSHAL_TAG_NULL,
+    MARSHAL_TAG_FALSE,
+    MARSHAL_TAG_TRUE,
+    MARSHAL_TAG_NUMBER,
+    MARSHAL_TAG_STRING,
+    MARSHAL_TAG_LIST,
+    MARSHAL_TAG_MAP,
+    MARSHAL_TAG_BUFFER,
+    MARSHAL_TAG_CHANNEL,
+    MARSHAL_TAG_STRING_REF,
+    MARSHAL_TAG_OBJECT_REF,
+    MARSHAL_TAG_BUFFER_REF
+};
+
+#define MARSHAL_MAX_DEPTH 512
+
+// Header of marshalEncode() output
+#define MARSHAL_MAGIC "ZYMM"
+#define MARSHAL_VERSION 1
+#define MARSHAL_HEADER_SIZE 5
+
+static bool marshal_reserve(MarshalBlob* blob, size_t extra) {
+    if (blob->length + extra <= blob->capacity) {
+        return true;
+    }
+    size_t new_capacity = blob->capacity ? blob->capacity * 2 : 256;
+    while (new_capacity < blob->length + extra) {
+        new_capacity *= 2;
+    }
+    uint8_t* new_data = realloc(blob->data, new_capacity);
+    if (!new_data) {
+        return false;
+    }
+    blob->data = new_data;
+    blob->capacity = new_capacity;
+    return true;
+}
+
+static bool marshal_put(MarshalBlob* blob, const void* bytes, size_t n) {
+    if (!marshal_reserve(blob, n)) {
+        return false;
+    }
+    memcpy(blob->data + blob->length, bytes, n);
+    blob->length += n;
+    return true;
+}
+
+static bool marshal_put_tag(MarshalBlob* blob, uint8_t tag) {
+    return marshal_put(blob, &tag, 1);
+}
+
+// Multi-byte fields are little-endian whatever the host, so encoded blobs
+// read back the same on any machine
+static bool marshal_put_u32(MarshalBlob* blob, size_t value) {
+    if (value > UINT32_MAX) {
+        blob->error = "value is too large";
+        return false;
+    }
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    return marshal_put(blob, bytes, sizeof(bytes));
+}
+
+static bool marshal_put_number(MarshalBlob* blob, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(bits >> (8 * i));
+    }
+    return marshal_put(blob, bytes, sizeof(bytes));
+}
+
+// Records a channel reference in the blob and writes its index
+static bool marshal_put_channel(MarshalBlob* blob, Channel* channel) {
+    if (blob->channel_count == blob->channel_capacity) {
+        size_t new_capacity = blob->channel_capacity ? blob->channel_capacity * 2 : 4;
+        Channel** new_channels = realloc(blob->channels, new_capacity * sizeof(Channel*));
+        if (!new_channels) {
+            return false;
+        }
+        blob->channels = new_channels;
+        blob->channel_capacity = new_capacity;
+    }
+    if (!marshal_put_tag(blob, MARSHAL_TAG_CHANNEL) || !marshal_put_u32(blob, blob->channel_count)) {
+        return false;
+    }
+    channel_retain(channel);
+    blob->channels[blob->channel_count++] = channel;
+    return true;
+}
+
+// Moves a transfer()ed Buffer's storage into the blob, or records a
+// reference to a shared Buffer, and writes its index
+static bool marshal_put_buffer_ref(MarshalBlob* blob, BufferData* buf) {
+    if (blob->buffer_count == blob->buffer_capacity) {
+        size_t new_capacity = blob->buffer_capacity ? blob->buffer_capacity * 2 : 4;
+        MarshalBufferRef* new_buffers = realloc(blob->buffers, new_capacity * sizeof(MarshalBufferRef));
+        if (!new_buffers) {
+            return false;
+        }
+        blob->buffers = new_buffers;
+        blob->buffer_capacity = new_capacity;
+    }
+    if (!marshal_put_tag(blob, MARSHAL_TAG_BUFFER_REF) || !marshal_put_u32(blob, blob->buffer_count)) {
+        return false;
+    }
+
+    MarshalBufferRef* ref = &blob->buffers[blob->buffer_count++];
+    ref->data = buf->data;
+    ref->capacity = buf->capacity;
+    ref->length = buf->length;
+    ref->position = buf->position;
+    ref->auto_grow = buf->auto_grow;
+    ref->endianness = buf->endianness;
+    ref->shared = buf->shared;
+    ref->source = NULL;
+
+    if (buf->shared) {
+        buffer_shared_retain(buf->shared);
+    } else {
+        ref->source = buf;
+        buf->data = NULL;
+        buf->capacity = 0;
+        buf->length = 0;
+        buf->position = 0;
+        buf->auto_grow = false;
+        buf->transfer_pending = false;
+    }
+    return true;
+}
+
+// Undoes marshal_put_buffer_ref for refs past `start` after a failed pack
+static void marshal_drop_buffer_refs(MarshalBlob* blob, size_t start) {
+    while (blob->buffer_count > start) {
+        MarshalBufferRef* ref = &blob->buffers[--blob->buffer_count];
+        if (ref->shared) {
+            buffer_shared_release(ref->shared);
+            continue;
+        }
+        BufferData* buf = (BufferData*)ref->source;
+        buf->data = ref->data;
+        buf->capacity = ref->capacity;
+        buf->length = ref->length;
+        buf->position = ref->position;
+        buf->auto_grow = ref->auto_grow;
+        buf->transfer_pending = true;
+    }
+}
+
+// ---- Packing --------------------------------------------------------------------
 
 typedef struct {
-    uint8_t* data;
-    size_t capacity;
+    const char* str;    // owned by the VM being packed, alive for the whole pack
     size_t length;
-    size_t position;
-    bool auto_grow;
-    int endianness;
-} BufferData;
+    uint32_t hash;
+    uint32_t index;
+} MarshalStringSlot;
 
-ZymValue marshal_reconstruct_list(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue source_list) {
-    int length = zym_listLength(source_list);
-    ZymValue target_list = zym_newList(target_vm);
-    zym_pushRoot(target_vm, target_list);
+typedef struct {
+    ZymValue value;
+    uint32_t index;
+    bool used;
+} MarshalObjectSlot;
 
-    for (int i = 0; i < length; i++) {
-        ZymValue source_elem = zym_listGet(source_vm, source_list, i);
+// Open-addressed tables for one marshal_pack() call
+typedef struct {
+    MarshalBlob* blob;
+    bool allow_refs;        // false: Buffers are always copied inline
 
-        ZymValue target_elem = marshal_reconstruct_value(caller_vm, source_vm, target_vm, source_elem);
+    MarshalStringSlot* strings;
+    size_t string_slots;
+    uint32_t string_count;
+
+    MarshalObjectSlot* objects;
+    size_t object_slots;
+    uint32_t object_count;
+} MarshalPacker;
+
+static uint32_t marshal_hash_string(const char* str, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t marshal_hash_value(ZymValue value) {
+    uint64_t x = (uint64_t)value;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+static bool marshal_grow_strings(MarshalPacker* packer) {
+    size_t new_slots = packer->string_slots ? packer->string_slots * 2 : 64;
+    MarshalStringSlot* new_strings = calloc(new_slots, sizeof(MarshalStringSlot));
+    if (!new_strings) {
+        return false;
+    }
+    for (size_t i = 0; i < packer->string_slots; i++) {
+        MarshalStringSlot* slot = &packer->strings[i];
+        if (!slot->str) continue;
+        size_t j = slot->hash & (new_slots - 1);
+        while (new_strings[j].str) {
+            j = (j + 1) & (new_slots - 1);
+        }
+        new_strings[j] = *slot;
+    }
+    free(packer->strings);
+    packer->strings = new_strings;
+    packer->string_slots = new_slots;
+    return true;
+}
 
-        if (zym_isNull(target_elem) && !zym_isNull(source_elem)) {
-            target_elem = zym_newNull();
+static bool marshal_grow_objects(MarshalPacker* packer) {
+    size_t new_slots = packer->object_slots ? packer->object_slots * 2 : 64;
+    MarshalObjectSlot* new_objects = calloc(new_slots, sizeof(MarshalObjectSlot));
+    if (!new_objects) {
+        return false;
+    }
+    for (size_t i = 0; i < packer->object_slots; i++) {
+        MarshalObjectSlot* slot = &packer->objects[i];
+        if (!slot->used) continue;
+        size_t j = marshal_hash_value(slot->value) & (new_slots - 1);
+        while (new_objects[j].used) {
+            j = (j + 1) & (new_slots - 1);
         }
+        new_objects[j] = *slot;
+    }
+    free(packer->objects);
+    packer->objects = new_objects;
+    packer->object_slots = new_slots;
+    return true;
+}
 
-        if (!zym_listAppend(target_vm, target_list, target_elem)) {
-            zym_popRoot(target_vm);
-            return ZYM_ERROR;
+// Writes a string value or map key, as a table reference if it was seen before
+static bool marshal_put_string(MarshalPacker* packer, const char* str) {
+    size_t length = strlen(str);
+    uint32_t hash = marshal_hash_string(str, length);
+
+    if ((packer->string_count + 1) * 2 > packer->string_slots && !marshal_grow_strings(packer)) {
+        return false;
+    }
+    size_t i = hash & (packer->string_slots - 1);
+    while (packer->strings[i].str) {
+        MarshalStringSlot* slot = &packer->strings[i];
+        if (slot->hash == hash && slot->length == length && memcmp(slot->str, str, length) == 0) {
+            return marshal_put_tag(packer->blob, MARSHAL_TAG_STRING_REF) && marshal_put_u32(packer->blob, slot->index);
         }
+        i = (i + 1) & (packer->string_slots - 1);
     }
 
-    zym_popRoot(target_vm);
-    return target_list;
+    if (!marshal_put_tag(packer->blob, MARSHAL_TAG_STRING) ||
+        !marshal_put_u32(packer->blob, length) ||
+        !marshal_put(packer->blob, str, length)) {
+        return false;
+    }
+    packer->strings[i] = (MarshalStringSlot){ .str = str, .length = length, .hash = hash, .index = packer->string_count++ };
+    return true;
 }
 
-ZymValue marshal_reconstruct_map(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue source_map) {
-    ZymValue target_map = zym_newMap(target_vm);
-    zym_pushRoot(target_vm, target_map);
+// Returns true if value was already packed, after writing a back-reference.
+// Otherwise gives it the next object id.
+static bool marshal_seen_object(MarshalPacker* packer, ZymValue value, bool* ok) {
+    *ok = true;
+    if ((packer->object_count + 1) * 2 > packer->object_slots && !marshal_grow_objects(packer)) {
+        *ok = false;
+        return true;
+    }
+    size_t i = marshal_hash_value(value) & (packer->object_slots - 1);
+    while (packer->objects[i].used) {
+        if (packer->objects[i].value == value) {
+            *ok = marshal_put_tag(packer->blob, MARSHAL_TAG_OBJECT_REF) &&
+                  marshal_put_u32(packer->blob, packer->objects[i].index);
+            return true;
+        }
+        i = (i + 1) & (packer->object_slots - 1);
+    }
+    packer->objects[i] = (MarshalObjectSlot){ .value = value, .index = packer->object_count++, .used = true };
+    return false;
+}
+
+static bool marshal_pack_value(ZymVM* vm, MarshalPacker* packer, ZymValue value, int depth);
 
-    typedef struct {
-        ZymVM* caller_vm;
-        ZymVM* source_vm;
-        ZymVM* target_vm;
-        ZymValue target_map;
-        bool success;
-    } MapReconstructContext;
+typedef struct {
+    MarshalPacker* packer;
+    int depth;
+    bool success;
+} MarshalPackContext;
 
-    MapReconstructContext ctx = {
-        .caller_vm = caller_vm,
-        .source_vm = source_vm,
-        .target_vm = target_vm,
-        .target_map = target_map,
-        .success = true
-    };
+static bool marshal_pack_entry(ZymVM* vm, const char* key, ZymValue val, void* userdata) {
+    MarshalPackContext* ctx = (MarshalPackContext*)userdata;
+    if (!marshal_put_string(ctx->packer, key) || !marshal_pack_value(vm, ctx->packer, val, ctx->depth)) {
+        ctx->success = false;
+        return false;
+    }
+    return true;
+}
+
+static bool marshal_count_entry(ZymVM* vm, const char* key, ZymValue val, void* userdata) {
+    (*(size_t*)userdata)++;
+    return true;
+}
 
-    bool map_iterator(ZymVM* vm, const char* key, ZymValue source_val, void* userdata) {
-        MapReconstructContext* ctx = (MapReconstructContext*)userdata;
+static bool marshal_pack_value(ZymVM* vm, MarshalPacker* packer, ZymValue value, int depth) {
+    MarshalBlob* blob = packer->blob;
+    if (depth > MARSHAL_MAX_DEPTH) {
+        blob->error = "value is nested too deeply";
+        return false;
+    }
+
+    if (zym_isNull(value)) {
+        return marshal_put_tag(blob, MARSHAL_TAG_NULL);
+    }
+    if (zym_isBool(value)) {
+        return marshal_put_tag(blob, zym_asBool(value) ? MARSHAL_TAG_TRUE : MARSHAL_TAG_FALSE);
+    }
+    if (zym_isNumber(value)) {
+        double num = zym_asNumber(value);
+        return marshal_put_tag(blob, MARSHAL_TAG_NUMBER) && marshal_put_number(blob, num);
+    }
+    if (zym_isString(value)) {
+        return marshal_put_string(packer, zym_asCString(value));
+    }
+
+    bool ok;
+    if (zym_isList(value)) {
+        if (marshal_seen_object(packer, value, &ok)) {
+            return ok;
+        }
+        int length = zym_listLength(value);
+        if (!marshal_put_tag(blob, MARSHAL_TAG_LIST) || !marshal_put_u32(blob, (size_t)length)) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            if (!marshal_pack_value(vm, packer, zym_listGet(vm, value, i), depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (zym_isMap(value)) {
+        Channel* channel = channel_from_value(vm, value);
+        if (channel) {
+            return marshal_put_channel(blob, channel);
+        }
 
-        ZymValue target_val = marshal_reconstruct_value(ctx->caller_vm, ctx->source_vm, ctx->target_vm, source_val);
+        if (marshal_seen_object(packer, value, &ok)) {
+            return ok;
+        }
 
-        if (zym_isNull(target_val) && !zym_isNull(source_val)) {
-            target_val = zym_newNull();
+        BufferData* buf = buffer_from_value(vm, value);
+        if (buf && packer->allow_refs && (buf->shared || buf->transfer_pending)) {
+            return marshal_put_buffer_ref(blob, buf);
+        }
+        if (buf) {
+            uint8_t flags = buf->auto_grow ? 1 : 0;
+            return marshal_put_tag(blob, MARSHAL_TAG_BUFFER) &&
+                   marshal_put_u32(blob, buf->capacity) &&
+                   marshal_put_u32(blob, buf->length) &&
+                   marshal_put_u32(blob, buf->position) &&
+                   marshal_put(blob, &flags, 1) &&
+                   marshal_put_u32(blob, buf->endianness == ENDIAN_BIG ? ENDIAN_BIG : ENDIAN_LITTLE) &&
+                   marshal_put(blob, buf->data, buf->length);
         }
 
-        if (!zym_mapSet(ctx->target_vm, ctx->target_map, key, target_val)) {
-            ctx->success = false;
+        size_t count = 0;
+        zym_mapForEach(vm, value, marshal_count_entry, &count);
+        if (!marshal_put_tag(blob, MARSHAL_TAG_MAP) || !marshal_put_u32(blob, count)) {
             return false;
         }
+        MarshalPackContext ctx = { .packer = packer, .depth = depth + 1, .success = true };
+        zym_mapForEach(vm, value, marshal_pack_entry, &ctx);
+        return ctx.success;
+    }
 
-        return true;
+    // Functions, structs and enums stay behind; nested ones become null
+    if (depth == 0) {
+        blob->error = "functions, structs and enums cannot cross VMs";
+        return false;
     }
+    return marshal_put_tag(blob, MARSHAL_TAG_NULL);
+}
 
-    zym_mapForEach(source_vm, source_map, map_iterator, &ctx);
+static bool marshal_pack_with(ZymVM* vm, ZymValue value, MarshalBlob* blob, bool allow_refs) {
+    size_t start = blob->length;
+    size_t channel_start = blob->channel_count;
+    size_t buffer_start = blob->buffer_count;
 
-    zym_popRoot(target_vm);
+    blob->error = NULL;
+    MarshalPacker packer = { .blob = blob, .allow_refs = allow_refs };
+    bool ok = marshal_pack_value(vm, &packer, value, 0);
+    free(packer.strings);
+    free(packer.objects);
 
-    if (!ctx.success) {
-        return ZYM_ERROR;
+    if (!ok) {
+        // Every other failure is an allocation
+        if (!blob->error) {
+            blob->error = "out of memory";
+        }
+        blob->length = start;
+        while (blob->channel_count > channel_start) {
+            channel_release(blob->channels[--blob->channel_count]);
+        }
+        marshal_drop_buffer_refs(blob, buffer_start);
+        return false;
     }
+    return true;
+}
 
-    return target_map;
+// Makes the moves of refs past `start` final, or (unpacked == false) puts
+// the storage back into the Buffers it came from
+static void marshal_settle_from(ZymVM* vm, MarshalBlob* blob, size_t start, bool unpacked) {
+    if (!unpacked) {
+        marshal_drop_buffer_refs(blob, start);
+        return;
+    }
+    // The moved-from Buffers may be collected from here on. Moved storage
+    // is no longer charged to this VM; the VM that adopts it pays instead.
+    for (size_t i = start; i < blob->buffer_count; i++) {
+        if (blob->buffers[i].source) {
+            zymvm_quota_release_buffer(vm, blob->buffers[i].capacity);
+        }
+        blob->buffers[i].source = NULL;
+    }
 }
 
-ZymValue marshal_reconstruct_buffer(ZymVM* source_vm, ZymVM* target_vm, ZymValue source_buffer) {
-    ZymValue getLength = zym_mapGet(source_vm, source_buffer, "getLength");
-    if (zym_isNull(getLength)) {
-        return zym_newNull();
+bool marshal_pack(ZymVM* vm, ZymValue value, MarshalBlob* blob) {
+    size_t buffer_start = blob->buffer_count;
+    if (!marshal_pack_with(vm, value, blob, true)) {
+        return false;
     }
+    marshal_settle_from(vm, blob, buffer_start, true);
+    return true;
+}
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* source_buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!source_buf) {
-        return zym_newNull();
+bool marshal_pack_pending(ZymVM* vm, ZymValue value, MarshalBlob* blob) {
+    return marshal_pack_with(vm, value, blob, true);
+}
+
+void marshal_settle(ZymVM* vm, MarshalBlob* blob, bool unpacked) {
+    marshal_settle_from(vm, blob, 0, unpacked);
+}
+
+// ---- Unpacking ------------------------------------------------------------------
+
+typedef struct {
+    size_t offset;      // of the bytes in the blob
+    uint32_t length;
+    char* cstr;         // NUL-terminated copy, made on first use
+    ZymValue value;     // string value, made on first use
+} MarshalStringEntry;
+
+// Tables for one marshal_unpack() call. Objects are registered before their
+// contents are read, so a back-reference inside a list can point at the list.
+typedef struct {
+    ZymVM* vm;
+    const MarshalBlob* blob;
+    size_t* offset;
+
+    MarshalStringEntry* strings;
+    uint32_t string_count;
+    uint32_t string_capacity;
+
+    ZymValue* objects;
+    uint32_t object_count;
+    uint32_t object_capacity;
+
+    // Per blob buffer ref: the Buffer that adopted its moved storage, so a
+    // failed unpack can take the storage back
+    BufferData** adopted;
+} MarshalUnpacker;
+
+static bool marshal_take(const MarshalBlob* blob, size_t* offset, void* out, size_t n) {
+    if (n > blob->length - *offset) {
+        return false;
     }
+    memcpy(out, blob->data + *offset, n);
+    *offset += n;
+    return true;
+}
 
-    ZymValue capacity = zym_newNumber((double)source_buf->capacity);
-    ZymValue autoGrow = zym_newBool(source_buf->auto_grow);
-    ZymValue target_buffer = nativeBuffer_create(target_vm, capacity, autoGrow);
-    if (target_buffer == ZYM_ERROR) {
-        return zym_newNull();
+static bool marshal_take_u32(const MarshalBlob* blob, size_t* offset, uint32_t* out) {
+    uint8_t bytes[4];
+    if (!marshal_take(blob, offset, bytes, sizeof(bytes))) {
+        return false;
+    }
+    *out = 0;
+    for (int i = 0; i < 4; i++) {
+        *out |= (uint32_t)bytes[i] << (8 * i);
     }
+    return true;
+}
 
-    ZymValue target_getLength = zym_mapGet(target_vm, target_buffer, "getLength");
-    ZymValue target_context = zym_getClosureContext(target_getLength);
-    BufferData* target_buf = (BufferData*)zym_getNativeData(target_context);
-    if (!target_buf) {
-        return zym_newNull();
+static bool marshal_take_number(const MarshalBlob* blob, size_t* offset, double* out) {
+    uint8_t bytes[8];
+    if (!marshal_take(blob, offset, bytes, sizeof(bytes))) {
+        return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        bits |= (uint64_t)bytes[i] << (8 * i);
+    }
+    memcpy(out, &bits, sizeof(*out));
+    return true;
+}
+
+// Reads a STRING or STRING_REF whose tag has already been consumed
+static MarshalStringEntry* marshal_take_string(MarshalUnpacker* u, uint8_t tag) {
+    uint32_t value;
+    if (!marshal_take_u32(u->blob, u->offset, &value)) {
+        return NULL;
     }
 
-    memcpy(target_buf->data, source_buf->data, source_buf->length);
-    target_buf->length = source_buf->length;
-    target_buf->position = source_buf->position;
-    target_buf->auto_grow = source_buf->auto_grow;
-    target_buf->endianness = source_buf->endianness;
+    if (tag == MARSHAL_TAG_STRING_REF) {
+        return value < u->string_count ? &u->strings[value] : NULL;
+    }
 
-    return target_buffer;
+    if (value > u->blob->length - *u->offset) {
+        return NULL;
+    }
+    if (u->string_count == u->string_capacity) {
+        uint32_t new_capacity = u->string_capacity ? u->string_capacity * 2 : 32;
+        MarshalStringEntry* new_strings = realloc(u->strings, new_capacity * sizeof(MarshalStringEntry));
+        if (!new_strings) {
+            return NULL;
+        }
+        u->strings = new_strings;
+        u->string_capacity = new_capacity;
+    }
+    MarshalStringEntry* entry = &u->strings[u->string_count++];
+    entry->offset = *u->offset;
+    entry->length = value;
+    entry->cstr = NULL;
+    entry->value = ZYM_ERROR;
+    *u->offset += value;
+    return entry;
 }
 
-ZymValue marshal_reconstruct_value(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue value) {
-    if (zym_isNull(value) || zym_isBool(value) || zym_isNumber(value)) {
-        return value;
+static const char* marshal_string_cstr(MarshalUnpacker* u, MarshalStringEntry* entry) {
+    if (!entry->cstr) {
+        entry->cstr = malloc((size_t)entry->length + 1);
+        if (!entry->cstr) {
+            return NULL;
+        }
+        memcpy(entry->cstr, u->blob->data + entry->offset, entry->length);
+        entry->cstr[entry->length] = '\0';
     }
+    return entry->cstr;
+}
 
-    if (zym_isString(value)) {
-        const char* str = zym_asCString(value);
-        return zym_newString(target_vm, str);
+static bool marshal_register_object(MarshalUnpacker* u, ZymValue value) {
+    if (u->object_count == u->object_capacity) {
+        uint32_t new_capacity = u->object_capacity ? u->object_capacity * 2 : 32;
+        ZymValue* new_objects = realloc(u->objects, new_capacity * sizeof(ZymValue));
+        if (!new_objects) {
+            return false;
+        }
+        u->objects = new_objects;
+        u->object_capacity = new_capacity;
     }
+    u->objects[u->object_count++] = value;
+    return true;
+}
 
-    if (zym_isList(value)) {
-        return marshal_reconstruct_list(caller_vm, source_vm, target_vm, value);
+static ZymValue marshal_unpack_value(MarshalUnpacker* u, int depth) {
+    ZymVM* vm = u->vm;
+    const MarshalBlob* blob = u->blob;
+    size_t* offset = u->offset;
+
+    uint8_t tag;
+    if (depth > MARSHAL_MAX_DEPTH || !marshal_take(blob, offset, &tag, 1)) {
+        return ZYM_ERROR;
     }
 
-    if (zym_isMap(value)) {
-        ZymValue as_buffer = marshal_reconstruct_buffer(source_vm, target_vm, value);
-        if (!zym_isNull(as_buffer)) {
-            return as_buffer;
+    switch (tag) {
+        case MARSHAL_TAG_NULL:
+            return zym_newNull();
+        case MARSHAL_TAG_FALSE:
+            return zym_newBool(false);
+        case MARSHAL_TAG_TRUE:
+            return zym_newBool(true);
+
+        case MARSHAL_TAG_NUMBER: {
+            double num;
+            if (!marshal_take_number(blob, offset, &num)) return ZYM_ERROR;
+            return zym_newNumber(num);
+        }
+
+        case MARSHAL_TAG_STRING:
+        case MARSHAL_TAG_STRING_REF: {
+            MarshalStringEntry* entry = marshal_take_string(u, tag);
+            if (!entry) return ZYM_ERROR;
+            // Strings are immutable, so every occurrence can share one value
+            if (entry->value == ZYM_ERROR) {
+                const char* str = marshal_string_cstr(u, entry);
+                if (!str) return ZYM_ERROR;
+                entry->value = zym_newString(vm, str);
+            }
+            return entry->value;
+        }
+
+        case MARSHAL_TAG_OBJECT_REF: {
+            uint32_t index;
+            if (!marshal_take_u32(blob, offset, &index) || index >= u->object_count) return ZYM_ERROR;
+            return u->objects[index];
+        }
+
+        case MARSHAL_TAG_LIST: {
+            uint32_t count;
+            if (!marshal_take_u32(blob, offset, &count)) return ZYM_ERROR;
+            ZymValue list = zym_newList(vm);
+            zym_pushRoot(vm, list);
+            if (!marshal_register_object(u, list)) {
+                zym_popRoot(vm);
+                return ZYM_ERROR;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                ZymValue item = marshal_unpack_value(u, depth + 1);
+                if (item == ZYM_ERROR || !zym_listAppend(vm, list, item)) {
+                    zym_popRoot(vm);
+                    return ZYM_ERROR;
+                }
+            }
+            zym_popRoot(vm);
+            return list;
+        }
+
+        case MARSHAL_TAG_MAP: {
+            uint32_t count;
+            if (!marshal_take_u32(blob, offset, &count)) return ZYM_ERROR;
+            ZymValue map = zym_newMap(vm);
+            zym_pushRoot(vm, map);
+            if (!marshal_register_object(u, map)) {
+                zym_popRoot(vm);
+                return ZYM_ERROR;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                uint8_t key_tag;
+                MarshalStringEntry* key_entry = NULL;
+                if (marshal_take(blob, offset, &key_tag, 1) &&
+                    (key_tag == MARSHAL_TAG_STRING || key_tag == MARSHAL_TAG_STRING_REF)) {
+                    key_entry = marshal_take_string(u, key_tag);
+                }
+                const char* key = key_entry ? marshal_string_cstr(u, key_entry) : NULL;
+                if (!key) {
+                    zym_popRoot(vm);
+                    return ZYM_ERROR;
+                }
+
+                // key is its own allocation, so it survives the string table
+                // growing while the item is unpacked
+                ZymValue item = marshal_unpack_value(u, depth + 1);
+                if (item == ZYM_ERROR || !zym_mapSet(vm, map, key, item)) {
+                    zym_popRoot(vm);
+                    return ZYM_ERROR;
+                }
+            }
+            zym_popRoot(vm);
+            return map;
+        }
+
+        case MARSHAL_TAG_BUFFER: {
+            uint32_t capacity, length, position;
+            uint8_t flags;
+            uint32_t endianness;
+            if (!marshal_take_u32(blob, offset, &capacity) ||
+                !marshal_take_u32(blob, offset, &length) ||
+                !marshal_take_u32(blob, offset, &position) ||
+                !marshal_take(blob, offset, &flags, 1) ||
+                !marshal_take_u32(blob, offset, &endianness) ||
+                length > capacity || length > blob->length - *offset) {
+                return ZYM_ERROR;
+            }
+
+            // A Buffer emptied by transfer() still round-trips as an empty one
+            ZymValue target_buffer = nativeBuffer_create(vm, zym_newNumber((double)(capacity ? capacity : 1)), zym_newBool(flags & 1));
+            if (target_buffer == ZYM_ERROR) return ZYM_ERROR;
+            BufferData* target_buf = buffer_from_value(vm, target_buffer);
+            if (!target_buf || !marshal_register_object(u, target_buffer)) return ZYM_ERROR;
+
+            memcpy(target_buf->data, blob->data + *offset, length);
+            *offset += length;
+            target_buf->length = length;
+            target_buf->position = position <= length ? position : length;
+            // Decoded input is untrusted; anything but big-endian reads as little
+            target_buf->endianness = endianness == ENDIAN_BIG ? ENDIAN_BIG : ENDIAN_LITTLE;
+            return target_buffer;
+        }
+
+        case MARSHAL_TAG_BUFFER_REF: {
+            uint32_t index;
+            if (!marshal_take_u32(blob, offset, &index) || index >= blob->buffer_count) return ZYM_ERROR;
+            MarshalBufferRef* ref = &blob->buffers[index];
+            ZymValue target_buffer;
+            if (ref->shared) {
+                target_buffer = nativeBuffer_adopt(vm, ref->data, ref->capacity, ref->length, ref->position,
+                                                   false, ref->endianness, ref->shared);
+            } else if (ref->data) {
+                if (!u->adopted && !(u->adopted = calloc(blob->buffer_count, sizeof(BufferData*)))) {
+                    return ZYM_ERROR;
+                }
+                target_buffer = nativeBuffer_adopt(vm, ref->data, ref->capacity, ref->length, ref->position,
+                                                   ref->auto_grow, ref->endianness, NULL);
+                if (target_buffer != ZYM_ERROR) {
+                    u->adopted[index] = buffer_from_value(vm, target_buffer);
+                    ref->data = NULL;
+                }
+            } else {
+                // Moved storage can only be taken once; a second unpack of
+                // the same blob sees null
+                target_buffer = zym_newNull();
+            }
+            if (target_buffer == ZYM_ERROR || !marshal_register_object(u, target_buffer)) return ZYM_ERROR;
+            return target_buffer;
+        }
+
+        case MARSHAL_TAG_CHANNEL: {
+            uint32_t index;
+            if (!marshal_take_u32(blob, offset, &index) || index >= blob->channel_count) return ZYM_ERROR;
+            return channel_wrap(vm, blob->channels[index]);
         }
 
-        return marshal_reconstruct_map(caller_vm, source_vm, target_vm, value);
+        default:
+            return ZYM_ERROR;
     }
+}
 
-    return zym_newNull();
+ZymValue marshal_unpack(ZymVM* vm, const MarshalBlob* blob, size_t* offset) {
+    MarshalUnpacker unpacker = { .vm = vm, .blob = blob, .offset = offset };
+    ZymValue result = marshal_unpack_value(&unpacker, 0);
+    if (result == ZYM_ERROR && unpacker.adopted) {
+        // The half-built value is garbage; its Buffers give their moved
+        // storage back to the blob instead of freeing it with them
+        for (size_t i = 0; i < blob->buffer_count; i++) {
+            BufferData* target = unpacker.adopted[i];
+            if (!target) continue;
+            blob->buffers[i].data = target->data;
+            zymvm_quota_release_buffer(vm, target->capacity);
+            target->data = NULL;
+            target->capacity = 0;
+            target->length = 0;
+            target->position = 0;
+        }
+    }
+    free(unpacker.adopted);
+    for (uint32_t i = 0; i < unpacker.string_count; i++) {
+        free(unpacker.strings[i].cstr);
+    }
+    free(unpacker.strings);
+    free(unpacker.objects);
+    return result;
+}
+
+void marshal_blob_free(MarshalBlob* blob) {
+    for (size_t i = 0; i < blob->channel_count; i++) {
+        channel_release(blob->channels[i]);
+    }
+    free(blob->channels);
+    blob->channels = NULL;
+    blob->channel_count = 0;
+    blob->channel_capacity = 0;
+
+    for (size_t i = 0; i < blob->buffer_count; i++) {
+        if (blob->buffers[i].shared) {
+            buffer_shared_release(blob->buffers[i].shared);
+        } else {
+            free(blob->buffers[i].data);
+        }
+    }
+    free(blob->buffers);
+    blob->buffers = NULL;
+    blob->buffer_count = 0;
+    blob->buffer_capacity = 0;
+
+    free(blob->data);
+    blob->data = NULL;
+    blob->length = 0;
+    blob->capacity = 0;
+}
+
+// ---- Script API -----------------------------------------------------------------
+
+// Encodes value into a new Buffer: a "ZYMM" magic, a version byte and the
+// packed form. Numbers are stored little-endian, so the result can be
+// decoded on any host.
+ZymValue nativeMarshal_encode(ZymVM* vm, ZymValue value) {
+    MarshalBlob blob = {0};
+    bool ok = marshal_put(&blob, MARSHAL_MAGIC, 4) && marshal_put_tag(&blob, MARSHAL_VERSION) &&
+              marshal_pack_with(vm, value, &blob, false);
+    if (!ok || blob.channel_count > 0) {
+        marshal_blob_free(&blob);
+        zym_runtimeError(vm, ok ? "marshalEncode() cannot encode Channels"
+                                : "marshalEncode() cannot encode functions, structs or enums");
+        return ZYM_ERROR;
+    }
+
+    ZymValue buffer = nativeBuffer_create(vm, zym_newNumber((double)blob.length), zym_newBool(true));
+    if (buffer == ZYM_ERROR) {
+        marshal_blob_free(&blob);
+        return ZYM_ERROR;
+    }
+    BufferData* buf = buffer_from_value(vm, buffer);
+    memcpy(buf->data, blob.data, blob.length);
+    buf->length = blob.length;
+    marshal_blob_free(&blob);
+    return buffer;
+}
+
+ZymValue nativeMarshal_decode(ZymVM* vm, ZymValue bufferVal) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
+        zym_runtimeError(vm, "marshalDecode() requires a Buffer");
+        return ZYM_ERROR;
+    }
+    if (!buffer_check_readable(vm, buf)) {
+        return ZYM_ERROR;
+    }
+    if (buf->length < MARSHAL_HEADER_SIZE || memcmp(buf->data, MARSHAL_MAGIC, 4) != 0 ||
+        buf->data[4] != MARSHAL_VERSION) {
+        zym_runtimeError(vm, "marshalDecode() input is not marshalEncode() output");
+        return ZYM_ERROR;
+    }
+
+    // Borrows the Buffer's bytes; nothing in the body can reach a channel
+    MarshalBlob blob = { .data = buf->data, .length = buf->length, .capacity = buf->capacity };
+    size_t offset = MARSHAL_HEADER_SIZE;
+    ZymValue result = marshal_unpack(vm, &blob, &offset);
+    if (result == ZYM_ERROR || offset != blob.length) {
+        zym_runtimeError(vm, "marshalDecode() input is malformed");
+        return ZYM_ERROR;
+    }
+    return result;
 }
@@ -1,8 +1,66 @@
 #pragma once
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include "zym/zym.h"
 
+// Copies value from source_vm into target_vm by packing and unpacking it.
+// Unsupported values come back as null.
 ZymValue marshal_reconstruct_value(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue value);
-ZymValue marshal_reconstruct_list(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue source_list);
-ZymValue marshal_reconstruct_map(ZymVM* caller_vm, ZymVM* source_vm, ZymVM* target_vm, ZymValue source_map);
-ZymValue marshal_reconstruct_buffer(ZymVM* source_vm, ZymVM* target_vm, ZymValue source_buffer);
+
+// Buffer storage that travels beside the packed bytes instead of inside
+// them: moved out of a Buffer marked with transfer(), or a reference to a
+// shared Buffer's read-only bytes.
+typedef struct {
+    uint8_t* data;          // moved storage is owned until unpacked, then NULL
+    size_t capacity;
+    size_t length;
+    size_t position;
+    bool auto_grow;
+    int endianness;
+    struct BufferShared* shared;
+    void* source;           // moved-from Buffer, until the move is settled
+} MarshalBufferRef;
+
+// Self-contained byte form of a value. A blob holds no references into
+// either VM, so it can be built on one thread and unpacked into a VM owned
+// by another. Each marshal_pack() call must be matched by one
+// marshal_unpack() call: strings and shared objects are numbered per value.
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+
+    // Channels referenced by the packed bytes. Channels are shared rather
+    // than copied, so the blob keeps each one alive until it is freed.
+    struct Channel** channels;
+    size_t channel_count;
+    size_t channel_capacity;
+
+    MarshalBufferRef* buffers;
+    size_t buffer_count;
+    size_t buffer_capacity;
+
+    const char* error;      // why the last marshal_pack() failed
+} MarshalBlob;
+
+// Appends value to blob. Returns false for values that cannot cross VMs at
+// the top level (functions, structs, enums) or when out of memory; nested
+// unsupported values are packed as null, matching marshal_reconstruct_value.
+// On failure blob->error says why. Channels and shared Buffers are packed by
+// reference; a Buffer marked with transfer() has its storage moved into the
+// blob and is left empty.
+bool marshal_pack(ZymVM* vm, ZymValue value, MarshalBlob* blob);
+// For a blob unpacked straight away while value stays rooted and vm does not
+// run: like marshal_pack(), but Buffers marked with transfer() remember the
+// storage they gave up until marshal_settle(). Pass whether the unpack
+// succeeded; if it did not, the storage goes back and they are left as they
+// were.
+bool marshal_pack_pending(ZymVM* vm, ZymValue value, MarshalBlob* blob);
+void marshal_settle(ZymVM* vm, MarshalBlob* blob, bool unpacked);
+// Rebuilds the value starting at *offset and advances it. Returns ZYM_ERROR
+// on malformed input or when out of memory; moved Buffer storage is then
+// still owned by the blob.
+ZymValue marshal_unpack(ZymVM* vm, const MarshalBlob* blob, size_t* offset);
+void marshal_blob_free(MarshalBlob* blob);
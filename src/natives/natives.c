@@ -11,12 +11,23 @@ void setupNatives(ZymVM* vm)
     zym_defineNative(vm, "Random(seed)", nativeRandom_create_seeded);
     zym_defineNative(vm, "Buffer(size)", nativeBuffer_create_auto);
     zym_defineNative(vm, "Buffer(size, autoGrow)", nativeBuffer_create);
+    zym_defineNative(vm, "SharedBuffer(size)", nativeSharedBuffer_create);
     ZymValue consoleInstance = nativeConsole_create(vm);
     zym_defineGlobal(vm, "Console", consoleInstance);
     zym_defineNative(vm, "OS()", nativeOS_create);
-    zym_defineNative(vm, "ZymVM()", nativeZymVM_create);
+    zym_defineNative(vm, "ZymVM()", nativeZymVM_create_0);
+    zym_defineNative(vm, "ZymVM(options)", nativeZymVM_create);
+    zym_defineNative(vm, "compileCacheClear()", nativeZymVM_clearCompileCache);
+    zym_defineNative(vm, "ZymVMPool(bytecode)", nativeZymVMPool_create_1);
+    zym_defineNative(vm, "ZymVMPool(bytecode, options)", nativeZymVMPool_create);
+    zym_defineNative(vm, "Channel(capacity)", nativeChannel_create);
+    zym_defineNative(vm, "channelSelect(channels)", nativeChannel_select_1);
+    zym_defineNative(vm, "channelSelect(channels, timeoutMs)", nativeChannel_select);
+    zym_defineNative(vm, "marshalEncode(value)", nativeMarshal_encode);
+    zym_defineNative(vm, "marshalDecode(buffer)", nativeMarshal_decode);
 
-    zym_defineNative(vm, "fileOpen(path, mode)", nativeFile_open);
+    zym_defineNative(vm, "fileOpen(path, mode)", nativeFile_open_2);
+    zym_defineNative(vm, "fileOpen(path, mode, options)", nativeFile_open);
     zym_defineNative(vm, "fileRead(path)", nativeFile_readFile);
     zym_defineNative(vm, "fileWrite(path, data)", nativeFile_writeFile);
     zym_defineNative(vm, "fileAppend(path, data)", nativeFile_appendFile);
@@ -25,12 +36,18 @@ void setupNatives(ZymVM* vm)
     zym_defineNative(vm, "fileCopy(src, dst)", nativeFile_copy);
     zym_defineNative(vm, "fileRename(oldPath, newPath)", nativeFile_rename);
     zym_defineNative(vm, "fileStat(path)", nativeFile_stat);
+    zym_defineNative(vm, "fileStatMany(paths, fields)", nativeFile_statMany_2);
+    zym_defineNative(vm, "fileStatMany(paths, fields, options)", nativeFile_statMany);
     zym_defineNative(vm, "fileReadBuffer(path)", nativeFile_readToNewBuffer);
     zym_defineNative(vm, "fileWriteBuffer(path, buffer)", nativeFile_writeFromNewBuffer);
     zym_defineNative(vm, "dirCreate(path)", nativeDir_create);
     zym_defineNative(vm, "dirRemove(path)", nativeDir_remove);
     zym_defineNative(vm, "dirList(path)", nativeDir_list);
     zym_defineNative(vm, "dirExists(path)", nativeDir_exists);
+    zym_defineNative(vm, "dirWalk(path)", nativeDir_walk_1);
+    zym_defineNative(vm, "dirWalk(path, options)", nativeDir_walk);
+    zym_defineNative(vm, "dirWalker(path)", nativeDir_walker_1);
+    zym_defineNative(vm, "dirWalker(path, options)", nativeDir_walker);
 
     zym_defineNative(vm, "pathJoin(part1, part2)", nativePath_join);
     zym_defineNative(vm, "pathDirname(path)", nativePath_dirname);
@@ -40,12 +57,28 @@ void setupNatives(ZymVM* vm)
     zym_defineNative(vm, "pathAbsolute(path)", nativePath_absolute);
     zym_defineNative(vm, "pathIsAbsolute(path)", nativePath_isAbsolute);
 
+    zym_defineNative(vm, "CsvReader(source)", nativeCsv_reader_1);
+    zym_defineNative(vm, "CsvReader(source, options)", nativeCsv_reader);
+    zym_defineNative(vm, "CsvWriter(target)", nativeCsv_writer_1);
+    zym_defineNative(vm, "CsvWriter(target, options)", nativeCsv_writer);
+    zym_defineNative(vm, "csvFormat(rows)", nativeCsv_format_1);
+    zym_defineNative(vm, "csvFormat(rows, options)", nativeCsv_format);
+
+    zym_defineNative(vm, "jsonParse(source)", nativeJson_parse);
+    zym_defineNative(vm, "jsonStringify(value)", nativeJson_stringify_1);
+    zym_defineNative(vm, "jsonStringify(value, options)", nativeJson_stringify);
+    zym_defineNative(vm, "JsonDocument(source)", nativeJson_document);
+
     zym_defineNative(vm, "ProcessSpawn(command)", nativeProcess_spawn_1);
     zym_defineNative(vm, "ProcessSpawn(command, args)", nativeProcess_spawn_2);
     zym_defineNative(vm, "ProcessSpawn(command, args, options)", nativeProcess_spawn);
     zym_defineNative(vm, "ProcessExec(command)", nativeProcess_exec_1);
     zym_defineNative(vm, "ProcessExec(command, args)", nativeProcess_exec_2);
     zym_defineNative(vm, "ProcessExec(command, args, options)", nativeProcess_exec);
+    zym_defineNative(vm, "ProcessExecMany(commands)", nativeProcess_execMany_1);
+    zym_defineNative(vm, "ProcessExecMany(commands, options)", nativeProcess_execMany);
+    zym_defineNative(vm, "ProcessPipeline(commands)", nativeProcess_pipeline_1);
+    zym_defineNative(vm, "ProcessPipeline(commands, options)", nativeProcess_pipeline);
     zym_defineNative(vm, "processCwd()", nativeProcess_getCwd);
     zym_defineNative(vm, "processSetCwd(path)", nativeProcess_setCwd);
     zym_defineNative(vm, "processEnv(key)", nativeProcess_getEnv);
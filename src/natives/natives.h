@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "zym/zym.h"
 
 void setupNatives(ZymVM* vm);
@@ -19,8 +22,22 @@ ZymValue nativeRandom_create_seeded(ZymVM* vm, ZymValue seedVal);
 
 ZymValue nativeBuffer_create(ZymVM* vm, ZymValue sizeVal, ZymValue autoGrowVal);
 ZymValue nativeBuffer_create_auto(ZymVM* vm, ZymValue lengthVal);
-
-ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal);
+ZymValue nativeSharedBuffer_create(ZymVM* vm, ZymValue sizeVal);
+
+// Storage behind a shared Buffer or SharedBuffer, referenced from every VM
+// that holds a view of it
+typedef struct BufferShared BufferShared;
+void buffer_shared_retain(BufferShared* shared);
+void buffer_shared_release(BufferShared* shared);
+// Wraps existing storage in a new Buffer. Without `shared` the Buffer takes
+// ownership of data; with it, the Buffer is a view that holds its own
+// reference (read-only unless it came from SharedBuffer). On failure nothing
+// is taken.
+ZymValue nativeBuffer_adopt(ZymVM* vm, uint8_t* data, size_t capacity, size_t length, size_t position,
+                            bool auto_grow, int endianness, BufferShared* shared);
+
+ZymValue nativeFile_open_2(ZymVM* vm, ZymValue pathVal, ZymValue modeVal);
+ZymValue nativeFile_open(ZymVM* vm, ZymValue pathVal, ZymValue modeVal, ZymValue optionsVal);
 ZymValue nativeFile_readFile(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeFile_writeFile(ZymVM* vm, ZymValue pathVal, ZymValue dataVal);
 ZymValue nativeFile_appendFile(ZymVM* vm, ZymValue pathVal, ZymValue dataVal);
@@ -29,6 +46,13 @@ ZymValue nativeFile_delete(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeFile_copy(ZymVM* vm, ZymValue srcVal, ZymValue dstVal);
 ZymValue nativeFile_rename(ZymVM* vm, ZymValue oldPathVal, ZymValue newPathVal);
 ZymValue nativeFile_stat(ZymVM* vm, ZymValue pathVal);
+ZymValue nativeFile_statMany_2(ZymVM* vm, ZymValue pathsVal, ZymValue fieldsVal);
+ZymValue nativeFile_statMany(ZymVM* vm, ZymValue pathsVal, ZymValue fieldsVal, ZymValue optionsVal);
+
+FILE* nativeFile_dupHandle(ZymVM* vm, ZymValue fileVal);
+bool nativeFile_isWritable(ZymVM* vm, ZymValue fileVal);
+bool nativeFile_writeBytes(ZymVM* vm, ZymValue fileVal, const char* data, size_t len);
+bool nativeFile_flush(ZymVM* vm, ZymValue fileVal);
 
 ZymValue nativeFile_readToNewBuffer(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeFile_writeFromNewBuffer(ZymVM* vm, ZymValue pathVal, ZymValue bufferVal);
@@ -37,6 +61,10 @@ ZymValue nativeDir_create(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeDir_remove(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeDir_list(ZymVM* vm, ZymValue pathVal);
 ZymValue nativeDir_exists(ZymVM* vm, ZymValue pathVal);
+ZymValue nativeDir_walk_1(ZymVM* vm, ZymValue pathVal);
+ZymValue nativeDir_walk(ZymVM* vm, ZymValue pathVal, ZymValue optionsVal);
+ZymValue nativeDir_walker_1(ZymVM* vm, ZymValue pathVal);
+ZymValue nativeDir_walker(ZymVM* vm, ZymValue pathVal, ZymValue optionsVal);
 
 ZymValue nativePath_join(ZymVM* vm, ZymValue part1Val, ZymValue part2Val);
 ZymValue nativePath_dirname(ZymVM* vm, ZymValue pathVal);
@@ -46,12 +74,31 @@ ZymValue nativePath_normalize(ZymVM* vm, ZymValue pathVal);
 ZymValue nativePath_absolute(ZymVM* vm, ZymValue pathVal);
 ZymValue nativePath_isAbsolute(ZymVM* vm, ZymValue pathVal);
 
+ZymValue nativeCsv_reader_1(ZymVM* vm, ZymValue sourceVal);
+ZymValue nativeCsv_reader(ZymVM* vm, ZymValue sourceVal, ZymValue optionsVal);
+ZymValue nativeCsv_writer_1(ZymVM* vm, ZymValue targetVal);
+ZymValue nativeCsv_writer(ZymVM* vm, ZymValue targetVal, ZymValue optionsVal);
+ZymValue nativeCsv_format_1(ZymVM* vm, ZymValue rowsVal);
+ZymValue nativeCsv_format(ZymVM* vm, ZymValue rowsVal, ZymValue optionsVal);
+
+ZymValue nativeJson_parse(ZymVM* vm, ZymValue sourceVal);
+ZymValue nativeJson_stringify_1(ZymVM* vm, ZymValue value);
+ZymValue nativeJson_stringify(ZymVM* vm, ZymValue value, ZymValue optionsVal);
+ZymValue nativeJson_document(ZymVM* vm, ZymValue sourceVal);
+// Number text with '.' as the decimal point, whatever locale Console() set
+bool json_parse_double(const char* text, size_t len, double* out);
+int json_format_double(char* out, size_t size, int precision, double number);
+
 ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, ZymValue optionsMap);
 ZymValue nativeProcess_spawn_1(ZymVM* vm, ZymValue commandVal);
 ZymValue nativeProcess_spawn_2(ZymVM* vm, ZymValue commandVal, ZymValue argsVal);
 ZymValue nativeProcess_exec(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, ZymValue optionsMap);
 ZymValue nativeProcess_exec_1(ZymVM* vm, ZymValue commandVal);
 ZymValue nativeProcess_exec_2(ZymVM* vm, ZymValue commandVal, ZymValue argsVal);
+ZymValue nativeProcess_execMany(ZymVM* vm, ZymValue commandsVal, ZymValue optionsMap);
+ZymValue nativeProcess_execMany_1(ZymVM* vm, ZymValue commandsVal);
+ZymValue nativeProcess_pipeline(ZymVM* vm, ZymValue commandsVal, ZymValue optionsMap);
+ZymValue nativeProcess_pipeline_1(ZymVM* vm, ZymValue commandsVal);
 
 ZymValue nativeProcess_getCwd(ZymVM* vm);
 ZymValue nativeProcess_setCwd(ZymVM* vm, ZymValue pathVal);
@@ -64,4 +111,28 @@ ZymValue nativeProcess_getParentPid(ZymVM* vm);
 ZymValue nativeProcess_exit(ZymVM* vm, ZymValue codeVal);
 ZymValue nativeProcess_exit_0(ZymVM* vm);
 
-ZymValue nativeZymVM_create(ZymVM* vm);
+ZymValue nativeZymVM_create(ZymVM* vm, ZymValue optionsVal);
+ZymValue nativeZymVM_create_0(ZymVM* vm);
+// Buffer storage owned by a nested VM counts against its ZymVM() quota.
+// charge raises a runtime error on vm and returns false when it would go
+// over; try_charge is the same without the error. All are no-ops for VMs
+// without a quota.
+bool zymvm_quota_charge_buffer(ZymVM* vm, size_t bytes);
+bool zymvm_quota_try_charge_buffer(ZymVM* vm, size_t bytes);
+// Charges are looked up through the calling thread, so a helper thread that
+// grows Buffers for a VM adopts the quota current on that VM's thread, and
+// restores the one adopt returned before it exits.
+struct MemoryQuota* zymvm_quota_current(void);
+struct MemoryQuota* zymvm_quota_adopt(struct MemoryQuota* quota);
+void zymvm_quota_restore(struct MemoryQuota* outer);
+void zymvm_quota_release_buffer(ZymVM* vm, size_t bytes);
+ZymValue nativeZymVM_clearCompileCache(ZymVM* vm);
+ZymValue nativeZymVMPool_create(ZymVM* vm, ZymValue bufferVal, ZymValue optionsVal);
+ZymValue nativeZymVMPool_create_1(ZymVM* vm, ZymValue bufferVal);
+
+ZymValue nativeChannel_create(ZymVM* vm, ZymValue capacityVal);
+ZymValue nativeChannel_select(ZymVM* vm, ZymValue channelsVal, ZymValue timeoutVal);
+ZymValue nativeChannel_select_1(ZymVM* vm, ZymValue channelsVal);
+
+ZymValue nativeMarshal_encode(ZymVM* vm, ZymValue value);
+ZymValue nativeMarshal_decode(ZymVM* vm, ZymValue bufferVal);
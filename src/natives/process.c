@@ -1,14 +1,24 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include "./natives.h"
+#include "./buffer.h"
+#include "./thread.h"
 
 #ifdef _WIN32
     #include <windows.h>
     #include <process.h>
     #include <direct.h>
+    #include <io.h>
+    #include <psapi.h>
 
     // ConPTY support (Windows 10 1809+)
     // Define if missing from MinGW headers
@@ -36,31 +46,38 @@
     #include <fcntl.h>
     #include <poll.h>
     #include <termios.h>
+    #include <time.h>
+    #include <spawn.h>
+    #include <sys/stat.h>
 
     #ifdef __linux__
         #include <pty.h>
         #include <utmp.h>
+        #include <sys/syscall.h>
     #elif defined(__APPLE__) || defined(__FreeBSD__)
         #include <util.h>
     #endif
 #endif
 
-typedef struct {
-    uint8_t* data;
-    size_t capacity;
-    size_t length;
-    size_t position;
-    bool auto_grow;
-    int endianness;
-} BufferData;
-
 typedef enum {
     STDIO_PIPE,
     STDIO_INHERIT,
     STDIO_NULL,
-    STDIO_PTY
+    STDIO_PTY,
+    STDIO_FILE      // Redirected to a file path or an existing descriptor
 } StdioMode;
 
+// Resource usage of an exited child, from wait4() or GetProcessTimes()
+typedef struct {
+    double user_ms;
+    double system_ms;
+    double max_rss_bytes;
+    double minor_faults;
+    double major_faults;
+    double voluntary_switches;
+    double involuntary_switches;
+} ProcessUsage;
+
 typedef struct {
 #ifdef _WIN32
     HANDLE hProcess;
@@ -84,6 +101,7 @@ typedef struct {
     bool is_running;
     int exit_code;
     bool exit_code_valid;
+    int spawn_errno;        // Why spawning failed, 0 if unknown
     bool stdin_open;
     bool stdout_open;
     bool stderr_open;
@@ -99,8 +117,180 @@ typedef struct {
     char** args;
     int argc;
     char* cwd;
+    long kill_grace_ms;
+    size_t read_size;       // Bytes per read()/readErr()/readNonBlock() call
+    char* read_buffer;      // read_size + 1 bytes
+
+    // Buffers receiving output while waiting (owned by the script)
+    BufferData* stdout_sink;
+    BufferData* stderr_sink;
+
+    double started_ms;
+    double wall_ms;
+    bool usage_valid;
+    ProcessUsage usage;
 } ProcessData;
 
+#define PROCESS_DEFAULT_KILL_GRACE_MS 1000
+#define PROCESS_DEFAULT_READ_SIZE 4096
+#define PROCESS_MAX_READ_SIZE (16 * 1024 * 1024)
+
+#ifndef _WIN32
+
+// ---- Reaper ---------------------------------------------------------------------
+// Finalizing a Process whose child is still running must not stall the VM.
+// The child is sent SIGTERM and handed to a background thread that reaps it,
+// escalating to SIGKILL once its grace period runs out. The thread sleeps in
+// poll() on the children's pidfds (or a short tick without them) plus a wake
+// pipe for newly submitted children.
+
+typedef struct {
+    pid_t pid;
+    int pidfd;
+    double kill_at_ms;
+    bool killed;
+} ReaperEntry;
+
+static struct {
+    Mutex lock;
+    bool started;
+    int wake_pipe[2];
+    ReaperEntry* entries;
+    int count;
+    int capacity;
+    bool init_failed;
+} reaper = { .lock = MUTEX_INITIALIZER };
+
+static double reaper_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static void reaper_thread(void* arg) {
+    (void)arg;
+    struct pollfd* fds = NULL;
+    int fds_capacity = 0;
+
+    for (;;) {
+        mutex_lock(&reaper.lock);
+
+        double now = reaper_now_ms();
+        for (int i = 0; i < reaper.count; i++) {
+            ReaperEntry* entry = &reaper.entries[i];
+            pid_t result = waitpid(entry->pid, NULL, WNOHANG);
+            if (result == entry->pid || (result < 0 && errno == ECHILD)) {
+                if (entry->pidfd >= 0) close(entry->pidfd);
+                reaper.entries[i--] = reaper.entries[--reaper.count];
+                continue;
+            }
+            if (!entry->killed && now >= entry->kill_at_ms) {
+                kill(entry->pid, SIGKILL);
+                entry->killed = true;
+            }
+        }
+
+        if (fds_capacity < reaper.count + 1) {
+            fds_capacity = reaper.count + 16;
+            struct pollfd* new_fds = realloc(fds, sizeof(struct pollfd) * (size_t)fds_capacity);
+            if (new_fds) fds = new_fds;
+            else fds_capacity = 0;
+        }
+
+        int nfds = 0;
+        int timeout = -1;
+        if (fds) {
+            fds[nfds].fd = reaper.wake_pipe[0];
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+        for (int i = 0; i < reaper.count; i++) {
+            ReaperEntry* entry = &reaper.entries[i];
+            if (entry->pidfd >= 0 && nfds < fds_capacity) {
+                fds[nfds].fd = entry->pidfd;
+                fds[nfds].events = POLLIN;
+                nfds++;
+            } else {
+                timeout = 20;
+            }
+            if (!entry->killed) {
+                int until_kill = (int)(entry->kill_at_ms - now) + 1;
+                if (until_kill < 1) until_kill = 1;
+                if (timeout < 0 || until_kill < timeout) timeout = until_kill;
+            }
+        }
+
+        mutex_unlock(&reaper.lock);
+
+        if (poll(fds, (nfds_t)nfds, timeout) > 0 && (fds[0].revents & POLLIN)) {
+            char drain[64];
+            while (read(reaper.wake_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+    }
+}
+
+// Takes ownership of reaping `pid`. Returns false if the reaper could not be
+// started, in which case the caller must reap the child itself.
+static bool reaper_submit(pid_t pid, long grace_ms) {
+    // Several threads (callAsync, pool workers, run-many -j) may finalize
+    // Processes at once, so the one-time setup happens under the lock
+    mutex_lock(&reaper.lock);
+    if (reaper.init_failed) {
+        mutex_unlock(&reaper.lock);
+        return false;
+    }
+
+    if (!reaper.started) {
+        if (pipe(reaper.wake_pipe) < 0) {
+            reaper.init_failed = true;
+            mutex_unlock(&reaper.lock);
+            return false;
+        }
+        for (int i = 0; i < 2; i++) {
+            fcntl(reaper.wake_pipe[i], F_SETFL, fcntl(reaper.wake_pipe[i], F_GETFL, 0) | O_NONBLOCK);
+            fcntl(reaper.wake_pipe[i], F_SETFD, FD_CLOEXEC);
+        }
+        ThreadHandle thread;
+        if (!thread_start(&thread, reaper_thread, NULL)) {
+            close(reaper.wake_pipe[0]);
+            close(reaper.wake_pipe[1]);
+            reaper.init_failed = true;
+            mutex_unlock(&reaper.lock);
+            return false;
+        }
+        reaper.started = true;
+    }
+
+    if (reaper.count == reaper.capacity) {
+        int new_capacity = reaper.capacity ? reaper.capacity * 2 : 16;
+        ReaperEntry* new_entries = realloc(reaper.entries, sizeof(ReaperEntry) * (size_t)new_capacity);
+        if (!new_entries) {
+            mutex_unlock(&reaper.lock);
+            return false;
+        }
+        reaper.entries = new_entries;
+        reaper.capacity = new_capacity;
+    }
+
+    ReaperEntry* entry = &reaper.entries[reaper.count++];
+    entry->pid = pid;
+    entry->pidfd = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    entry->pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+#endif
+    entry->kill_at_ms = reaper_now_ms() + (double)grace_ms;
+    entry->killed = grace_ms <= 0;
+    mutex_unlock(&reaper.lock);
+
+    char byte = 0;
+    if (write(reaper.wake_pipe[1], &byte, 1) < 0) {
+        // Wake pipe full: the reaper is already due to run
+    }
+    return true;
+}
+
+#endif
+
 void process_cleanup(ZymVM* vm, void* ptr) {
     ProcessData* proc = (ProcessData*)ptr;
 
@@ -119,9 +309,9 @@ void process_cleanup(ZymVM* vm, void* ptr) {
         CloseHandle(proc->hStderr);
     }
 
+    // Windows has no zombies to collect: terminate and let the handle go
     if (proc->is_running && proc->hProcess != INVALID_HANDLE_VALUE) {
         TerminateProcess(proc->hProcess, 1);
-        WaitForSingleObject(proc->hProcess, INFINITE);
     }
 
     if (proc->hProcess != INVALID_HANDLE_VALUE) {
@@ -144,11 +334,10 @@ void process_cleanup(ZymVM* vm, void* ptr) {
         close(proc->pty_master);
     }
 
-    if (proc->is_running && proc->pid > 0) {
-        kill(proc->pid, SIGTERM);
-        usleep(100000);
-        waitpid(proc->pid, NULL, WNOHANG);
-        if (proc->is_running) {
+    if (proc->is_running && proc->pid > 0 && waitpid(proc->pid, NULL, WNOHANG) == 0) {
+        long grace_ms = proc->kill_grace_ms;
+        kill(proc->pid, grace_ms > 0 ? SIGTERM : SIGKILL);
+        if (!reaper_submit(proc->pid, grace_ms)) {
             kill(proc->pid, SIGKILL);
             waitpid(proc->pid, NULL, 0);
         }
@@ -157,6 +346,7 @@ void process_cleanup(ZymVM* vm, void* ptr) {
 
     free(proc->stdout_buffer);
     free(proc->stderr_buffer);
+    free(proc->read_buffer);
     free(proc->command);
     free(proc->cwd);
 
@@ -197,8 +387,59 @@ static bool ensure_buffer_capacity(char** buffer, size_t* capacity, size_t neede
     return true;
 }
 
+// A descriptor number given as stdout/stderr must be a whole, non-negative
+// int; anything else would be truncated into some unrelated descriptor
+static bool spawn_fd_number(ZymValue opt, int* fd) {
+    double value = zym_asNumber(opt);
+    if (!(value >= 0 && value <= INT_MAX) || value != (double)(int)value) {
+        return false;
+    }
+    *fd = (int)value;
+    return true;
+}
+
 #ifdef _WIN32
 
+// Resolves a {file: path, append: bool} map or a C runtime descriptor number
+// into an inheritable handle for the child's stdout/stderr. The handle is
+// owned by the caller. Returns false if the file cannot be opened or the
+// descriptor is invalid.
+static bool spawn_stdio_target(ZymVM* vm, ZymValue opt, StdioMode* mode, HANDLE* handle, SECURITY_ATTRIBUTES* sa) {
+    if (zym_isNumber(opt)) {
+        int crt_fd;
+        if (!spawn_fd_number(opt, &crt_fd)) {
+            return false;
+        }
+        HANDLE source = (HANDLE)_get_osfhandle(crt_fd);
+        if (source == INVALID_HANDLE_VALUE ||
+            !DuplicateHandle(GetCurrentProcess(), source, GetCurrentProcess(), handle,
+                             0, TRUE, DUPLICATE_SAME_ACCESS)) {
+            return false;
+        }
+        *mode = STDIO_FILE;
+        return true;
+    }
+    if (!zym_isMap(opt)) {
+        return true;
+    }
+    ZymValue fileVal = zym_mapGet(vm, opt, "file");
+    if (!zym_isString(fileVal)) {
+        return true;
+    }
+    ZymValue appendVal = zym_mapGet(vm, opt, "append");
+    bool append = zym_isBool(appendVal) && zym_asBool(appendVal);
+    *handle = CreateFileA(zym_asCString(fileVal),
+                          append ? FILE_APPEND_DATA : GENERIC_WRITE,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE, sa,
+                          append ? OPEN_ALWAYS : CREATE_ALWAYS,
+                          FILE_ATTRIBUTE_NORMAL, NULL);
+    if (*handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    *mode = STDIO_FILE;
+    return true;
+}
+
 static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal, ZymValue optionsMap) {
     size_t cmd_len = strlen(proc->command);
 
@@ -254,6 +495,12 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
     StdioMode stdout_mode = STDIO_PIPE;
     StdioMode stderr_mode = STDIO_PIPE;
     bool use_conpty = false;
+    HANDLE stdout_file = INVALID_HANDLE_VALUE, stderr_file = INVALID_HANDLE_VALUE;
+
+    SECURITY_ATTRIBUTES file_sa;
+    file_sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+    file_sa.bInheritHandle = TRUE;
+    file_sa.lpSecurityDescriptor = NULL;
 
     if (!zym_isNull(optionsMap) && zym_isMap(optionsMap)) {
         ZymValue stdinOpt = zym_mapGet(vm, optionsMap, "stdin");
@@ -270,6 +517,9 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
             if (strcmp(mode, "inherit") == 0) stdout_mode = STDIO_INHERIT;
             else if (strcmp(mode, "null") == 0) stdout_mode = STDIO_NULL;
             else if (strcmp(mode, "pty") == 0) { stdout_mode = STDIO_PTY; use_conpty = true; }
+        } else if (!spawn_stdio_target(vm, stdoutOpt, &stdout_mode, &stdout_file, &file_sa)) {
+            free(cmdline);
+            return false;
         }
 
         ZymValue stderrOpt = zym_mapGet(vm, optionsMap, "stderr");
@@ -278,11 +528,19 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
             if (strcmp(mode, "inherit") == 0) stderr_mode = STDIO_INHERIT;
             else if (strcmp(mode, "null") == 0) stderr_mode = STDIO_NULL;
             else if (strcmp(mode, "pty") == 0) { stderr_mode = STDIO_PTY; use_conpty = true; }
+        } else if (!spawn_stdio_target(vm, stderrOpt, &stderr_mode, &stderr_file, &file_sa)) {
+            if (stdout_file != INVALID_HANDLE_VALUE) CloseHandle(stdout_file);
+            free(cmdline);
+            return false;
         }
     }
 
     // ConPTY Mode (Windows 10+)
     if (use_conpty) {
+        // ConPTY owns all of the child's stdio
+        if (stdout_file != INVALID_HANDLE_VALUE) CloseHandle(stdout_file);
+        if (stderr_file != INVALID_HANDLE_VALUE) CloseHandle(stderr_file);
+
         HANDLE hPipeIn_Read = INVALID_HANDLE_VALUE, hPipeIn_Write = INVALID_HANDLE_VALUE;
         HANDLE hPipeOut_Read = INVALID_HANDLE_VALUE, hPipeOut_Write = INVALID_HANDLE_VALUE;
 
@@ -421,6 +679,8 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
         proc->stdout_open = true;
     } else if (stdout_mode == STDIO_NULL) {
         hStdoutWrite = CreateFileA("NUL", GENERIC_WRITE, 0, &sa, OPEN_EXISTING, 0, NULL);
+    } else if (stdout_mode == STDIO_FILE) {
+        hStdoutWrite = stdout_file;  // Closed with the other child-side handles
     }
 
     if (stderr_mode == STDIO_PIPE) {
@@ -430,6 +690,8 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
         proc->stderr_open = true;
     } else if (stderr_mode == STDIO_NULL) {
         hStderrWrite = CreateFileA("NUL", GENERIC_WRITE, 0, &sa, OPEN_EXISTING, 0, NULL);
+    } else if (stderr_mode == STDIO_FILE) {
+        hStderrWrite = stderr_file;
     }
 
     // Setup STARTUPINFO
@@ -504,11 +766,109 @@ static bool spawn_process_windows(ZymVM* vm, ProcessData* proc, ZymValue argsVal
 
 #else  // Unix implementation
 
+extern char** environ;
+
+// posix_spawn_file_actions_addchdir_np: glibc 2.29+, macOS 10.15+
+#if (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))) || \
+    (defined(__APPLE__) && defined(__MAC_OS_X_VERSION_MIN_REQUIRED) && __MAC_OS_X_VERSION_MIN_REQUIRED >= 101500)
+    #define PROCESS_HAVE_SPAWN_CHDIR 1
+#endif
+
+// Resolves a {file: path, append: bool} map or a raw descriptor number into
+// an fd the child's stdout/stderr is pointed at. Files are opened here and
+// owned by the caller; raw descriptors are borrowed and must be open.
+// Returns false if the file cannot be opened or the descriptor is invalid.
+static bool spawn_stdio_target(ZymVM* vm, ZymValue opt, StdioMode* mode, int* fd, bool* owned) {
+    if (zym_isNumber(opt)) {
+        if (!spawn_fd_number(opt, fd) || fcntl(*fd, F_GETFD) < 0) {
+            return false;
+        }
+        *owned = false;
+        *mode = STDIO_FILE;
+        return true;
+    }
+    if (!zym_isMap(opt)) {
+        return true;
+    }
+    ZymValue fileVal = zym_mapGet(vm, opt, "file");
+    if (!zym_isString(fileVal)) {
+        return true;
+    }
+    ZymValue appendVal = zym_mapGet(vm, opt, "append");
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    flags |= (zym_isBool(appendVal) && zym_asBool(appendVal)) ? O_APPEND : O_TRUNC;
+    *fd = open(zym_asCString(fileVal), flags, 0644);
+    if (*fd < 0) {
+        return false;
+    }
+    *owned = true;
+    *mode = STDIO_FILE;
+    return true;
+}
+
+static bool spawn_add_null(posix_spawn_file_actions_t* actions, int target, int flags) {
+    return posix_spawn_file_actions_addopen(actions, target, "/dev/null", flags, 0) == 0;
+}
+
+static bool spawn_add_pipe(posix_spawn_file_actions_t* actions, int pipe_fds[2], int child_end, int target) {
+    return posix_spawn_file_actions_adddup2(actions, pipe_fds[child_end], target) == 0 &&
+           posix_spawn_file_actions_addclose(actions, pipe_fds[0]) == 0 &&
+           posix_spawn_file_actions_addclose(actions, pipe_fds[1]) == 0;
+}
+
+// Returned by spawn_posix when the request needs something posix_spawn
+// can't express here, so the caller has to fork instead
+#define SPAWN_NEEDS_FORK (-1)
+
+// Starts the child with posix_spawnp, which glibc and macOS implement with
+// vfork-style semantics: the parent's page tables are never copied, so spawn
+// cost no longer grows with the VM heap. Returns 0 on success,
+// SPAWN_NEEDS_FORK, or the errno posix_spawnp failed with.
+static int spawn_posix(pid_t* pid, char** argv, const char* cwd,
+                       StdioMode stdin_mode, StdioMode stdout_mode, StdioMode stderr_mode,
+                       int stdin_pipe[2], int stdout_pipe[2], int stderr_pipe[2],
+                       int stdout_file, int stderr_file) {
+#ifndef PROCESS_HAVE_SPAWN_CHDIR
+    if (cwd) {
+        return SPAWN_NEEDS_FORK;
+    }
+#endif
+
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) != 0) {
+        return ENOMEM;
+    }
+
+    bool ok = true;
+    if (stdin_mode == STDIO_PIPE) ok = ok && spawn_add_pipe(&actions, stdin_pipe, 0, STDIN_FILENO);
+    else if (stdin_mode == STDIO_NULL) ok = ok && spawn_add_null(&actions, STDIN_FILENO, O_RDONLY);
+
+    if (stdout_mode == STDIO_PIPE) ok = ok && spawn_add_pipe(&actions, stdout_pipe, 1, STDOUT_FILENO);
+    else if (stdout_mode == STDIO_NULL) ok = ok && spawn_add_null(&actions, STDOUT_FILENO, O_WRONLY);
+    else if (stdout_mode == STDIO_FILE) ok = ok && posix_spawn_file_actions_adddup2(&actions, stdout_file, STDOUT_FILENO) == 0;
+
+    if (stderr_mode == STDIO_PIPE) ok = ok && spawn_add_pipe(&actions, stderr_pipe, 1, STDERR_FILENO);
+    else if (stderr_mode == STDIO_NULL) ok = ok && spawn_add_null(&actions, STDERR_FILENO, O_WRONLY);
+    else if (stderr_mode == STDIO_FILE) ok = ok && posix_spawn_file_actions_adddup2(&actions, stderr_file, STDERR_FILENO) == 0;
+
+#ifdef PROCESS_HAVE_SPAWN_CHDIR
+    if (ok && cwd) {
+        ok = posix_spawn_file_actions_addchdir_np(&actions, cwd) == 0;
+    }
+#endif
+
+    int result = ok ? posix_spawnp(pid, argv[0], &actions, NULL, argv, environ) : SPAWN_NEEDS_FORK;
+    posix_spawn_file_actions_destroy(&actions);
+    return result;
+}
+
 static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, ZymValue optionsMap) {
     StdioMode stdin_mode = STDIO_PIPE;
     StdioMode stdout_mode = STDIO_PIPE;
     StdioMode stderr_mode = STDIO_PIPE;
     bool use_pty = false;
+    int stdout_file = -1, stderr_file = -1;
+    bool stdout_owned = false, stderr_owned = false;
 
     if (!zym_isNull(optionsMap) && zym_isMap(optionsMap)) {
         ZymValue stdinOpt = zym_mapGet(vm, optionsMap, "stdin");
@@ -525,6 +885,8 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
             if (strcmp(mode, "inherit") == 0) stdout_mode = STDIO_INHERIT;
             else if (strcmp(mode, "null") == 0) stdout_mode = STDIO_NULL;
             else if (strcmp(mode, "pty") == 0) { stdout_mode = STDIO_PTY; use_pty = true; }
+        } else if (!spawn_stdio_target(vm, stdoutOpt, &stdout_mode, &stdout_file, &stdout_owned)) {
+            return false;
         }
 
         ZymValue stderrOpt = zym_mapGet(vm, optionsMap, "stderr");
@@ -533,9 +895,19 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
             if (strcmp(mode, "inherit") == 0) stderr_mode = STDIO_INHERIT;
             else if (strcmp(mode, "null") == 0) stderr_mode = STDIO_NULL;
             else if (strcmp(mode, "pty") == 0) { stderr_mode = STDIO_PTY; use_pty = true; }
+        } else if (!spawn_stdio_target(vm, stderrOpt, &stderr_mode, &stderr_file, &stderr_owned)) {
+            if (stdout_owned) close(stdout_file);
+            return false;
         }
     }
 
+    // The parent's copies of opened files are no longer needed once the
+    // child has been started (or failed to start)
+    #define CLOSE_STDIO_FILES() do { \
+        if (stdout_owned) close(stdout_file); \
+        if (stderr_owned) close(stderr_file); \
+    } while (0)
+
     int stdin_pipe[2] = {-1, -1};
     int stdout_pipe[2] = {-1, -1};
     int stderr_pipe[2] = {-1, -1};
@@ -544,24 +916,31 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
     if (use_pty) {
 #if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
         if (openpty(&pty_master, &pty_slave, NULL, NULL, NULL) < 0) {
+            CLOSE_STDIO_FILES();
             return false;
         }
         proc->pty_master = pty_master;
         proc->use_pty = true;
         set_nonblocking(pty_master);
 #else
+        CLOSE_STDIO_FILES();
         return false;  // PTY not supported on this platform
 #endif
     } else {
         // Create regular pipes
-        if (stdin_mode == STDIO_PIPE && pipe(stdin_pipe) < 0) return false;
+        if (stdin_mode == STDIO_PIPE && pipe(stdin_pipe) < 0) {
+            CLOSE_STDIO_FILES();
+            return false;
+        }
         if (stdout_mode == STDIO_PIPE && pipe(stdout_pipe) < 0) {
             if (stdin_pipe[0] >= 0) { close(stdin_pipe[0]); close(stdin_pipe[1]); }
+            CLOSE_STDIO_FILES();
             return false;
         }
         if (stderr_mode == STDIO_PIPE && pipe(stderr_pipe) < 0) {
             if (stdin_pipe[0] >= 0) { close(stdin_pipe[0]); close(stdin_pipe[1]); }
             if (stdout_pipe[0] >= 0) { close(stdout_pipe[0]); close(stdout_pipe[1]); }
+            CLOSE_STDIO_FILES();
             return false;
         }
     }
@@ -577,6 +956,7 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
         if (stdout_pipe[0] >= 0) { close(stdout_pipe[0]); close(stdout_pipe[1]); }
         if (stderr_pipe[0] >= 0) { close(stderr_pipe[0]); close(stderr_pipe[1]); }
         if (pty_master >= 0) { close(pty_master); close(pty_slave); }
+        CLOSE_STDIO_FILES();
         return false;
     }
 
@@ -594,16 +974,43 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
     }
     argv[arg_idx] = NULL;
 
-    pid_t pid = fork();
+    // PTY children need setsid() and a controlling terminal, which only a
+    // forked child can set up. Everything else goes through posix_spawn.
+    // When posix_spawnp reports that the program could not be executed
+    // (e.g. command not found) no child exists; the Process is recorded as
+    // having exited with 127, the same result a forked child gets when
+    // execvp fails. Any other error (no memory, too many processes or open
+    // files) is a failure to spawn.
+    pid_t pid = -1;
+    bool exec_failed = false;
+    int spawn_result = use_pty ? SPAWN_NEEDS_FORK
+                               : spawn_posix(&pid, argv, proc->cwd, stdin_mode, stdout_mode, stderr_mode,
+                                             stdin_pipe, stdout_pipe, stderr_pipe, stdout_file, stderr_file);
+    if (spawn_result == SPAWN_NEEDS_FORK) {
+        pid = fork();
+        if (pid < 0) proc->spawn_errno = errno;
+    } else if (spawn_result != 0) {
+        pid = -1;
+        switch (spawn_result) {
+            case ENOENT: case ENOTDIR: case ENAMETOOLONG: case ELOOP:
+            case EACCES: case EPERM: case ENOEXEC:
+                exec_failed = true;
+                break;
+            default:
+                proc->spawn_errno = spawn_result;
+                break;
+        }
+    }
 
-    if (pid < 0) {
-        // Fork failed
+    if (pid < 0 && !exec_failed) {
+        // Spawn or fork failed
         for (int i = 0; argv[i] != NULL; i++) free(argv[i]);
         free(argv);
         if (stdin_pipe[0] >= 0) { close(stdin_pipe[0]); close(stdin_pipe[1]); }
         if (stdout_pipe[0] >= 0) { close(stdout_pipe[0]); close(stdout_pipe[1]); }
         if (stderr_pipe[0] >= 0) { close(stderr_pipe[0]); close(stderr_pipe[1]); }
         if (pty_master >= 0) { close(pty_master); close(pty_slave); }
+        CLOSE_STDIO_FILES();
         return false;
     }
 
@@ -653,6 +1060,8 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
                 int null_fd = open("/dev/null", O_WRONLY);
                 dup2(null_fd, STDOUT_FILENO);
                 close(null_fd);
+            } else if (stdout_mode == STDIO_FILE) {
+                dup2(stdout_file, STDOUT_FILENO);
             }
 
             // Setup stderr
@@ -664,6 +1073,8 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
                 int null_fd = open("/dev/null", O_WRONLY);
                 dup2(null_fd, STDERR_FILENO);
                 close(null_fd);
+            } else if (stderr_mode == STDIO_FILE) {
+                dup2(stderr_file, STDERR_FILENO);
             }
         }
 
@@ -682,6 +1093,8 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
     // Parent process
     for (int i = 0; argv[i] != NULL; i++) free(argv[i]);
     free(argv);
+    CLOSE_STDIO_FILES();
+    #undef CLOSE_STDIO_FILES
 
     if (use_pty) {
         close(pty_slave);
@@ -715,6 +1128,14 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
         }
     }
 
+    if (exec_failed) {
+        proc->pid = -1;
+        proc->exit_code = 127;
+        proc->exit_code_valid = true;
+        proc->is_running = false;
+        return true;
+    }
+
     proc->pid = pid;
     proc->is_running = true;
 
@@ -723,139 +1144,919 @@ static bool spawn_process_unix(ZymVM* vm, ProcessData* proc, ZymValue argsVal, Z
 
 #endif
 
-ZymValue process_write(ZymVM* vm, ZymValue context, ZymValue dataVal) {
-    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+// ---- Exec waiting -------------------------------------------------------------
+// ProcessExec blocks until the child exits and its pipes drain. On Unix the
+// wait is a single poll() over the stdout/stderr pipes plus a pidfd (Linux
+// 5.3+), or a SIGCHLD self-pipe where pidfds are unavailable, so the exec
+// returns as soon as the child is done instead of on the next polling tick.
 
-    if (!proc->stdin_open) {
-        zym_runtimeError(vm, "Process stdin is not open");
-        return ZYM_ERROR;
-    }
+typedef struct {
+    char* data;
+    size_t length;          // Bytes captured (also counted for Buffer targets)
+    size_t capacity;
+    size_t limit;           // 0 = unlimited
+    bool truncated;
+    BufferData* buffer;     // When set, bytes are appended to this Buffer instead
+    ZymVM* vm;              // ...which grows on this VM's buffer quota
+} ExecCapture;
 
-    if (!zym_isString(dataVal)) {
-        zym_runtimeError(vm, "write() requires a string argument");
-        return ZYM_ERROR;
-    }
+typedef struct {
+    ProcessData* proc;
+    ExecCapture out;
+    ExecCapture err;
+    double deadline_ms;     // Monotonic; 0 = no timeout
+    bool timed_out;
+    bool exited;
+    bool finished;
+    bool only_sinks;        // Leave streams without a Buffer target untouched
+#ifdef _WIN32
+    struct MemoryQuota* quota;  // Adopted by the reader threads
+#else
+    int pidfd;
+    int sink_fd;            // When >= 0, stdout is written here
+    bool sink_capture;      // ...and also copied into `out`
+    bool sink_splice;
+    int tee_pipe[2];
+#endif
+} ExecWaiter;
 
-    const char* data = zym_asCString(dataVal);
-    size_t len = strlen(data);
+#define EXEC_READ_CHUNK 65536
+// Bytes drained from one pipe per wakeup, so a chatty child cannot starve
+// the others when several children share one loop
+#define EXEC_READ_BUDGET (1024 * 1024)
 
+static double process_now_ms(void) {
 #ifdef _WIN32
-    DWORD written;
-    if (!WriteFile(proc->hStdin, data, len, &written, NULL)) {
-        zym_runtimeError(vm, "Failed to write to process stdin");
-        return ZYM_ERROR;
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
     }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
 #else
-    ssize_t written = write(proc->stdin_fd, data, len);
-    if (written < 0) {
-        zym_runtimeError(vm, "Failed to write to process stdin: %s", strerror(errno));
-        return ZYM_ERROR;
-    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
 #endif
+}
 
-    return context;
+static void process_record_exit(ProcessData* proc, int exit_code) {
+    proc->exit_code = exit_code;
+    proc->is_running = false;
+    proc->exit_code_valid = true;
+    if (proc->started_ms > 0) {
+        proc->wall_ms = process_now_ms() - proc->started_ms;
+    }
 }
 
-ZymValue process_writeBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
-    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+#ifdef _WIN32
 
-    if (!proc->stdin_open) {
-        zym_runtimeError(vm, "Process stdin is not open");
-        return ZYM_ERROR;
-    }
+static double filetime_ms(const FILETIME* ft) {
+    ULARGE_INTEGER value;
+    value.LowPart = ft->dwLowDateTime;
+    value.HighPart = ft->dwHighDateTime;
+    return (double)value.QuadPart / 10000.0;  // 100ns units
+}
 
-    if (!zym_isMap(bufferVal)) {
-        zym_runtimeError(vm, "writeBuffer() requires a Buffer argument");
-        return ZYM_ERROR;
-    }
+// Records the exit code and usage of a process whose handle is signaled.
+static void process_collect_exit(ProcessData* proc) {
+    DWORD exitCode = 0;
+    GetExitCodeProcess(proc->hProcess, &exitCode);
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
-        zym_runtimeError(vm, "Invalid Buffer object");
-        return ZYM_ERROR;
-    }
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(proc->hProcess, &creation, &exit, &kernel, &user)) {
+        memset(&proc->usage, 0, sizeof(ProcessUsage));
+        proc->usage.user_ms = filetime_ms(&user);
+        proc->usage.system_ms = filetime_ms(&kernel);
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
-        return ZYM_ERROR;
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(proc->hProcess, &counters, sizeof(counters))) {
+            proc->usage.max_rss_bytes = (double)counters.PeakWorkingSetSize;
+            proc->usage.minor_faults = (double)counters.PageFaultCount;
+        }
+        proc->usage_valid = true;
     }
 
-    size_t bytes_to_write = buf->length - buf->position;
-    if (bytes_to_write == 0) {
-        return zym_newNumber(0);
-    }
+    process_record_exit(proc, (int)exitCode);
+}
 
-#ifdef _WIN32
-    DWORD written;
-    if (!WriteFile(proc->hStdin, buf->data + buf->position, bytes_to_write, &written, NULL)) {
-        zym_runtimeError(vm, "Failed to write buffer to process stdin");
-        return ZYM_ERROR;
-    }
 #else
-    ssize_t written = write(proc->stdin_fd, buf->data + buf->position, bytes_to_write);
-    if (written < 0) {
-        zym_runtimeError(vm, "Failed to write buffer to process stdin: %s", strerror(errno));
-        return ZYM_ERROR;
+
+static int process_status_code(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
     }
-#endif
+    return -1;
+}
 
-    buf->position += written;
-    return zym_newNumber((double)written);
+static double timeval_ms(const struct timeval* tv) {
+    return (double)tv->tv_sec * 1000.0 + (double)tv->tv_usec / 1000.0;
 }
 
-ZymValue process_closeStdin(ZymVM* vm, ZymValue context) {
-    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+// waitpid() that also captures the child's rusage. Returns as waitpid does;
+// on success the exit and usage are recorded on `proc`.
+static pid_t process_wait4(ProcessData* proc, int options) {
+    int status;
+    struct rusage ru;
+    pid_t result;
+    do {
+        result = wait4(proc->pid, &status, options, &ru);
+    } while (result < 0 && errno == EINTR);
+
+    if (result == proc->pid) {
+        proc->usage.user_ms = timeval_ms(&ru.ru_utime);
+        proc->usage.system_ms = timeval_ms(&ru.ru_stime);
+#ifdef __APPLE__
+        proc->usage.max_rss_bytes = (double)ru.ru_maxrss;
+#else
+        proc->usage.max_rss_bytes = (double)ru.ru_maxrss * 1024.0;
+#endif
+        proc->usage.minor_faults = (double)ru.ru_minflt;
+        proc->usage.major_faults = (double)ru.ru_majflt;
+        proc->usage.voluntary_switches = (double)ru.ru_nvcsw;
+        proc->usage.involuntary_switches = (double)ru.ru_nivcsw;
+        proc->usage_valid = true;
+        process_record_exit(proc, process_status_code(status));
+    } else if (result < 0 && errno == ECHILD) {
+        // Reaped elsewhere (e.g. SIGCHLD set to SIG_IGN); status is unknown
+        process_record_exit(proc, -1);
+    }
+    return result;
+}
 
-    if (!proc->stdin_open) {
-        return context;
+#endif
+
+static ZymValue process_usage_map(ZymVM* vm, ProcessData* proc) {
+    if (!proc->exit_code_valid) {
+        return zym_newNull();
     }
 
-#ifdef _WIN32
-    CloseHandle(proc->hStdin);
-    proc->hStdin = INVALID_HANDLE_VALUE;
-#else
-    if (!proc->use_pty) {
-        close(proc->stdin_fd);
-        proc->stdin_fd = -1;
+    ZymValue usage = zym_newMap(vm);
+    zym_pushRoot(vm, usage);
+
+    zym_mapSet(vm, usage, "wallMs", zym_newNumber(proc->wall_ms));
+    if (proc->usage_valid) {
+        zym_mapSet(vm, usage, "userMs", zym_newNumber(proc->usage.user_ms));
+        zym_mapSet(vm, usage, "systemMs", zym_newNumber(proc->usage.system_ms));
+        zym_mapSet(vm, usage, "maxRssBytes", zym_newNumber(proc->usage.max_rss_bytes));
+        zym_mapSet(vm, usage, "minorFaults", zym_newNumber(proc->usage.minor_faults));
+        zym_mapSet(vm, usage, "majorFaults", zym_newNumber(proc->usage.major_faults));
+        zym_mapSet(vm, usage, "voluntarySwitches", zym_newNumber(proc->usage.voluntary_switches));
+        zym_mapSet(vm, usage, "involuntarySwitches", zym_newNumber(proc->usage.involuntary_switches));
     }
-#endif
 
-    proc->stdin_open = false;
-    return context;
+    zym_popRoot(vm);
+    return usage;
 }
 
-ZymValue process_read(ZymVM* vm, ZymValue context) {
-    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+static bool exec_capture_full(const ExecCapture* cap) {
+    return cap->limit > 0 && cap->length >= cap->limit;
+}
 
-    if (!proc->stdout_open) {
-        return zym_newString(vm, "");
+static bool exec_capture_ready(const ExecCapture* cap) {
+    return cap->data != NULL || cap->buffer != NULL;
+}
+
+// Makes room for the next read of up to *extra bytes and returns where it
+// should land, or NULL when nothing more fits. *extra may shrink when the
+// target Buffer cannot grow that far. String captures stay NUL-terminated.
+static char* exec_capture_reserve(ExecCapture* cap, size_t* extra) {
+    BufferData* buf = cap->buffer;
+    if (!buf) {
+        if (!ensure_buffer_capacity(&cap->data, &cap->capacity, cap->length + *extra + 1)) {
+            return NULL;
+        }
+        return cap->data + cap->length;
     }
 
-    char buffer[4096];
+    // The script may have shared or transferred the Buffer since spawn
+    size_t room = buffer_try_reserve(cap->vm, buf, *extra);
+    if (room == 0) {
+        return NULL;
+    }
+    *extra = room;
+    return (char*)buf->data + buf->position;
+}
 
-#ifdef _WIN32
-    // Check if data is available before reading (non-blocking)
-    DWORD bytesAvail = 0;
-    if (!PeekNamedPipe(proc->hStdout, NULL, 0, NULL, &bytesAvail, NULL)) {
-        return zym_newString(vm, "");
+static void exec_capture_commit(ExecCapture* cap, size_t n) {
+    if (cap->limit > 0 && cap->length + n > cap->limit) {
+        n = cap->limit - cap->length;
+        cap->truncated = true;
     }
+    cap->length += n;
 
-    if (bytesAvail == 0) {
-        return zym_newString(vm, "");
+    BufferData* buf = cap->buffer;
+    if (buf) {
+        buf->position += n;
+        if (buf->position > buf->length) {
+            buf->length = buf->position;
+        }
+    } else {
+        cap->data[cap->length] = '\0';
     }
+}
 
-    DWORD bytesRead;
-    DWORD toRead = (bytesAvail < sizeof(buffer) - 1) ? bytesAvail : sizeof(buffer) - 1;
-    if (!ReadFile(proc->hStdout, buffer, toRead, &bytesRead, NULL)) {
-        return zym_newString(vm, "");
+// Appends bytes that were read elsewhere.
+static void exec_capture_append(ExecCapture* cap, const char* bytes, size_t n) {
+    while (n > 0) {
+        size_t chunk = n;
+        char* target = exec_capture_full(cap) ? NULL : exec_capture_reserve(cap, &chunk);
+        if (!target) {
+            cap->truncated = true;
+            return;
+        }
+        memcpy(target, bytes, chunk);
+        exec_capture_commit(cap, chunk);
+        bytes += chunk;
+        n -= chunk;
     }
-    buffer[bytesRead] = '\0';
-#else
-    ssize_t bytesRead = read(proc->stdout_fd, buffer, sizeof(buffer) - 1);
-    if (bytesRead < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+}
+
+static void exec_waiter_init(ZymVM* vm, ExecWaiter* waiter, ProcessData* proc, long timeout_ms, size_t max_output) {
+    memset(waiter, 0, sizeof(ExecWaiter));
+    waiter->proc = proc;
+    waiter->out.limit = max_output;
+    waiter->err.limit = max_output;
+    waiter->out.buffer = proc->stdout_sink;
+    waiter->err.buffer = proc->stderr_sink;
+    waiter->out.vm = vm;
+    waiter->err.vm = vm;
+    size_t none = 0;
+    if (!waiter->out.buffer && exec_capture_reserve(&waiter->out, &none)) waiter->out.data[0] = '\0';
+    if (!waiter->err.buffer && exec_capture_reserve(&waiter->err, &none)) waiter->err.data[0] = '\0';
+    if (timeout_ms > 0) {
+        waiter->deadline_ms = process_now_ms() + (double)timeout_ms;
+    }
+    waiter->exited = !proc->is_running;
+
+#ifdef _WIN32
+    waiter->quota = zymvm_quota_current();
+#else
+    waiter->pidfd = -1;
+    waiter->sink_fd = -1;
+    waiter->tee_pipe[0] = -1;
+    waiter->tee_pipe[1] = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    if (!waiter->exited) {
+        waiter->pidfd = (int)syscall(SYS_pidfd_open, proc->pid, 0);
+    }
+#endif
+#endif
+}
+
+static void exec_waiter_free(ExecWaiter* waiter) {
+    free(waiter->out.data);
+    free(waiter->err.data);
+    waiter->out.data = NULL;
+    waiter->err.data = NULL;
+#ifndef _WIN32
+    if (waiter->pidfd >= 0) {
+        close(waiter->pidfd);
+        waiter->pidfd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (waiter->tee_pipe[i] >= 0) {
+            close(waiter->tee_pipe[i]);
+            waiter->tee_pipe[i] = -1;
+        }
+    }
+#endif
+}
+
+// Whether the waiter reads this stream: process.wait() only drains streams
+// that feed a Buffer, so read()/readErr() keep working on the others.
+static bool exec_waiter_owns(const ExecWaiter* waiter, const ExecCapture* cap) {
+    return !waiter->only_sinks || cap->buffer != NULL;
+}
+
+#ifndef _WIN32
+
+// Waiters without a pidfd sleep on a SIGCHLD self-pipe. Each waiting
+// thread borrows its own pipe from a small pool for the duration of one
+// wait step and the handler writes to all of them, so one thread draining
+// its wakeup can't swallow another's. Pipes are never closed once created,
+// so the handler can't write into a recycled descriptor.
+
+#define SIGCHLD_SLOTS 32
+
+static Mutex sigchld_lock = MUTEX_INITIALIZER;
+static bool sigchld_installed = false;
+static struct sigaction sigchld_previous;
+static int sigchld_read_fd[SIGCHLD_SLOTS];
+static int sigchld_write_fd[SIGCHLD_SLOTS];
+static bool sigchld_busy[SIGCHLD_SLOTS];
+static atomic_int sigchld_slot_count = 0;   // published after the slot's fds are set
+
+static void sigchld_handler(int sig, siginfo_t* info, void* ucontext) {
+    int saved_errno = errno;
+    int slots = atomic_load_explicit(&sigchld_slot_count, memory_order_acquire);
+    for (int i = 0; i < slots; i++) {
+        char byte = 0;
+        if (write(sigchld_write_fd[i], &byte, 1) < 0) {
+            // Pipe full: a wakeup is already pending
+        }
+    }
+    errno = saved_errno;
+
+    if ((sigchld_previous.sa_flags & SA_SIGINFO) && sigchld_previous.sa_sigaction) {
+        sigchld_previous.sa_sigaction(sig, info, ucontext);
+    } else if (!(sigchld_previous.sa_flags & SA_SIGINFO) &&
+               sigchld_previous.sa_handler != SIG_DFL && sigchld_previous.sa_handler != SIG_IGN) {
+        sigchld_previous.sa_handler(sig);
+    }
+}
+
+// Borrows a wakeup pipe, installing the handler on first use. Any handler
+// that was already in place keeps being called. Returns the slot, or -1 if
+// none is available (the caller then falls back to a short poll tick).
+static int sigchld_acquire(void) {
+    int slot = -1;
+    mutex_lock(&sigchld_lock);
+
+    int slots = atomic_load_explicit(&sigchld_slot_count, memory_order_relaxed);
+    for (int i = 0; i < slots; i++) {
+        if (!sigchld_busy[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0 && slots < SIGCHLD_SLOTS) {
+        int fds[2];
+        if (pipe(fds) == 0) {
+            for (int i = 0; i < 2; i++) {
+                set_nonblocking(fds[i]);
+                fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+            }
+            sigchld_read_fd[slots] = fds[0];
+            sigchld_write_fd[slots] = fds[1];
+            atomic_store_explicit(&sigchld_slot_count, slots + 1, memory_order_release);
+            slot = slots;
+        }
+    }
+
+    if (slot >= 0 && !sigchld_installed) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = sigchld_handler;
+        action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGCHLD, &action, &sigchld_previous) == 0) {
+            sigchld_installed = true;
+        } else {
+            slot = -1;
+        }
+    }
+
+    if (slot >= 0) {
+        sigchld_busy[slot] = true;
+        // Discard wakeups left over from before this wait
+        char drain[64];
+        while (read(sigchld_read_fd[slot], drain, sizeof(drain)) > 0) {}
+    }
+    mutex_unlock(&sigchld_lock);
+    return slot;
+}
+
+static void sigchld_release(int slot) {
+    if (slot < 0) {
+        return;
+    }
+    mutex_lock(&sigchld_lock);
+    sigchld_busy[slot] = false;
+    mutex_unlock(&sigchld_lock);
+}
+
+static void exec_close_fd(ProcessData* proc, int* fd, bool* open_flag) {
+    if (*open_flag && *fd >= 0) {
+        close(*fd);
+        // In PTY mode stdout is the master itself; don't let cleanup close it again
+        if (*fd == proc->pty_master) {
+            proc->pty_master = -1;
+        }
+    }
+    *fd = -1;
+    *open_flag = false;
+}
+
+// Reads until the pipe would block. Returns false once the pipe has closed
+// (EOF, or EIO from a PTY whose child has gone).
+static bool exec_drain_fd(int fd, ExecCapture* cap) {
+    char discard[EXEC_READ_CHUNK];
+    size_t budget = EXEC_READ_BUDGET;
+
+    while (budget > 0) {
+        size_t chunk = EXEC_READ_CHUNK;
+        char* target = exec_capture_full(cap) ? NULL : exec_capture_reserve(cap, &chunk);
+        ssize_t n = read(fd, target ? target : discard, target ? chunk : EXEC_READ_CHUNK);
+        if (n > 0) {
+            if (target) {
+                exec_capture_commit(cap, (size_t)n);
+            } else {
+                cap->truncated = true;
+            }
+            budget -= (size_t)n < budget ? (size_t)n : budget;
+            continue;
+        }
+        if (n == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+static bool process_pipe_cloexec(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) < 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+static bool exec_write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// Routes the child's stdout to `fd` (not owned by the waiter). Regular files
+// and pipes take the splice() path on Linux; anything else is copied.
+static void exec_waiter_set_sink(ExecWaiter* waiter, int fd, bool capture) {
+    waiter->sink_fd = fd;
+    waiter->sink_capture = capture;
+    waiter->sink_splice = false;
+
+#ifdef __linux__
+    struct stat st;
+    int flags = fcntl(fd, F_GETFL);
+    if (fstat(fd, &st) == 0 && flags >= 0 &&
+        ((S_ISREG(st.st_mode) && !(flags & O_APPEND)) || S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode))) {
+        waiter->sink_splice = !capture || process_pipe_cloexec(waiter->tee_pipe);
+    }
+#endif
+}
+
+// Moves whatever the pipe holds into the sink. With splice() the bytes
+// never enter user space; when a copy is wanted too, tee() first duplicates
+// them into a private pipe which is then read into the capture. Returns
+// false once the pipe has closed.
+static bool exec_sink_fd(ExecWaiter* waiter, int fd) {
+    ExecCapture* cap = &waiter->out;
+    size_t budget = EXEC_READ_BUDGET;
+
+#ifdef __linux__
+    while (waiter->sink_splice && budget > 0) {
+        bool copy = waiter->sink_capture && !exec_capture_full(cap);
+        ssize_t n = copy ? tee(fd, waiter->tee_pipe[1], EXEC_READ_CHUNK, SPLICE_F_NONBLOCK)
+                         : splice(fd, NULL, waiter->sink_fd, NULL, EXEC_READ_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) return true;
+            if (errno == EINVAL || errno == ENOSYS) {
+                waiter->sink_splice = false;
+                break;
+            }
+            return false;
+        }
+        if (waiter->sink_capture && !copy) {
+            cap->truncated = true;
+        }
+
+        if (copy) {
+            // tee() only peeked: move the same bytes on, then collect the copy
+            size_t moved = 0;
+            while (moved < (size_t)n) {
+                ssize_t m = splice(fd, NULL, waiter->sink_fd, NULL, (size_t)n - moved, SPLICE_F_MOVE);
+                if (m < 0 && errno == EINTR) continue;
+                if (m <= 0) {
+                    char scratch[EXEC_READ_CHUNK];
+                    ssize_t r = read(fd, scratch, (size_t)n - moved);
+                    if (r <= 0 || !exec_write_all(waiter->sink_fd, scratch, (size_t)r)) return false;
+                    m = r;
+                    waiter->sink_splice = false;
+                }
+                moved += (size_t)m;
+            }
+
+            size_t copied = 0;
+            while (copied < (size_t)n) {
+                char scratch[EXEC_READ_CHUNK];
+                ssize_t r = read(waiter->tee_pipe[0], scratch, (size_t)n - copied);
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) break;
+                exec_capture_append(cap, scratch, (size_t)r);
+                copied += (size_t)r;
+            }
+        }
+        budget -= (size_t)n < budget ? (size_t)n : budget;
+    }
+#endif
+
+    while (budget > 0) {
+        char scratch[EXEC_READ_CHUNK];
+        ssize_t n = read(fd, scratch, sizeof(scratch));
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (!exec_write_all(waiter->sink_fd, scratch, (size_t)n)) {
+            return false;
+        }
+        if (waiter->sink_capture) {
+            exec_capture_append(cap, scratch, (size_t)n);
+        }
+        budget -= (size_t)n < budget ? (size_t)n : budget;
+    }
+    return true;
+}
+
+static void exec_waiter_drain(ExecWaiter* waiter) {
+    ProcessData* proc = waiter->proc;
+    if (proc->stdout_open && exec_waiter_owns(waiter, &waiter->out) &&
+        !(waiter->sink_fd >= 0 ? exec_sink_fd(waiter, proc->stdout_fd)
+                               : exec_drain_fd(proc->stdout_fd, &waiter->out))) {
+        exec_close_fd(proc, &proc->stdout_fd, &proc->stdout_open);
+    }
+    if (proc->stderr_open && exec_waiter_owns(waiter, &waiter->err) &&
+        !exec_drain_fd(proc->stderr_fd, &waiter->err)) {
+        exec_close_fd(proc, &proc->stderr_fd, &proc->stderr_open);
+    }
+}
+
+static void exec_waiter_check_exit(ExecWaiter* waiter) {
+    if (waiter->exited) {
+        return;
+    }
+
+    process_wait4(waiter->proc, WNOHANG);
+    waiter->exited = !waiter->proc->is_running;
+}
+
+// Once the child has exited, whatever it wrote is already in the pipes, so
+// a final non-blocking drain completes the waiter. Pipes still held open by
+// grandchildren are abandoned rather than waited on.
+static void exec_waiter_finish(ExecWaiter* waiter) {
+    ProcessData* proc = waiter->proc;
+    exec_waiter_drain(waiter);
+    if (exec_waiter_owns(waiter, &waiter->out)) exec_close_fd(proc, &proc->stdout_fd, &proc->stdout_open);
+    if (exec_waiter_owns(waiter, &waiter->err)) exec_close_fd(proc, &proc->stderr_fd, &proc->stderr_open);
+    if (waiter->pidfd >= 0) {
+        close(waiter->pidfd);
+        waiter->pidfd = -1;
+    }
+    waiter->finished = true;
+}
+
+// Runs one round of the event loop over every unfinished waiter: blocks in
+// poll() until a pipe is readable, a child exits or the nearest deadline
+// passes (capped at max_wait_ms when that is >= 0). Returns the number of
+// waiters that finished during this round.
+static int exec_wait_step(ExecWaiter* waiters, int count, long max_wait_ms) {
+    int finished = 0;
+    bool need_sigchld = false;
+    double now = process_now_ms();
+    double nearest = -1;
+
+    // The wakeup pipe must be in place before the exit checks below, or a
+    // child exiting in between would leave poll() with nothing to wake it
+    for (int i = 0; i < count; i++) {
+        if (!waiters[i].finished && !waiters[i].exited && waiters[i].pidfd < 0) need_sigchld = true;
+    }
+    int sigchld_slot = need_sigchld ? sigchld_acquire() : -1;
+
+    for (int i = 0; i < count; i++) {
+        ExecWaiter* waiter = &waiters[i];
+        if (waiter->finished) continue;
+
+        exec_waiter_check_exit(waiter);
+        if (!waiter->exited && waiter->deadline_ms > 0 && now >= waiter->deadline_ms && !waiter->timed_out) {
+            kill(waiter->proc->pid, SIGKILL);
+            waiter->timed_out = true;
+        }
+        if (waiter->exited) {
+            exec_waiter_finish(waiter);
+            finished++;
+            continue;
+        }
+
+        if (waiter->deadline_ms > 0 && !waiter->timed_out && (nearest < 0 || waiter->deadline_ms < nearest)) {
+            nearest = waiter->deadline_ms;
+        }
+    }
+    if (finished > 0) {
+        sigchld_release(sigchld_slot);
+        return finished;
+    }
+
+    int capacity = count * 3 + 1;
+    struct pollfd stack_fds[64];
+    struct pollfd* fds = capacity <= 64 ? stack_fds : malloc(sizeof(struct pollfd) * (size_t)capacity);
+    if (!fds) {
+        sigchld_release(sigchld_slot);
+        return 0;
+    }
+
+    int nfds = 0;
+    int wakeup_fd = sigchld_slot >= 0 ? sigchld_read_fd[sigchld_slot] : -1;
+    if (wakeup_fd >= 0) {
+        fds[nfds].fd = wakeup_fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    for (int i = 0; i < count; i++) {
+        ExecWaiter* waiter = &waiters[i];
+        if (waiter->finished) continue;
+        ProcessData* proc = waiter->proc;
+        if (proc->stdout_open && exec_waiter_owns(waiter, &waiter->out)) {
+            fds[nfds].fd = proc->stdout_fd; fds[nfds].events = POLLIN; nfds++;
+        }
+        if (proc->stderr_open && exec_waiter_owns(waiter, &waiter->err)) {
+            fds[nfds].fd = proc->stderr_fd; fds[nfds].events = POLLIN; nfds++;
+        }
+        if (waiter->pidfd >= 0) { fds[nfds].fd = waiter->pidfd; fds[nfds].events = POLLIN; nfds++; }
+    }
+
+    int timeout = -1;
+    if (nearest > 0) {
+        double remaining = nearest - now;
+        timeout = remaining <= 0 ? 0 : (int)(remaining + 1);
+    }
+    if (max_wait_ms >= 0 && (timeout < 0 || timeout > max_wait_ms)) {
+        timeout = (int)max_wait_ms;
+    }
+    // Without a pidfd or the SIGCHLD pipe there is nothing to wake us on exit
+    if (need_sigchld && wakeup_fd < 0 && (timeout < 0 || timeout > 10)) {
+        timeout = 10;
+    }
+
+    int ready = poll(fds, (nfds_t)nfds, timeout);
+
+    if (ready > 0) {
+        if (wakeup_fd >= 0 && fds[0].revents) {
+            char drain[64];
+            while (read(wakeup_fd, drain, sizeof(drain)) > 0) {}
+        }
+        for (int i = 0; i < count; i++) {
+            if (!waiters[i].finished) exec_waiter_drain(&waiters[i]);
+        }
+    }
+
+    if (fds != stack_fds) {
+        free(fds);
+    }
+    sigchld_release(sigchld_slot);
+
+    for (int i = 0; i < count; i++) {
+        ExecWaiter* waiter = &waiters[i];
+        if (waiter->finished) continue;
+        exec_waiter_check_exit(waiter);
+        if (waiter->exited) {
+            exec_waiter_finish(waiter);
+            finished++;
+        }
+    }
+    return finished;
+}
+
+#else  // Windows: blocking reader threads plus a process-handle wait
+
+typedef struct {
+    HANDLE pipe;
+    ExecCapture* cap;
+    struct MemoryQuota* quota;
+} ExecReader;
+
+static void exec_reader_thread(void* arg) {
+    ExecReader* reader = (ExecReader*)arg;
+    char discard[EXEC_READ_CHUNK];
+    struct MemoryQuota* outer = zymvm_quota_adopt(reader->quota);
+
+    for (;;) {
+        size_t chunk = EXEC_READ_CHUNK;
+        char* target = exec_capture_full(reader->cap) ? NULL : exec_capture_reserve(reader->cap, &chunk);
+        DWORD n = 0;
+        if (!ReadFile(reader->pipe, target ? target : discard, target ? (DWORD)chunk : EXEC_READ_CHUNK, &n, NULL) || n == 0) {
+            break;
+        }
+        if (target) {
+            exec_capture_commit(reader->cap, n);
+        } else {
+            reader->cap->truncated = true;
+        }
+    }
+    zymvm_quota_restore(outer);
+}
+
+static void exec_close_handle(HANDLE* handle, bool* open_flag) {
+    if (*open_flag && *handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(*handle);
+    }
+    *handle = INVALID_HANDLE_VALUE;
+    *open_flag = false;
+}
+
+static void exec_waiter_run(ExecWaiter* waiter) {
+    ProcessData* proc = waiter->proc;
+    ExecReader readers[2];
+    ThreadHandle threads[2];
+    int thread_count = 0;
+
+    if (proc->stdout_open && exec_waiter_owns(waiter, &waiter->out)) {
+        readers[thread_count].pipe = proc->hStdout;
+        readers[thread_count].cap = &waiter->out;
+        readers[thread_count].quota = waiter->quota;
+        if (thread_start(&threads[thread_count], exec_reader_thread, &readers[thread_count])) thread_count++;
+    }
+    if (proc->stderr_open && exec_waiter_owns(waiter, &waiter->err)) {
+        readers[thread_count].pipe = proc->hStderr;
+        readers[thread_count].cap = &waiter->err;
+        readers[thread_count].quota = waiter->quota;
+        if (thread_start(&threads[thread_count], exec_reader_thread, &readers[thread_count])) thread_count++;
+    }
+
+    if (!waiter->exited) {
+        DWORD wait_ms = INFINITE;
+        if (waiter->deadline_ms > 0) {
+            double remaining = waiter->deadline_ms - process_now_ms();
+            wait_ms = remaining <= 0 ? 0 : (DWORD)remaining;
+        }
+        if (WaitForSingleObject(proc->hProcess, wait_ms) == WAIT_TIMEOUT) {
+            TerminateProcess(proc->hProcess, 1);
+            WaitForSingleObject(proc->hProcess, INFINITE);
+            waiter->timed_out = true;
+        }
+        process_collect_exit(proc);
+        waiter->exited = true;
+    }
+
+    // The child is gone; give the readers a moment to see EOF, then cancel
+    // reads on pipes that grandchildren (or a ConPTY) still hold open
+    for (int i = 0; i < thread_count; i++) {
+        if (WaitForSingleObject(threads[i], 100) == WAIT_TIMEOUT) {
+            CancelSynchronousIo(threads[i]);
+        }
+        thread_join(threads[i]);
+    }
+
+    if (exec_waiter_owns(waiter, &waiter->out)) exec_close_handle(&proc->hStdout, &proc->stdout_open);
+    if (exec_waiter_owns(waiter, &waiter->err)) exec_close_handle(&proc->hStderr, &proc->stderr_open);
+    waiter->finished = true;
+}
+
+#endif
+
+ZymValue process_write(ZymVM* vm, ZymValue context, ZymValue dataVal) {
+    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+
+    if (!proc->stdin_open) {
+        zym_runtimeError(vm, "Process stdin is not open");
+        return ZYM_ERROR;
+    }
+
+    if (!zym_isString(dataVal)) {
+        zym_runtimeError(vm, "write() requires a string argument");
+        return ZYM_ERROR;
+    }
+
+    const char* data = zym_asCString(dataVal);
+    size_t len = strlen(data);
+
+#ifdef _WIN32
+    DWORD written;
+    if (!WriteFile(proc->hStdin, data, len, &written, NULL)) {
+        zym_runtimeError(vm, "Failed to write to process stdin");
+        return ZYM_ERROR;
+    }
+#else
+    ssize_t written = write(proc->stdin_fd, data, len);
+    if (written < 0) {
+        zym_runtimeError(vm, "Failed to write to process stdin: %s", strerror(errno));
+        return ZYM_ERROR;
+    }
+#endif
+
+    return context;
+}
+
+ZymValue process_writeBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
+    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+
+    if (!proc->stdin_open) {
+        zym_runtimeError(vm, "Process stdin is not open");
+        return ZYM_ERROR;
+    }
+
+    if (!zym_isMap(bufferVal)) {
+        zym_runtimeError(vm, "writeBuffer() requires a Buffer argument");
+        return ZYM_ERROR;
+    }
+
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
+        zym_runtimeError(vm, "Invalid Buffer object");
+        return ZYM_ERROR;
+    }
+
+    if (!buffer_check_readable(vm, buf)) {
+        return ZYM_ERROR;
+    }
+
+    size_t bytes_to_write = buf->length - buf->position;
+    if (bytes_to_write == 0) {
+        return zym_newNumber(0);
+    }
+
+#ifdef _WIN32
+    DWORD written;
+    if (!WriteFile(proc->hStdin, buf->data + buf->position, bytes_to_write, &written, NULL)) {
+        zym_runtimeError(vm, "Failed to write buffer to process stdin");
+        return ZYM_ERROR;
+    }
+#else
+    ssize_t written = write(proc->stdin_fd, buf->data + buf->position, bytes_to_write);
+    if (written < 0) {
+        zym_runtimeError(vm, "Failed to write buffer to process stdin: %s", strerror(errno));
+        return ZYM_ERROR;
+    }
+#endif
+
+    buf->position += written;
+    return zym_newNumber((double)written);
+}
+
+ZymValue process_closeStdin(ZymVM* vm, ZymValue context) {
+    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+
+    if (!proc->stdin_open) {
+        return context;
+    }
+
+#ifdef _WIN32
+    CloseHandle(proc->hStdin);
+    proc->hStdin = INVALID_HANDLE_VALUE;
+#else
+    if (!proc->use_pty) {
+        close(proc->stdin_fd);
+        proc->stdin_fd = -1;
+    }
+#endif
+
+    proc->stdin_open = false;
+    return context;
+}
+
+ZymValue process_read(ZymVM* vm, ZymValue context) {
+    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+
+    if (!proc->stdout_open) {
+        return zym_newString(vm, "");
+    }
+
+    char* buffer = proc->read_buffer;
+
+#ifdef _WIN32
+    // Check if data is available before reading (non-blocking)
+    DWORD bytesAvail = 0;
+    if (!PeekNamedPipe(proc->hStdout, NULL, 0, NULL, &bytesAvail, NULL)) {
+        return zym_newString(vm, "");
+    }
+
+    if (bytesAvail == 0) {
+        return zym_newString(vm, "");
+    }
+
+    DWORD bytesRead;
+    DWORD toRead = (bytesAvail < proc->read_size) ? bytesAvail : (DWORD)proc->read_size;
+    if (!ReadFile(proc->hStdout, buffer, toRead, &bytesRead, NULL)) {
+        return zym_newString(vm, "");
+    }
+    buffer[bytesRead] = '\0';
+#else
+    ssize_t bytesRead = read(proc->stdout_fd, buffer, proc->read_size);
+    if (bytesRead < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
             return zym_newString(vm, "");
         }
         zym_runtimeError(vm, "Failed to read from process stdout: %s", strerror(errno));
@@ -874,7 +2075,7 @@ ZymValue process_readErr(ZymVM* vm, ZymValue context) {
         return zym_newString(vm, "");
     }
 
-    char buffer[4096];
+    char* buffer = proc->read_buffer;
 
 #ifdef _WIN32
     // Check if data is available before reading (non-blocking)
@@ -888,13 +2089,13 @@ ZymValue process_readErr(ZymVM* vm, ZymValue context) {
     }
 
     DWORD bytesRead;
-    DWORD toRead = (bytesAvail < sizeof(buffer) - 1) ? bytesAvail : sizeof(buffer) - 1;
+    DWORD toRead = (bytesAvail < proc->read_size) ? bytesAvail : (DWORD)proc->read_size;
     if (!ReadFile(proc->hStderr, buffer, toRead, &bytesRead, NULL)) {
         return zym_newString(vm, "");
     }
     buffer[bytesRead] = '\0';
 #else
-    ssize_t bytesRead = read(proc->stderr_fd, buffer, sizeof(buffer) - 1);
+    ssize_t bytesRead = read(proc->stderr_fd, buffer, proc->read_size);
     if (bytesRead < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             return zym_newString(vm, "");
@@ -947,8 +2148,8 @@ ZymValue process_readNonBlock(ZymVM* vm, ZymValue context) {
         return zym_newString(vm, "");
     }
 
-    char buffer[4096];
-    ssize_t bytesRead = read(proc->stdout_fd, buffer, sizeof(buffer) - 1);
+    char* buffer = proc->read_buffer;
+    ssize_t bytesRead = read(proc->stdout_fd, buffer, proc->read_size);
     if (bytesRead <= 0) {
         return zym_newString(vm, "");
     }
@@ -970,16 +2171,13 @@ ZymValue process_readToBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Invalid Buffer object");
         return ZYM_ERROR;
     }
 
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_writable(vm, buf)) {
         return ZYM_ERROR;
     }
 
@@ -1066,31 +2264,35 @@ ZymValue process_kill(ZymVM* vm, ZymValue context, ZymValue signalVal) {
 ZymValue process_wait(ZymVM* vm, ZymValue context) {
     ProcessData* proc = (ProcessData*)zym_getNativeData(context);
 
+    // Streams feeding a Buffer are drained while waiting, otherwise a child
+    // writing more than a pipe holds would never exit
+    if ((proc->stdout_sink && proc->stdout_open) || (proc->stderr_sink && proc->stderr_open)) {
+        ExecWaiter waiter;
+        exec_waiter_init(vm, &waiter, proc, 0, 0);
+        waiter.only_sinks = true;
+#ifdef _WIN32
+        exec_waiter_run(&waiter);
+#else
+        while (!waiter.finished) {
+            exec_wait_step(&waiter, 1, -1);
+        }
+#endif
+        exec_waiter_free(&waiter);
+    }
+
     if (!proc->is_running) {
         return zym_newNumber((double)proc->exit_code);
     }
 
 #ifdef _WIN32
     WaitForSingleObject(proc->hProcess, INFINITE);
-    DWORD exitCode;
-    GetExitCodeProcess(proc->hProcess, &exitCode);
-    proc->exit_code = (int)exitCode;
+    process_collect_exit(proc);
 #else
-    int status;
-    waitpid(proc->pid, &status, 0);
-
-    if (WIFEXITED(status)) {
-        proc->exit_code = WEXITSTATUS(status);
-    } else if (WIFSIGNALED(status)) {
-        proc->exit_code = 128 + WTERMSIG(status);
-    } else {
-        proc->exit_code = -1;
+    if (process_wait4(proc, 0) < 0 && proc->is_running) {
+        process_record_exit(proc, -1);
     }
 #endif
 
-    proc->is_running = false;
-    proc->exit_code_valid = true;
-
     return zym_newNumber((double)proc->exit_code);
 }
 
@@ -1107,27 +2309,11 @@ ZymValue process_poll(ZymVM* vm, ZymValue context) {
 #ifdef _WIN32
     DWORD result = WaitForSingleObject(proc->hProcess, 0);
     if (result == WAIT_OBJECT_0) {
-        DWORD exitCode;
-        GetExitCodeProcess(proc->hProcess, &exitCode);
-        proc->exit_code = (int)exitCode;
-        proc->is_running = false;
-        proc->exit_code_valid = true;
+        process_collect_exit(proc);
         return zym_newNumber((double)proc->exit_code);
     }
 #else
-    int status;
-    pid_t result = waitpid(proc->pid, &status, WNOHANG);
-
-    if (result > 0) {
-        if (WIFEXITED(status)) {
-            proc->exit_code = WEXITSTATUS(status);
-        } else if (WIFSIGNALED(status)) {
-            proc->exit_code = 128 + WTERMSIG(status);
-        } else {
-            proc->exit_code = -1;
-        }
-        proc->is_running = false;
-        proc->exit_code_valid = true;
+    if (process_wait4(proc, WNOHANG) > 0) {
         return zym_newNumber((double)proc->exit_code);
     }
 #endif
@@ -1156,6 +2342,11 @@ ZymValue process_getPid(ZymVM* vm, ZymValue context) {
 #endif
 }
 
+ZymValue process_getUsage(ZymVM* vm, ZymValue context) {
+    ProcessData* proc = (ProcessData*)zym_getNativeData(context);
+    return process_usage_map(vm, proc);
+}
+
 ZymValue process_getExitCode(ZymVM* vm, ZymValue context) {
     ProcessData* proc = (ProcessData*)zym_getNativeData(context);
 
@@ -1182,6 +2373,7 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
     }
 
     proc->command = strdup(command);
+    proc->kill_grace_ms = PROCESS_DEFAULT_KILL_GRACE_MS;
 
 #ifdef _WIN32
     proc->hProcess = INVALID_HANDLE_VALUE;
@@ -1212,17 +2404,61 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
     proc->stderr_buffer = malloc(proc->stderr_buf_size);
     proc->stdout_buf_len = 0;
     proc->stderr_buf_len = 0;
+    proc->read_size = PROCESS_DEFAULT_READ_SIZE;
 
     // Parse options
+    ZymValue stdoutOpt = zym_newNull();
+    ZymValue stderrOpt = zym_newNull();
     if (!zym_isNull(optionsMap) && zym_isMap(optionsMap)) {
         ZymValue cwdVal = zym_mapGet(vm, optionsMap, "cwd");
         if (zym_isString(cwdVal)) {
             proc->cwd = strdup(zym_asCString(cwdVal));
         }
+
+        ZymValue graceVal = zym_mapGet(vm, optionsMap, "killGraceMs");
+        if (zym_isNumber(graceVal)) {
+            proc->kill_grace_ms = (long)zym_asNumber(graceVal);
+        }
+
+        ZymValue readSizeVal = zym_mapGet(vm, optionsMap, "readSize");
+        if (zym_isNumber(readSizeVal)) {
+            double size = zym_asNumber(readSizeVal);
+            if (size < 1) size = 1;
+            if (size > PROCESS_MAX_READ_SIZE) size = PROCESS_MAX_READ_SIZE;
+            proc->read_size = (size_t)size;
+        }
+
+        // A Buffer as stdout/stderr keeps the stream piped; wait() and
+        // ProcessExec append everything the child writes into it
+        stdoutOpt = zym_mapGet(vm, optionsMap, "stdout");
+        stderrOpt = zym_mapGet(vm, optionsMap, "stderr");
+        proc->stdout_sink = buffer_from_value(vm, stdoutOpt);
+        proc->stderr_sink = buffer_from_value(vm, stderrOpt);
+        if ((proc->stdout_sink && !buffer_check_writable(vm, proc->stdout_sink)) ||
+            (proc->stderr_sink && !buffer_check_writable(vm, proc->stderr_sink))) {
+            free(proc->command);
+            free(proc->cwd);
+            free(proc->stdout_buffer);
+            free(proc->stderr_buffer);
+            free(proc);
+            return ZYM_ERROR;
+        }
+    }
+
+    proc->read_buffer = malloc(proc->read_size + 1);
+    if (!proc->read_buffer) {
+        free(proc->command);
+        free(proc->cwd);
+        free(proc->stdout_buffer);
+        free(proc->stderr_buffer);
+        free(proc);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
     }
 
     // Spawn process
     bool success;
+    proc->started_ms = process_now_ms();
 #ifdef _WIN32
     success = spawn_process_windows(vm, proc, argsVal, optionsMap);
 #else
@@ -1236,7 +2472,13 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
 
         ZymValue errorStr = zym_newString(vm, "error");
         zym_pushRoot(vm, errorStr);
-        ZymValue messageStr = zym_newString(vm, "Failed to spawn process");
+        char message[256];
+        if (proc->spawn_errno != 0) {
+            snprintf(message, sizeof(message), "Failed to spawn process: %s", strerror(proc->spawn_errno));
+        } else {
+            snprintf(message, sizeof(message), "Failed to spawn process");
+        }
+        ZymValue messageStr = zym_newString(vm, message);
         zym_pushRoot(vm, messageStr);
 
         zym_mapSet(vm, errorObj, "error", messageStr);
@@ -1249,6 +2491,7 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
         free(proc->cwd);
         free(proc->stdout_buffer);
         free(proc->stderr_buffer);
+        free(proc->read_buffer);
         free(proc);
 
         return errorObj;
@@ -1278,6 +2521,7 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
     CREATE_METHOD_0(isRunning, process_isRunning);
     CREATE_METHOD_0(getPid, process_getPid);
     CREATE_METHOD_0(getExitCode, process_getExitCode);
+    CREATE_METHOD_0(getUsage, process_getUsage);
 
     #undef CREATE_METHOD_0
     #undef CREATE_METHOD_1
@@ -1298,9 +2542,14 @@ ZymValue nativeProcess_spawn(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, Z
     zym_mapSet(vm, obj, "isRunning", isRunning);
     zym_mapSet(vm, obj, "getPid", getPid);
     zym_mapSet(vm, obj, "getExitCode", getExitCode);
+    zym_mapSet(vm, obj, "getUsage", getUsage);
+
+    // Hold the sink Buffers for as long as the process object is reachable
+    if (proc->stdout_sink) zym_mapSet(vm, obj, "stdoutBuffer", stdoutOpt);
+    if (proc->stderr_sink) zym_mapSet(vm, obj, "stderrBuffer", stderrOpt);
 
-    // (context + 13 methods + obj = 15)
-    for (int i = 0; i < 15; i++) {
+    // (context + 14 methods + obj = 16)
+    for (int i = 0; i < 16; i++) {
         zym_popRoot(vm);
     }
 
@@ -1315,149 +2564,700 @@ ZymValue nativeProcess_spawn_2(ZymVM* vm, ZymValue commandVal, ZymValue argsVal)
     return nativeProcess_spawn(vm, commandVal, argsVal, zym_newNull());
 }
 
+static bool process_is_error_object(ZymVM* vm, ZymValue proc) {
+    // Spawn failures return a map with "error" but no methods
+    return zym_isMap(proc) && !zym_isNull(zym_mapGet(vm, proc, "error")) && zym_isNull(zym_mapGet(vm, proc, "wait"));
+}
+
+static void exec_parse_limits(ZymVM* vm, ZymValue optionsMap, long* timeout_ms, size_t* max_output) {
+    *timeout_ms = 0;
+    *max_output = 0;
+    if (!zym_isMap(optionsMap)) {
+        return;
+    }
+    ZymValue timeoutVal = zym_mapGet(vm, optionsMap, "timeoutMs");
+    if (zym_isNumber(timeoutVal) && zym_asNumber(timeoutVal) > 0) {
+        *timeout_ms = (long)zym_asNumber(timeoutVal);
+    }
+    ZymValue maxOutputVal = zym_mapGet(vm, optionsMap, "maxOutput");
+    if (zym_isNumber(maxOutputVal) && zym_asNumber(maxOutputVal) > 0) {
+        *max_output = (size_t)zym_asNumber(maxOutputVal);
+    }
+}
+
+static ZymValue exec_build_result(ZymVM* vm, ExecWaiter* waiter, double duration_ms) {
+    ProcessData* proc = waiter->proc;
+
+    ZymValue result = zym_newMap(vm);
+    zym_pushRoot(vm, result);
+
+    // Streams captured into a Buffer report an empty string here
+    ZymValue stdoutStr = zym_newString(vm, waiter->out.data ? waiter->out.data : "");
+    zym_pushRoot(vm, stdoutStr);
+    ZymValue stderrStr = zym_newString(vm, waiter->err.data ? waiter->err.data : "");
+    zym_pushRoot(vm, stderrStr);
+
+    zym_mapSet(vm, result, "stdout", stdoutStr);
+    zym_mapSet(vm, result, "stderr", stderrStr);
+    zym_mapSet(vm, result, "exitCode", proc->exit_code_valid ? zym_newNumber((double)proc->exit_code) : zym_newNull());
+    zym_mapSet(vm, result, "timedOut", zym_newBool(waiter->timed_out));
+    zym_mapSet(vm, result, "truncated", zym_newBool(waiter->out.truncated || waiter->err.truncated));
+    zym_mapSet(vm, result, "durationMs", zym_newNumber(duration_ms));
+
+    ZymValue usage = process_usage_map(vm, proc);
+    zym_mapSet(vm, result, "usage", usage);
+
+    zym_popRoot(vm);  // stderrStr
+    zym_popRoot(vm);  // stdoutStr
+    zym_popRoot(vm);  // result
+
+    return result;
+}
+
 ZymValue nativeProcess_exec(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, ZymValue optionsMap) {
+    double started = process_now_ms();
     ZymValue proc = nativeProcess_spawn(vm, commandVal, argsVal, optionsMap);
 
-    if (zym_isMap(proc)) {
-        ZymValue errorField = zym_mapGet(vm, proc, "error");
-        ZymValue waitField = zym_mapGet(vm, proc, "wait");
+    if (proc == ZYM_ERROR || process_is_error_object(vm, proc)) {
+        return proc;
+    }
+
+    zym_pushRoot(vm, proc);
+
+    long timeout_ms;
+    size_t max_output;
+    exec_parse_limits(vm, optionsMap, &timeout_ms, &max_output);
+
+    ZymValue context = zym_getClosureContext(zym_mapGet(vm, proc, "closeStdin"));
+    process_closeStdin(vm, context);
+
+    ExecWaiter waiter;
+    exec_waiter_init(vm, &waiter, (ProcessData*)zym_getNativeData(context), timeout_ms, max_output);
+    if (!exec_capture_ready(&waiter.out) || !exec_capture_ready(&waiter.err)) {
+        exec_waiter_free(&waiter);
+        zym_popRoot(vm);  // proc
+        zym_runtimeError(vm, "Out of memory while reading process output");
+        return ZYM_ERROR;
+    }
+
+#ifdef _WIN32
+    exec_waiter_run(&waiter);
+#else
+    while (!waiter.finished) {
+        exec_wait_step(&waiter, 1, -1);
+    }
+#endif
+
+    ZymValue result = exec_build_result(vm, &waiter, process_now_ms() - started);
+
+    exec_waiter_free(&waiter);
+    zym_popRoot(vm);  // proc
+
+    return result;
+}
+
+ZymValue nativeProcess_exec_1(ZymVM* vm, ZymValue commandVal) {
+    return nativeProcess_exec(vm, commandVal, zym_newNull(), zym_newNull());
+}
+
+ZymValue nativeProcess_exec_2(ZymVM* vm, ZymValue commandVal, ZymValue argsVal) {
+    return nativeProcess_exec(vm, commandVal, argsVal, zym_newNull());
+}
+
+// ---- ProcessExecMany ------------------------------------------------------------
+// Runs a batch of commands with at most `concurrency` children alive at once.
+// On Unix every running child's pipes and pidfd share one poll() loop
+// (exec_wait_step); on Windows each slot runs the blocking exec wait on a
+// worker thread and the VM thread sleeps until any slot completes.
+
+typedef struct {
+    int index;              // Position in the commands list, -1 when free
+    double started_ms;
+#ifdef _WIN32
+    ThreadHandle thread;
+    bool done;
+#endif
+} ExecSlot;
+
+#ifdef _WIN32
+typedef struct {
+    ExecWaiter* waiter;
+    ExecSlot* slot;
+    Mutex* lock;
+    CondVar* changed;
+} ExecSlotTask;
+
+static void exec_slot_thread(void* arg) {
+    ExecSlotTask* task = (ExecSlotTask*)arg;
+    exec_waiter_run(task->waiter);
+    mutex_lock(task->lock);
+    task->slot->done = true;
+    condvar_signal(task->changed);
+    mutex_unlock(task->lock);
+}
+#endif
+
+static ZymValue exec_many_error(ZymVM* vm, const char* message) {
+    ZymValue errorObj = zym_newMap(vm);
+    zym_pushRoot(vm, errorObj);
+    ZymValue messageStr = zym_newString(vm, message);
+    zym_pushRoot(vm, messageStr);
+    zym_mapSet(vm, errorObj, "error", messageStr);
+    zym_popRoot(vm);  // messageStr
+    zym_popRoot(vm);  // errorObj
+    return errorObj;
+}
+
+// A command is "cmd", ["cmd", arg...] or {command, args, cwd, stdin, ...}.
+static ZymValue exec_many_spawn(ZymVM* vm, ZymValue entry) {
+    if (zym_isString(entry)) {
+        return nativeProcess_spawn(vm, entry, zym_newNull(), zym_newNull());
+    }
 
-        // If has "error" field but no "wait" field, it's an error object
-        if (!zym_isNull(errorField) && zym_isNull(waitField)) {
-            // This is an error object, return it directly
-            return proc;
+    if (zym_isList(entry)) {
+        int length = zym_listLength(entry);
+        if (length == 0 || !zym_isString(zym_listGet(vm, entry, 0))) {
+            return exec_many_error(vm, "Command list must start with a command string");
+        }
+        ZymValue args = zym_newList(vm);
+        zym_pushRoot(vm, args);
+        for (int i = 1; i < length; i++) {
+            zym_listAppend(vm, args, zym_listGet(vm, entry, i));
         }
+        ZymValue proc = nativeProcess_spawn(vm, zym_listGet(vm, entry, 0), args, zym_newNull());
+        zym_popRoot(vm);  // args
+        return proc;
     }
 
-    zym_pushRoot(vm, proc);
+    if (zym_isMap(entry)) {
+        ZymValue commandVal = zym_mapGet(vm, entry, "command");
+        if (!zym_isString(commandVal)) {
+            return exec_many_error(vm, "Command map requires a 'command' string");
+        }
+        return nativeProcess_spawn(vm, commandVal, zym_mapGet(vm, entry, "args"), entry);
+    }
 
-    // Get context from the closures to call methods directly
-    ZymValue closeStdinClosure = zym_mapGet(vm, proc, "closeStdin");
-    ZymValue readClosure = zym_mapGet(vm, proc, "read");
-    ZymValue readErrClosure = zym_mapGet(vm, proc, "readErr");
-    ZymValue pollClosure = zym_mapGet(vm, proc, "poll");
-    ZymValue getExitCodeClosure = zym_mapGet(vm, proc, "getExitCode");
+    return exec_many_error(vm, "Commands must be strings, lists or maps");
+}
 
-    ZymValue context = zym_getClosureContext(closeStdinClosure);
+ZymValue nativeProcess_execMany(ZymVM* vm, ZymValue commandsVal, ZymValue optionsMap) {
+    if (!zym_isList(commandsVal)) {
+        zym_runtimeError(vm, "ProcessExecMany() requires a list of commands");
+        return ZYM_ERROR;
+    }
+    if (!zym_isNull(optionsMap) && !zym_isMap(optionsMap)) {
+        zym_runtimeError(vm, "ProcessExecMany() options must be a map");
+        return ZYM_ERROR;
+    }
 
-    process_closeStdin(vm, context);
+    int count = zym_listLength(commandsVal);
 
-    // Accumulate output
-    char* stdout_data = malloc(1);
-    char* stderr_data = malloc(1);
-    stdout_data[0] = '\0';
-    stderr_data[0] = '\0';
-    size_t stdout_len = 0;
-    size_t stderr_len = 0;
-    size_t stdout_cap = 1;
-    size_t stderr_cap = 1;
-
-    // Poll until process exits
-    bool process_exited = false;
-    while (true) {
-        ZymValue exitCodeVal = process_poll(vm, context);
-
-        // Try to read stdout
-        ZymValue stdoutChunk = process_read(vm, context);
-        if (zym_isString(stdoutChunk)) {
-            const char* chunk = zym_asCString(stdoutChunk);
-            size_t chunk_len = strlen(chunk);
-            if (chunk_len > 0) {
-                if (stdout_len + chunk_len + 1 > stdout_cap) {
-                    stdout_cap = (stdout_len + chunk_len + 1) * 2;
-                    char* new_data = realloc(stdout_data, stdout_cap);
-                    if (!new_data) {
-                        // Out of memory - free what we have and return error
-                        free(stdout_data);
-                        free(stderr_data);
-                        zym_popRoot(vm);  // proc
-                        zym_runtimeError(vm, "Out of memory while reading process output");
-                        return ZYM_ERROR;
-                    }
-                    stdout_data = new_data;
-                }
-                memcpy(stdout_data + stdout_len, chunk, chunk_len);
-                stdout_len += chunk_len;
-                stdout_data[stdout_len] = '\0';
-            }
+    int concurrency = 0;
+    if (zym_isMap(optionsMap)) {
+        ZymValue concurrencyVal = zym_mapGet(vm, optionsMap, "concurrency");
+        if (zym_isNumber(concurrencyVal)) {
+            concurrency = (int)zym_asNumber(concurrencyVal);
         }
+    }
+    if (concurrency <= 0) {
+        concurrency = thread_cpu_count();
+    }
+#ifdef _WIN32
+    // One exec thread per slot, plus its pipe readers
+    if (concurrency > 64) concurrency = 64;
+#endif
+    if (concurrency > count) {
+        concurrency = count > 0 ? count : 1;
+    }
 
-        // Try to read stderr
-        ZymValue stderrChunk = process_readErr(vm, context);
-        if (zym_isString(stderrChunk)) {
-            const char* chunk = zym_asCString(stderrChunk);
-            size_t chunk_len = strlen(chunk);
-            if (chunk_len > 0) {
-                if (stderr_len + chunk_len + 1 > stderr_cap) {
-                    stderr_cap = (stderr_len + chunk_len + 1) * 2;
-                    char* new_data = realloc(stderr_data, stderr_cap);
-                    if (!new_data) {
-                        // Out of memory - free what we have and return error
-                        free(stdout_data);
-                        free(stderr_data);
-                        zym_popRoot(vm);  // proc
-                        zym_runtimeError(vm, "Out of memory while reading process output");
-                        return ZYM_ERROR;
-                    }
-                    stderr_data = new_data;
-                }
-                memcpy(stderr_data + stderr_len, chunk, chunk_len);
-                stderr_len += chunk_len;
-                stderr_data[stderr_len] = '\0';
+    long timeout_ms;
+    size_t max_output;
+    exec_parse_limits(vm, optionsMap, &timeout_ms, &max_output);
+
+    // Results double as GC roots: a running command's slot holds its process
+    // object until the result map replaces it
+    ZymValue results = zym_newList(vm);
+    zym_pushRoot(vm, results);
+    for (int i = 0; i < count; i++) {
+        zym_listAppend(vm, results, zym_newNull());
+    }
+
+    ExecWaiter* waiters = calloc((size_t)concurrency, sizeof(ExecWaiter));
+    ExecSlot* slots = calloc((size_t)concurrency, sizeof(ExecSlot));
+    if (!waiters || !slots) {
+        free(waiters);
+        free(slots);
+        zym_popRoot(vm);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+    for (int s = 0; s < concurrency; s++) {
+        slots[s].index = -1;
+        waiters[s].finished = true;
+    }
+
+#ifdef _WIN32
+    ExecSlotTask* tasks = calloc((size_t)concurrency, sizeof(ExecSlotTask));
+    Mutex lock;
+    CondVar changed;
+    mutex_init(&lock);
+    condvar_init(&changed);
+#endif
+
+    int next = 0;
+    int active = 0;
+    bool failed = false;
+
+    while (!failed && (next < count || active > 0)) {
+        // Fill free slots
+        for (int s = 0; s < concurrency && next < count; s++) {
+            if (slots[s].index >= 0) continue;
+
+            int index = next++;
+            double started = process_now_ms();
+            ZymValue proc = exec_many_spawn(vm, zym_listGet(vm, commandsVal, index));
+            if (proc == ZYM_ERROR) {
+                failed = true;
+                break;
+            }
+            zym_listSet(vm, results, index, proc);
+            if (process_is_error_object(vm, proc)) {
+                s--;  // Slot is still free
+                continue;
             }
-        }
 
-        // Check if exited
-        if (!zym_isNull(exitCodeVal)) {
-            // Process exited - do one more read to capture remaining output
-            if (process_exited) {
+            ZymValue context = zym_getClosureContext(zym_mapGet(vm, proc, "closeStdin"));
+            process_closeStdin(vm, context);
+            exec_waiter_init(vm, &waiters[s], (ProcessData*)zym_getNativeData(context), timeout_ms, max_output);
+            if (!exec_capture_ready(&waiters[s].out) || !exec_capture_ready(&waiters[s].err)) {
+                exec_waiter_free(&waiters[s]);
+                waiters[s].finished = true;
+                zym_runtimeError(vm, "Out of memory while reading process output");
+                failed = true;
                 break;
             }
-            process_exited = true;
+            slots[s].index = index;
+            slots[s].started_ms = started;
+            active++;
+
+#ifdef _WIN32
+            tasks[s].waiter = &waiters[s];
+            tasks[s].slot = &slots[s];
+            tasks[s].lock = &lock;
+            tasks[s].changed = &changed;
+            slots[s].done = false;
+            if (!thread_start(&slots[s].thread, exec_slot_thread, &tasks[s])) {
+                // Run it inline rather than lose the command
+                exec_waiter_run(&waiters[s]);
+                slots[s].done = true;
+                slots[s].thread = NULL;
+            }
+#endif
+        }
+        if (failed || active == 0) {
+            continue;
+        }
+
+#ifdef _WIN32
+        mutex_lock(&lock);
+        bool any_done = false;
+        while (!any_done) {
+            for (int s = 0; s < concurrency; s++) {
+                if (slots[s].index >= 0 && slots[s].done) any_done = true;
+            }
+            if (!any_done) condvar_wait(&changed, &lock);
+        }
+        mutex_unlock(&lock);
+        for (int s = 0; s < concurrency; s++) {
+            if (slots[s].index >= 0 && slots[s].done && slots[s].thread) {
+                thread_join(slots[s].thread);
+                slots[s].thread = NULL;
+            }
         }
+#else
+        exec_wait_step(waiters, concurrency, -1);
+#endif
 
-        // Small delay to avoid busy-waiting (skip if already exited and doing final read)
-        if (!process_exited) {
+        // Collect finished commands
+        for (int s = 0; s < concurrency; s++) {
+            if (slots[s].index < 0) continue;
 #ifdef _WIN32
-            Sleep(10);
+            if (!slots[s].done) continue;
 #else
-            usleep(10000);
+            if (!waiters[s].finished) continue;
 #endif
+            ZymValue result = exec_build_result(vm, &waiters[s], process_now_ms() - slots[s].started_ms);
+            zym_listSet(vm, results, slots[s].index, result);
+            exec_waiter_free(&waiters[s]);
+            slots[s].index = -1;
+            active--;
         }
     }
 
-    ZymValue exitCodeVal = process_getExitCode(vm, context);
+    // On error, children still running are reaped by their process objects
+    for (int s = 0; s < concurrency; s++) {
+#ifdef _WIN32
+        if (slots[s].index >= 0 && slots[s].thread) {
+            thread_join(slots[s].thread);
+        }
+#endif
+        if (slots[s].index >= 0) {
+            exec_waiter_free(&waiters[s]);
+        }
+    }
 
-    ZymValue result = zym_newMap(vm);
-    zym_pushRoot(vm, result);
+#ifdef _WIN32
+    mutex_destroy(&lock);
+    condvar_destroy(&changed);
+    free(tasks);
+#endif
+    free(waiters);
+    free(slots);
 
-    ZymValue stdoutStr = zym_newString(vm, stdout_data);
-    zym_pushRoot(vm, stdoutStr);
-    ZymValue stderrStr = zym_newString(vm, stderr_data);
-    zym_pushRoot(vm, stderrStr);
+    zym_popRoot(vm);  // results
 
-    zym_mapSet(vm, result, "stdout", stdoutStr);
-    zym_mapSet(vm, result, "stderr", stderrStr);
-    zym_mapSet(vm, result, "exitCode", exitCodeVal);
+    return failed ? ZYM_ERROR : results;
+}
 
-    zym_popRoot(vm);  // stderrStr
-    zym_popRoot(vm);  // stdoutStr
-    zym_popRoot(vm);  // proc
+ZymValue nativeProcess_execMany_1(ZymVM* vm, ZymValue commandsVal) {
+    return nativeProcess_execMany(vm, commandsVal, zym_newNull());
+}
 
-    free(stdout_data);
-    free(stderr_data);
+// ---- ProcessPipeline --------------------------------------------------------------
+// Runs `a | b | c` without a shell. Adjacent stages are connected by pipes the
+// parent never reads, and stdinFile/stdoutFile are opened here and handed to
+// the first/last stage directly, so data moves at kernel speed. The only
+// parent-side copy is `tee: true` (stdoutFile plus captured stdout), which
+// goes through splice()/tee() where the platform has them.
 
-    zym_popRoot(vm);  // result
+#ifndef _WIN32
 
-    return result;
+typedef struct {
+    char** argv;
+    char* cwd;
+} PipelineStage;
+
+static void pipeline_stage_free(PipelineStage* stage) {
+    if (stage->argv) {
+        for (int i = 0; stage->argv[i]; i++) free(stage->argv[i]);
+        free(stage->argv);
+    }
+    free(stage->cwd);
 }
 
-ZymValue nativeProcess_exec_1(ZymVM* vm, ZymValue commandVal) {
-    return nativeProcess_exec(vm, commandVal, zym_newNull(), zym_newNull());
+static char** pipeline_argv(ZymVM* vm, ZymValue commandVal, ZymValue argsVal, int first_arg) {
+    int count = zym_isList(argsVal) ? zym_listLength(argsVal) : 0;
+    char** argv = calloc((size_t)(count - first_arg + 2 > 2 ? count - first_arg + 2 : 2), sizeof(char*));
+    if (!argv) return NULL;
+
+    int argc = 0;
+    argv[argc++] = strdup(zym_asCString(commandVal));
+    for (int i = first_arg; i < count; i++) {
+        ZymValue arg = zym_listGet(vm, argsVal, i);
+        if (zym_isString(arg)) {
+            argv[argc++] = strdup(zym_asCString(arg));
+        }
+    }
+    return argv;
 }
 
-ZymValue nativeProcess_exec_2(ZymVM* vm, ZymValue commandVal, ZymValue argsVal) {
-    return nativeProcess_exec(vm, commandVal, argsVal, zym_newNull());
+// Stages use the same shapes as ProcessExecMany commands.
+static const char* pipeline_parse_stage(ZymVM* vm, ZymValue entry, const char* default_cwd, PipelineStage* stage) {
+    memset(stage, 0, sizeof(PipelineStage));
+
+    if (zym_isString(entry)) {
+        stage->argv = pipeline_argv(vm, entry, zym_newNull(), 0);
+    } else if (zym_isList(entry)) {
+        if (zym_listLength(entry) == 0 || !zym_isString(zym_listGet(vm, entry, 0))) {
+            return "Pipeline stage list must start with a command string";
+        }
+        stage->argv = pipeline_argv(vm, zym_listGet(vm, entry, 0), entry, 1);
+    } else if (zym_isMap(entry)) {
+        ZymValue commandVal = zym_mapGet(vm, entry, "command");
+        if (!zym_isString(commandVal)) {
+            return "Pipeline stage map requires a 'command' string";
+        }
+        stage->argv = pipeline_argv(vm, commandVal, zym_mapGet(vm, entry, "args"), 0);
+        ZymValue cwdVal = zym_mapGet(vm, entry, "cwd");
+        if (zym_isString(cwdVal)) {
+            stage->cwd = strdup(zym_asCString(cwdVal));
+        }
+    } else {
+        return "Pipeline stages must be strings, lists or maps";
+    }
+
+    if (!stage->argv) {
+        return "Out of memory";
+    }
+    if (!stage->cwd && default_cwd) {
+        stage->cwd = strdup(default_cwd);
+    }
+    return NULL;
+}
+
+// Starts one stage on the given stdio fds (all O_CLOEXEC in the parent, so
+// no stage inherits another stage's pipe ends). Uses posix_spawn, falling
+// back to fork where a cwd cannot be expressed as a file action.
+static pid_t pipeline_spawn(PipelineStage* stage, int in_fd, int out_fd, int err_fd) {
+    pid_t pid = -1;
+    bool use_spawn = true;
+#ifndef PROCESS_HAVE_SPAWN_CHDIR
+    use_spawn = stage->cwd == NULL;
+#endif
+
+    if (use_spawn) {
+        posix_spawn_file_actions_t actions;
+        if (posix_spawn_file_actions_init(&actions) == 0) {
+            bool ok = posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO) == 0 &&
+                      posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO) == 0 &&
+                      (err_fd < 0 || posix_spawn_file_actions_adddup2(&actions, err_fd, STDERR_FILENO) == 0);
+#ifdef PROCESS_HAVE_SPAWN_CHDIR
+            if (ok && stage->cwd) {
+                ok = posix_spawn_file_actions_addchdir_np(&actions, stage->cwd) == 0;
+            }
+#endif
+            if (!ok || posix_spawnp(&pid, stage->argv[0], &actions, NULL, stage->argv, environ) != 0) {
+                pid = -1;
+            }
+            posix_spawn_file_actions_destroy(&actions);
+        }
+        if (pid > 0) {
+            return pid;
+        }
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        dup2(in_fd, STDIN_FILENO);
+        dup2(out_fd, STDOUT_FILENO);
+        if (err_fd >= 0) dup2(err_fd, STDERR_FILENO);
+        if (stage->cwd && chdir(stage->cwd) < 0) _exit(127);
+        execvp(stage->argv[0], stage->argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+static ProcessData* pipeline_process_new(pid_t pid) {
+    ProcessData* proc = calloc(1, sizeof(ProcessData));
+    if (!proc) return NULL;
+    proc->pid = pid;
+    proc->stdin_fd = -1;
+    proc->stdout_fd = -1;
+    proc->stderr_fd = -1;
+    proc->pty_master = -1;
+    proc->is_running = true;
+    proc->kill_grace_ms = PROCESS_DEFAULT_KILL_GRACE_MS;
+    proc->started_ms = process_now_ms();
+    return proc;
+}
+
+#endif
+
+ZymValue nativeProcess_pipeline(ZymVM* vm, ZymValue commandsVal, ZymValue optionsMap) {
+#ifdef _WIN32
+    zym_runtimeError(vm, "ProcessPipeline() is not supported on Windows");
+    return ZYM_ERROR;
+#else
+    if (!zym_isList(commandsVal) || zym_listLength(commandsVal) == 0) {
+        zym_runtimeError(vm, "ProcessPipeline() requires a non-empty list of commands");
+        return ZYM_ERROR;
+    }
+    if (!zym_isNull(optionsMap) && !zym_isMap(optionsMap)) {
+        zym_runtimeError(vm, "ProcessPipeline() options must be a map");
+        return ZYM_ERROR;
+    }
+
+    double started = process_now_ms();
+    int count = zym_listLength(commandsVal);
+
+    const char* stdin_path = NULL;
+    const char* stdout_path = NULL;
+    const char* default_cwd = NULL;
+    bool append = false;
+    bool tee_output = false;
+    StdioMode stderr_mode = STDIO_PIPE;
+    long timeout_ms;
+    size_t max_output;
+    exec_parse_limits(vm, optionsMap, &timeout_ms, &max_output);
+
+    if (zym_isMap(optionsMap)) {
+        ZymValue val = zym_mapGet(vm, optionsMap, "stdinFile");
+        if (zym_isString(val)) stdin_path = zym_asCString(val);
+        val = zym_mapGet(vm, optionsMap, "stdoutFile");
+        if (zym_isString(val)) stdout_path = zym_asCString(val);
+        val = zym_mapGet(vm, optionsMap, "cwd");
+        if (zym_isString(val)) default_cwd = zym_asCString(val);
+        val = zym_mapGet(vm, optionsMap, "append");
+        if (zym_isBool(val)) append = zym_asBool(val);
+        val = zym_mapGet(vm, optionsMap, "tee");
+        if (zym_isBool(val)) tee_output = zym_asBool(val);
+        val = zym_mapGet(vm, optionsMap, "stderr");
+        if (zym_isString(val)) {
+            if (strcmp(zym_asCString(val), "inherit") == 0) stderr_mode = STDIO_INHERIT;
+            else if (strcmp(zym_asCString(val), "null") == 0) stderr_mode = STDIO_NULL;
+        }
+    }
+
+    PipelineStage* stages = calloc((size_t)count, sizeof(PipelineStage));
+    ExecWaiter* waiters = calloc((size_t)count, sizeof(ExecWaiter));
+    if (!stages || !waiters) {
+        free(stages);
+        free(waiters);
+        zym_runtimeError(vm, "Out of memory");
+        return ZYM_ERROR;
+    }
+
+    const char* error = NULL;
+    for (int i = 0; i < count && !error; i++) {
+        error = pipeline_parse_stage(vm, zym_listGet(vm, commandsVal, i), default_cwd, &stages[i]);
+    }
+
+    int in_fd = -1, out_fd = -1, err_fd = -1;
+    int capture_fds[2] = {-1, -1};
+    int stderr_fds[2] = {-1, -1};
+    int spawned = 0;
+
+    if (!error) {
+        in_fd = open(stdin_path ? stdin_path : "/dev/null", O_RDONLY | O_CLOEXEC);
+        if (in_fd < 0) error = "Failed to open stdinFile";
+    }
+    if (!error && stdout_path) {
+        out_fd = open(stdout_path, O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+        if (out_fd < 0) error = "Failed to open stdoutFile";
+    }
+    if (!error && (!stdout_path || tee_output)) {
+        if (!process_pipe_cloexec(capture_fds)) error = "Failed to create pipe";
+    }
+    if (!error) {
+        if (stderr_mode == STDIO_PIPE) {
+            if (!process_pipe_cloexec(stderr_fds)) error = "Failed to create pipe";
+            err_fd = stderr_fds[1];
+        } else if (stderr_mode == STDIO_NULL) {
+            err_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        }
+    }
+
+    // Spawn left to right; each stage reads the previous stage's pipe
+    int prev_read = in_fd;
+    for (int i = 0; i < count && !error; i++) {
+        int stage_out;
+        int next_pipe[2] = {-1, -1};
+        if (i == count - 1) {
+            stage_out = capture_fds[1] >= 0 ? capture_fds[1] : out_fd;
+        } else {
+            if (!process_pipe_cloexec(next_pipe)) {
+                error = "Failed to create pipe";
+                break;
+            }
+            stage_out = next_pipe[1];
+        }
+
+        pid_t pid = pipeline_spawn(&stages[i], prev_read, stage_out, err_fd);
+
+        if (prev_read != in_fd) close(prev_read);
+        if (next_pipe[1] >= 0) close(next_pipe[1]);
+        prev_read = next_pipe[0];
+
+        if (pid < 0) {
+            error = "Failed to spawn process";
+            break;
+        }
+        ProcessData* proc = pipeline_process_new(pid);
+        if (!proc) {
+            error = "Out of memory";
+            break;
+        }
+        exec_waiter_init(vm, &waiters[i], proc, timeout_ms, max_output);
+        spawned++;
+    }
+    if (prev_read >= 0 && prev_read != in_fd) close(prev_read);
+
+    // The parent keeps only the read ends; the last stage owns the captures
+    if (in_fd >= 0) close(in_fd);
+    if (capture_fds[1] >= 0) close(capture_fds[1]);
+    if (stderr_fds[1] >= 0) close(stderr_fds[1]);
+    if (err_fd >= 0 && err_fd != stderr_fds[1]) close(err_fd);
+
+    if (spawned == count) {
+        ProcessData* last = waiters[count - 1].proc;
+        if (capture_fds[0] >= 0) {
+            last->stdout_fd = capture_fds[0];
+            last->stdout_open = true;
+            set_nonblocking(capture_fds[0]);
+            if (out_fd >= 0) {
+                exec_waiter_set_sink(&waiters[count - 1], out_fd, true);
+            }
+            capture_fds[0] = -1;
+        }
+        if (stderr_fds[0] >= 0) {
+            last->stderr_fd = stderr_fds[0];
+            last->stderr_open = true;
+            set_nonblocking(stderr_fds[0]);
+            stderr_fds[0] = -1;
+        }
+
+        int remaining = count;
+        while (remaining > 0) {
+            remaining -= exec_wait_step(waiters, count, -1);
+        }
+    }
+
+    if (capture_fds[0] >= 0) close(capture_fds[0]);
+    if (stderr_fds[0] >= 0) close(stderr_fds[0]);
+    if (out_fd >= 0) close(out_fd);
+
+    ZymValue result = ZYM_ERROR;
+    if (error) {
+        zym_runtimeError(vm, "ProcessPipeline(): %s", error);
+    } else {
+        ExecWaiter* last = &waiters[count - 1];
+        bool timed_out = false;
+        for (int i = 0; i < count; i++) {
+            timed_out = timed_out || waiters[i].timed_out;
+        }
+        last->timed_out = timed_out;
+
+        result = exec_build_result(vm, last, process_now_ms() - started);
+        zym_pushRoot(vm, result);
+
+        ZymValue exitCodes = zym_newList(vm);
+        zym_pushRoot(vm, exitCodes);
+        ZymValue usages = zym_newList(vm);
+        zym_pushRoot(vm, usages);
+        for (int i = 0; i < count; i++) {
+            ProcessData* proc = waiters[i].proc;
+            zym_listAppend(vm, exitCodes, proc->exit_code_valid ? zym_newNumber((double)proc->exit_code) : zym_newNull());
+            ZymValue usage = process_usage_map(vm, proc);
+            zym_pushRoot(vm, usage);
+            zym_listAppend(vm, usages, usage);
+            zym_popRoot(vm);  // usage
+        }
+        zym_mapSet(vm, result, "exitCodes", exitCodes);
+        zym_mapSet(vm, result, "usages", usages);
+        zym_popRoot(vm);  // usages
+        zym_popRoot(vm);  // exitCodes
+        zym_popRoot(vm);  // result
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (i < spawned) {
+            ProcessData* proc = waiters[i].proc;
+            exec_waiter_free(&waiters[i]);
+            // Only reached with live children when a later stage failed to start
+            process_cleanup(vm, proc);
+        }
+        pipeline_stage_free(&stages[i]);
+    }
+    free(stages);
+    free(waiters);
+
+    return result;
+#endif
+}
+
+ZymValue nativeProcess_pipeline_1(ZymVM* vm, ZymValue commandsVal) {
+    return nativeProcess_pipeline(vm, commandsVal, zym_newNull());
 }
 
 ZymValue nativeProcess_getCwd(ZymVM* vm) {
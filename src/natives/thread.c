@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <errno.h>
+#include "./thread.h"
+
+#ifndef _WIN32
+    #include <unistd.h>
+    #include <time.h>
+#endif
+
+typedef struct {
+    ThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_trampoline(LPVOID param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+
+bool thread_start(ThreadHandle* thread, ThreadFunc func, void* arg) {
+    ThreadStart* start = malloc(sizeof(ThreadStart));
+    if (!start) return false;
+    start->func = func;
+    start->arg = arg;
+
+    *thread = CreateThread(NULL, 0, thread_trampoline, start, 0, NULL);
+    if (*thread == NULL) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void thread_join(ThreadHandle thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void thread_detach(ThreadHandle thread) {
+    CloseHandle(thread);
+}
+
+int thread_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+void mutex_init(Mutex* mutex) { InitializeSRWLock(mutex); }
+void mutex_destroy(Mutex* mutex) { (void)mutex; }
+void mutex_lock(Mutex* mutex) { AcquireSRWLockExclusive(mutex); }
+void mutex_unlock(Mutex* mutex) { ReleaseSRWLockExclusive(mutex); }
+
+void condvar_init(CondVar* cond) { InitializeConditionVariable(cond); }
+void condvar_destroy(CondVar* cond) { (void)cond; }
+
+void condvar_wait(CondVar* cond, Mutex* mutex) {
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+bool condvar_wait_ms(CondVar* cond, Mutex* mutex, long timeout_ms) {
+    DWORD ms = timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms;
+    return SleepConditionVariableSRW(cond, mutex, ms, 0) != 0;
+}
+
+void condvar_signal(CondVar* cond) { WakeConditionVariable(cond); }
+void condvar_broadcast(CondVar* cond) { WakeAllConditionVariable(cond); }
+
+#else
+
+static void* thread_trampoline(void* param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return NULL;
+}
+
+bool thread_start(ThreadHandle* thread, ThreadFunc func, void* arg) {
+    ThreadStart* start = malloc(sizeof(ThreadStart));
+    if (!start) return false;
+    start->func = func;
+    start->arg = arg;
+
+    if (pthread_create(thread, NULL, thread_trampoline, start) != 0) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void thread_join(ThreadHandle thread) {
+    pthread_join(thread, NULL);
+}
+
+void thread_detach(ThreadHandle thread) {
+    pthread_detach(thread);
+}
+
+int thread_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+void mutex_init(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+void mutex_destroy(Mutex* mutex) { pthread_mutex_destroy(mutex); }
+void mutex_lock(Mutex* mutex) { pthread_mutex_lock(mutex); }
+void mutex_unlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+
+void condvar_init(CondVar* cond) { pthread_cond_init(cond, NULL); }
+void condvar_destroy(CondVar* cond) { pthread_cond_destroy(cond); }
+
+void condvar_wait(CondVar* cond, Mutex* mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+
+bool condvar_wait_ms(CondVar* cond, Mutex* mutex, long timeout_ms) {
+    if (timeout_ms < 0) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    return pthread_cond_timedwait(cond, mutex, &deadline) != ETIMEDOUT;
+}
+
+void condvar_signal(CondVar* cond) { pthread_cond_signal(cond); }
+void condvar_broadcast(CondVar* cond) { pthread_cond_broadcast(cond); }
+
+#endif
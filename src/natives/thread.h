@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    typedef HANDLE ThreadHandle;
+    typedef SRWLOCK Mutex;
+    typedef CONDITION_VARIABLE CondVar;
+    #define MUTEX_INITIALIZER SRWLOCK_INIT
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #include <pthread.h>
+    typedef pthread_t ThreadHandle;
+    typedef pthread_mutex_t Mutex;
+    typedef pthread_cond_t CondVar;
+    #define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+    #define THREAD_LOCAL _Thread_local
+#endif
+
+typedef void (*ThreadFunc)(void* arg);
+
+// Thin portable wrappers over pthreads / Win32 used by natives that do work
+// off the VM thread. None of these touch a ZymVM.
+bool thread_start(ThreadHandle* thread, ThreadFunc func, void* arg);
+void thread_join(ThreadHandle thread);
+// Lets the thread run to completion on its own; the handle is no longer usable
+void thread_detach(ThreadHandle thread);
+int thread_cpu_count(void);
+
+// Mutexes with static storage may use MUTEX_INITIALIZER instead of init
+void mutex_init(Mutex* mutex);
+void mutex_destroy(Mutex* mutex);
+void mutex_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+
+void condvar_init(CondVar* cond);
+void condvar_destroy(CondVar* cond);
+void condvar_wait(CondVar* cond, Mutex* mutex);
+// Returns false on timeout. A negative timeout waits forever.
+bool condvar_wait_ms(CondVar* cond, Mutex* mutex, long timeout_ms);
+void condvar_signal(CondVar* cond);
+void condvar_broadcast(CondVar* cond);
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <math.h>
 #include "../natives.h"
+#include "../buffer.h"
 
 typedef struct {
     uint64_t s[4];
@@ -309,15 +310,6 @@ ZymValue random_bytes(ZymVM* vm, ZymValue context, ZymValue countVal) {
     return result;
 }
 
-typedef struct {
-    uint8_t* data;
-    size_t capacity;
-    size_t length;
-    size_t position;
-    bool auto_grow;
-    int endianness;
-} BufferData;
-
 ZymValue random_bytesBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
     RandomState* state = (RandomState*)zym_getNativeData(context);
 
@@ -326,16 +318,12 @@ ZymValue random_bytesBuffer(ZymVM* vm, ZymValue context, ZymValue bufferVal) {
         return ZYM_ERROR;
     }
 
-    ZymValue getLength = zym_mapGet(vm, bufferVal, "getLength");
-    if (zym_isNull(getLength)) {
+    BufferData* buf = buffer_from_value(vm, bufferVal);
+    if (!buf) {
         zym_runtimeError(vm, "Argument is not a valid Buffer");
         return ZYM_ERROR;
     }
-
-    ZymValue bufferContext = zym_getClosureContext(getLength);
-    BufferData* buf = (BufferData*)zym_getNativeData(bufferContext);
-    if (!buf) {
-        zym_runtimeError(vm, "Failed to get buffer data");
+    if (!buffer_check_writable(vm, buf)) {
         return ZYM_ERROR;
     }
 
@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "run_many.h"
+#include "natives/thread.h"
+#include "zym/zym.h"
+
+void setupNatives(ZymVM* vm);
+
+// ---- Multi-script host ---------------------------------------------------------
+// Every program gets its own VM in this process. The VM preempts itself
+// after each instruction slice (ZYM_STATUS_YIELD); the scheduler gives each
+// program --slice of those per turn and then moves on, round-robin, so one
+// busy program cannot starve the rest. With -j N, N threads take turns from
+// one shared run queue. A VM is only ever driven by the thread that
+// dequeued it; the process-wide state behind the natives (reaper, stat
+// fallback, SIGCHLD handling) is safe to use from several VMs at once.
+
+typedef enum {
+    TASK_START,         // top-level code not started yet
+    TASK_TOP_LEVEL,     // top-level code running
+    TASK_CALL_MAIN,     // top-level done, main(argv) not started yet
+    TASK_MAIN,          // main(argv) running
+} TaskPhase;
+
+typedef struct RunTask {
+    const char* path;
+    ZymVM* vm;
+    ZymChunk* chunk;
+    TaskPhase phase;
+    bool failed;
+    struct RunTask* next;
+} RunTask;
+
+typedef struct {
+    RunTask* head;
+    RunTask* tail;
+    int remaining;      // tasks not finished yet, queued or being run
+    Mutex lock;
+    CondVar ready;
+
+    int slice;
+    int script_argc;
+    char** script_argv;
+} RunQueue;
+
+static char* run_many_read_file(const char* path, size_t* out_size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file \"%s\".\n", path);
+        return NULL;
+    }
+    fseek(file, 0L, SEEK_END);
+    size_t fileSize = ftell(file);
+    rewind(file);
+    char* buffer = (char*)malloc(fileSize > 0 ? fileSize : 1);
+    if (buffer == NULL) {
+        fprintf(stderr, "Error: Not enough memory to read \"%s\".\n", path);
+        fclose(file);
+        return NULL;
+    }
+    size_t bytesRead = fread(buffer, sizeof(char), fileSize, file);
+    fclose(file);
+    if (bytesRead < fileSize) {
+        fprintf(stderr, "Error: Could not read file \"%s\".\n", path);
+        free(buffer);
+        return NULL;
+    }
+    *out_size = fileSize;
+    return buffer;
+}
+
+static int run_many_has_extension(const char* path, const char* ext) {
+    size_t path_len = strlen(path);
+    size_t ext_len = strlen(ext);
+    if (path_len < ext_len) return 0;
+    return strcmp(path + path_len - ext_len, ext) == 0;
+}
+
+static bool task_load(RunTask* task, ZymAllocator* allocator) {
+    size_t bytecode_size = 0;
+    char* bytecode = run_many_read_file(task->path, &bytecode_size);
+    if (!bytecode) {
+        return false;
+    }
+    if (bytecode_size < 5 || memcmp(bytecode, "ZYM\0", 4) != 0) {
+        fprintf(stderr, "Error: Invalid bytecode file \"%s\" (bad magic header).\n", task->path);
+        free(bytecode);
+        return false;
+    }
+
+    task->vm = zym_newVM(allocator);
+    task->chunk = task->vm ? zym_newChunk(task->vm) : NULL;
+    if (!task->chunk) {
+        fprintf(stderr, "Error: Not enough memory to load \"%s\".\n", task->path);
+        free(bytecode);
+        return false;
+    }
+    setupNatives(task->vm);
+
+    ZymStatus status = zym_deserializeChunk(task->vm, task->chunk, bytecode, bytecode_size);
+    free(bytecode);
+    if (status != ZYM_STATUS_OK) {
+        fprintf(stderr, "Error: Failed to deserialize bytecode \"%s\".\n", task->path);
+        return false;
+    }
+    task->phase = TASK_START;
+    return true;
+}
+
+static void task_free(RunTask* task) {
+    if (task->vm) {
+        if (task->chunk) {
+            zym_freeChunk(task->vm, task->chunk);
+        }
+        zym_freeVM(task->vm);
+    }
+}
+
+static ZymStatus task_call_main(RunTask* task, int script_argc, char** script_argv) {
+    ZymValue argv_list = zym_newList(task->vm);
+    zym_listAppend(task->vm, argv_list, zym_newString(task->vm, task->path));
+    for (int i = 0; i < script_argc; i++) {
+        zym_listAppend(task->vm, argv_list, zym_newString(task->vm, script_argv[i]));
+    }
+    return zym_call(task->vm, "main", 1, argv_list);
+}
+
+// Runs one turn of at most `slice` VM slices. Returns true once the task
+// has finished, successfully or not.
+static bool task_step(RunTask* task, int slice, int script_argc, char** script_argv) {
+    for (int used = 0; used < slice; used++) {
+        ZymStatus status;
+        switch (task->phase) {
+            case TASK_START:
+                task->phase = TASK_TOP_LEVEL;
+                status = zym_runChunk(task->vm, task->chunk);
+                break;
+            case TASK_CALL_MAIN:
+                task->phase = TASK_MAIN;
+                status = task_call_main(task, script_argc, script_argv);
+                break;
+            default:
+                status = zym_resume(task->vm);
+                break;
+        }
+
+        if (status == ZYM_STATUS_YIELD) {
+            continue;
+        }
+        if (status != ZYM_STATUS_OK) {
+            fprintf(stderr, "Error: %s: %s\n", task->path,
+                    task->phase == TASK_MAIN ? "main(argv) function failed." : "Runtime error occurred.");
+            task->failed = true;
+            return true;
+        }
+        if (task->phase == TASK_TOP_LEVEL && zym_hasFunction(task->vm, "main", 1)) {
+            task->phase = TASK_CALL_MAIN;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+static void queue_push(RunQueue* queue, RunTask* task) {
+    task->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = task;
+    } else {
+        queue->head = task;
+    }
+    queue->tail = task;
+}
+
+static RunTask* queue_pop(RunQueue* queue) {
+    RunTask* task = queue->head;
+    if (task) {
+        queue->head = task->next;
+        if (!queue->head) {
+            queue->tail = NULL;
+        }
+    }
+    return task;
+}
+
+static void run_many_worker(void* arg) {
+    RunQueue* queue = (RunQueue*)arg;
+
+    mutex_lock(&queue->lock);
+    for (;;) {
+        RunTask* task = queue_pop(queue);
+        if (!task) {
+            if (queue->remaining == 0) {
+                break;
+            }
+            // Every unfinished task is being run by another thread
+            condvar_wait(&queue->ready, &queue->lock);
+            continue;
+        }
+        mutex_unlock(&queue->lock);
+
+        bool finished = task_step(task, queue->slice, queue->script_argc, queue->script_argv);
+
+        mutex_lock(&queue->lock);
+        if (finished) {
+            queue->remaining--;
+            if (queue->remaining == 0) {
+                condvar_broadcast(&queue->ready);
+            }
+        } else {
+            queue_push(queue, task);
+            condvar_signal(&queue->ready);
+        }
+    }
+    mutex_unlock(&queue->lock);
+}
+
+static bool parse_count(const char* flag, const char* text, int* out) {
+    char* end = NULL;
+    long value = strtol(text, &end, 10);
+    if (!end || *end != '\0' || value < 1 || value > 1000000) {
+        fprintf(stderr, "Error: %s requires a positive number.\n", flag);
+        return false;
+    }
+    *out = (int)value;
+    return true;
+}
+
+int run_many_main(int argc, char** argv, ZymAllocator* allocator) {
+    int slice = 1;
+    int jobs = 1;
+    int script_argc = 0;
+    char** script_argv = NULL;
+
+    RunTask* tasks = calloc(argc > 0 ? (size_t)argc : 1, sizeof(RunTask));
+    if (!tasks) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return 1;
+    }
+    int task_count = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            script_argc = argc - i - 1;
+            script_argv = &argv[i + 1];
+            break;
+        } else if (strcmp(argv[i], "--slice") == 0 || strcmp(argv[i], "-j") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a number.\n", argv[i]);
+                free(tasks);
+                return 1;
+            }
+            if (!parse_count(argv[i], argv[i + 1], strcmp(argv[i], "-j") == 0 ? &jobs : &slice)) {
+                free(tasks);
+                return 1;
+            }
+            i++;
+        } else if (run_many_has_extension(argv[i], ".zbc")) {
+            tasks[task_count++].path = argv[i];
+        } else {
+            fprintf(stderr, "Error: run-many takes precompiled .zbc files, got \"%s\".\n", argv[i]);
+            free(tasks);
+            return 1;
+        }
+    }
+
+    if (task_count == 0) {
+        fprintf(stderr, "Error: run-many requires at least one .zbc file.\n");
+        free(tasks);
+        return 1;
+    }
+
+    RunQueue queue = {0};
+    queue.slice = slice;
+    queue.script_argc = script_argc;
+    queue.script_argv = script_argv;
+    mutex_init(&queue.lock);
+    condvar_init(&queue.ready);
+
+    int exit_code = 0;
+    for (int i = 0; i < task_count; i++) {
+        if (task_load(&tasks[i], allocator)) {
+            queue_push(&queue, &tasks[i]);
+            queue.remaining++;
+        } else {
+            tasks[i].failed = true;
+            exit_code = 1;
+        }
+    }
+
+    if (jobs > queue.remaining) {
+        jobs = queue.remaining;
+    }
+
+    // The calling thread is always one of the workers
+    ThreadHandle* threads = jobs > 1 ? calloc((size_t)jobs - 1, sizeof(ThreadHandle)) : NULL;
+    int started = 0;
+    for (int i = 0; threads && i < jobs - 1; i++) {
+        if (!thread_start(&threads[i], run_many_worker, &queue)) {
+            break;
+        }
+        started++;
+    }
+    run_many_worker(&queue);
+    for (int i = 0; i < started; i++) {
+        thread_join(threads[i]);
+    }
+    free(threads);
+
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].failed) {
+            exit_code = 1;
+        }
+        task_free(&tasks[i]);
+    }
+    free(tasks);
+    mutex_destroy(&queue.lock);
+    condvar_destroy(&queue.ready);
+
+    return exit_code;
+}
@@ -0,0 +1,7 @@
+#ifndef RUN_MANY_H
+#define RUN_MANY_H
+#include "zym/zym.h"
+// zym run-many <a.zbc> <b.zbc> ... [--slice N] [-j N] [-- args...]
+// argv starts at the first argument after "run-many".
+int run_many_main(int argc, char** argv, ZymAllocator* allocator);
+#endif